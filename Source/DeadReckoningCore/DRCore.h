@@ -0,0 +1,18 @@
+#pragma once
+
+// Engine-independent dead reckoning core: math, kinematic state, scripted movers,
+// the projective velocity blending extrapolator, the snapshot interpolator, the
+// fixed-step accumulator, the time collectors and the capture/replay format.
+// Header-only and free of Unreal types so it can be built into standalone tools.
+
+#include "DRCoreMath.h"
+#include "DRCoreKinematicState.h"
+#include "DRCoreMotionPolicy.h"
+#include "DRCoreMover.h"
+#include "DRCoreMotionDescriptor.h"
+#include "DRCoreExtrapolator.h"
+#include "DRCoreInterpolator.h"
+#include "DRCoreFixedStep.h"
+#include "DRCoreReplication.h"
+#include "DRCoreCollectors.h"
+#include "DRCoreCapture.h"
@@ -0,0 +1,349 @@
+#pragma once
+#include "DRCoreCollectors.h"
+#include "DRCoreExtrapolator.h"
+#include "DRCoreReplication.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+// Capture format of the replicated kinematic stream and the offline replay of the
+// client dead reckoning over it. Servers write State and Truth records, clients write
+// Receive records, each end into its own append-only file.
+namespace DRCore
+{
+	namespace Capture
+	{
+		constexpr uint32_t Magic = 0x50435244; // "DRCP"
+		constexpr uint32_t Version = 1;
+
+		enum class ERecordType : uint32_t
+		{
+			State = 1, // Server state marked for replication
+			Truth = 2, // Simulated server position and velocity, sampled every server tick or at an interval
+			Receive = 3, // State received by a client, LocalTime is the receive time on the client clock
+		};
+
+		struct FFileHeader
+		{
+			uint32_t Magic = Capture::Magic;
+			uint32_t Version = Capture::Version;
+			uint32_t RecordSize = 0;
+			uint32_t Reserved = 0;
+		};
+
+		// Fixed size and 8-byte aligned after the header, so a mapped file is indexed in place.
+		// Velocity and acceleration are stored as float, positions keep double precision.
+		struct FRecord
+		{
+			uint32_t Type;
+			uint32_t EntityId;
+			double ServerTime;
+			double LocalTime; // Zero in server records
+			double Position[3];
+			float Velocity[3];
+			float Acceleration[3];
+		};
+		static_assert(sizeof(FFileHeader) == 16, "Capture header layout changed");
+		static_assert(sizeof(FRecord) == 72, "Capture record layout changed");
+
+		inline FFileHeader MakeHeader()
+		{
+			FFileHeader Header;
+			Header.RecordSize = sizeof(FRecord);
+			return Header;
+		}
+
+		inline FRecord MakeRecord(ERecordType InType, uint32_t InEntityId, double InServerTime, double InLocalTime, const FKinematicState& InState)
+		{
+			FRecord Record;
+			Record.Type = static_cast<uint32_t>(InType);
+			Record.EntityId = InEntityId;
+			Record.ServerTime = InServerTime;
+			Record.LocalTime = InLocalTime;
+			Record.Position[0] = InState.Position.X;
+			Record.Position[1] = InState.Position.Y;
+			Record.Position[2] = InState.Position.Z;
+			Record.Velocity[0] = static_cast<float>(InState.Velocity.X);
+			Record.Velocity[1] = static_cast<float>(InState.Velocity.Y);
+			Record.Velocity[2] = static_cast<float>(InState.Velocity.Z);
+			Record.Acceleration[0] = static_cast<float>(InState.Acceleration.X);
+			Record.Acceleration[1] = static_cast<float>(InState.Acceleration.Y);
+			Record.Acceleration[2] = static_cast<float>(InState.Acceleration.Z);
+			return Record;
+		}
+
+		inline FKinematicState ToState(const FRecord& InRecord)
+		{
+			return FKinematicState(
+				FVec3(InRecord.Position[0], InRecord.Position[1], InRecord.Position[2]),
+				FVec3(InRecord.Velocity[0], InRecord.Velocity[1], InRecord.Velocity[2]),
+				FVec3(InRecord.Acceleration[0], InRecord.Acceleration[1], InRecord.Acceleration[2]),
+				InRecord.ServerTime);
+		}
+
+		// Read-only view of a capture in memory, usually a mapped file.
+		// A truncated last record, e.g. from a crashed session, is ignored.
+		class FCaptureView
+		{
+		public:
+			FCaptureView() = default;
+			FCaptureView(const void* InData, size_t InSize)
+			{
+				if(InData == nullptr || InSize < sizeof(FFileHeader))
+					return;
+
+				FFileHeader Header;
+				std::memcpy(&Header, InData, sizeof(Header));
+				if(Header.Magic != Magic || Header.Version != Version || Header.RecordSize != sizeof(FRecord))
+					return;
+
+				Records_ = reinterpret_cast<const FRecord*>(static_cast<const unsigned char*>(InData) + sizeof(FFileHeader));
+				Num_ = (InSize - sizeof(FFileHeader)) / sizeof(FRecord);
+				bValid_ = true;
+			}
+
+			bool IsValid() const { return bValid_; }
+			size_t Num() const { return Num_; }
+			const FRecord& operator[](size_t InIndex) const { return Records_[InIndex]; }
+
+		private:
+			const FRecord* Records_ = nullptr;
+			size_t Num_ = 0;
+			bool bValid_ = false;
+		};
+
+		struct FReplaySettings
+		{
+			double ClientDt = 1.0 / 60.0; // Client frame time
+			float MaxBlendFactor = DefaultMaxBlendFactor;
+			double MaxSampleAge = 0.5; // Same clamp as ADRPawn::MaxSampleAge
+			double ResendTolerance = 0.0; // Above zero, sends are regenerated from the truth with the prediction-error policy
+			double Latency = 0.05; // Delay of sends without a receive time, the recorded median is used when there is a client capture
+		};
+
+		struct FReplayResult
+		{
+			long long Entities = 0;
+			long long Frames = 0;
+			long long Updates = 0;
+			long long ErrorSamples = 0;
+			double SumSquaredError = 0.0;
+			double MaxError = 0.0;
+			double Duration = 0.0; // Replayed session time
+
+			double GetRmsError() const { return ErrorSamples > 0 ? std::sqrt(SumSquaredError / ErrorSamples) : 0.0; }
+			double GetUpdatesPerSecond() const { return Duration > 0.0 && Entities > 0 ? Updates / (Duration * Entities) : 0.0; }
+		};
+
+		namespace Private
+		{
+			struct FTruthSample
+			{
+				double Time;
+				FVec3 Position;
+				FVec3 Velocity;
+			};
+
+			struct FArrival
+			{
+				double LocalTime;
+				int Entity;
+				FKinematicState State;
+			};
+
+			struct FReplayEntity
+			{
+				std::vector<FTruthSample> Truth;
+				size_t TruthCursor = 0;
+				FBlendingExtrapolator Extrapolator;
+				TTimeStampCollector<double> TimeStampCollector{ 1.0, 1.0 }; // Same window as the client pawn
+				double LastServerTime = -1.0;
+				bool bInitialized = false;
+
+				// Linear interpolation between truth samples, false outside the sampled range
+				bool GetTruth(double InTime, FVec3& OutPosition)
+				{
+					if(Truth.empty() || InTime < Truth.front().Time || InTime > Truth.back().Time)
+						return false;
+					while(TruthCursor + 1 < Truth.size() && Truth[TruthCursor + 1].Time < InTime)
+						++TruthCursor;
+					const FTruthSample& A = Truth[TruthCursor];
+					const FTruthSample& B = Truth[std::min(TruthCursor + 1, Truth.size() - 1)];
+					const double Span = B.Time - A.Time;
+					const double Alpha = Span > 0.0 ? (InTime - A.Time) / Span : 0.0;
+					OutPosition = A.Position + (B.Position - A.Position) * Alpha;
+					return true;
+				}
+			};
+		}
+
+		// Re-runs the client dead reckoning over a recorded session and scores it against the
+		// server truth. Arrivals come from the client capture when given, otherwise from the
+		// server's State records delayed by the latency. With a resend tolerance the server
+		// policy is re-simulated on the truth samples instead, to score threshold settings.
+		// Client frames are scored against the truth at LocalTime minus the smallest receive offset,
+		// the same estimate of server time the client's clock offset filter converges to.
+		inline FReplayResult Replay(const FCaptureView& InServer, const FCaptureView* InClient, const FReplaySettings& InSettings)
+		{
+			using namespace Private;
+
+			FReplayResult Result;
+			if(!InServer.IsValid())
+				return Result;
+
+			std::unordered_map<uint32_t, int> EntityIndex;
+			std::vector<FReplayEntity> Entities;
+			auto FindEntity = [&](uint32_t InId)
+			{
+				auto It = EntityIndex.find(InId);
+				if(It != EntityIndex.end())
+					return It->second;
+				const int Index = static_cast<int>(Entities.size());
+				EntityIndex.emplace(InId, Index);
+				Entities.emplace_back();
+				return Index;
+			};
+
+			std::vector<FArrival> Arrivals;
+			for(size_t i = 0; i < InServer.Num(); ++i)
+			{
+				const FRecord& Record = InServer[i];
+				const int Entity = FindEntity(Record.EntityId);
+				if(Record.Type == static_cast<uint32_t>(ERecordType::Truth))
+				{
+					const FKinematicState State = ToState(Record);
+					Entities[Entity].Truth.push_back(FTruthSample{ Record.ServerTime, State.Position, State.Velocity });
+				}
+			}
+
+			// Delay of regenerated sends. With a client capture it is the median receive time minus
+			// send time, which also carries the client clock offset, so arrivals stay on the client clock.
+			double Latency = InSettings.Latency;
+			const bool bHasClient = InClient != nullptr && InClient->IsValid() && InClient->Num() > 0;
+			if(bHasClient)
+			{
+				std::vector<double> Delays;
+				Delays.reserve(InClient->Num());
+				for(size_t i = 0; i < InClient->Num(); ++i)
+					Delays.push_back((*InClient)[i].LocalTime - (*InClient)[i].ServerTime);
+				std::nth_element(Delays.begin(), Delays.begin() + Delays.size() / 2, Delays.end());
+				Latency = Delays[Delays.size() / 2];
+			}
+
+			if(InSettings.ResendTolerance > 0.0)
+			{
+				for(int Entity = 0; Entity < static_cast<int>(Entities.size()); ++Entity)
+				{
+					const std::vector<FTruthSample>& Truth = Entities[Entity].Truth;
+					if(Truth.empty())
+						continue;
+
+					FShadowClient Shadow;
+					FKinematicState LastSent(Truth[0].Position, Truth[0].Velocity, FVec3::Zero(), Truth[0].Time);
+					Shadow.OnStateSent(LastSent, LastSent.Time);
+					Arrivals.push_back(FArrival{ LastSent.Time + Latency, Entity, LastSent });
+					for(size_t i = 1; i < Truth.size(); ++i)
+					{
+						const float Dt = static_cast<float>(Truth[i].Time - Truth[i - 1].Time);
+						if(Shadow.Step(Dt, LastSent, Truth[i].Position) > InSettings.ResendTolerance)
+						{
+							LastSent = FKinematicState(Truth[i].Position, Truth[i].Velocity, FVec3::Zero(), Truth[i].Time);
+							Shadow.OnStateSent(LastSent, LastSent.Time);
+							Arrivals.push_back(FArrival{ LastSent.Time + Latency, Entity, LastSent });
+						}
+					}
+				}
+			}
+			else if(bHasClient)
+			{
+				for(size_t i = 0; i < InClient->Num(); ++i)
+				{
+					const FRecord& Record = (*InClient)[i];
+					if(Record.Type == static_cast<uint32_t>(ERecordType::Receive))
+						Arrivals.push_back(FArrival{ Record.LocalTime, FindEntity(Record.EntityId), ToState(Record) });
+				}
+			}
+			else
+			{
+				for(size_t i = 0; i < InServer.Num(); ++i)
+				{
+					const FRecord& Record = InServer[i];
+					if(Record.Type == static_cast<uint32_t>(ERecordType::State))
+						Arrivals.push_back(FArrival{ Record.ServerTime + Latency, FindEntity(Record.EntityId), ToState(Record) });
+				}
+			}
+
+			if(Arrivals.empty())
+				return Result;
+
+			std::stable_sort(Arrivals.begin(), Arrivals.end(), [](const FArrival& A, const FArrival& B) { return A.LocalTime < B.LocalTime; });
+
+			double MinOffset = Arrivals.front().LocalTime - Arrivals.front().State.Time;
+			for(const FArrival& Arrival : Arrivals)
+				MinOffset = std::min(MinOffset, Arrival.LocalTime - Arrival.State.Time);
+
+			// Same handling as ADRPawn::OnRep_KinematicState and the per-frame blending
+			FClockOffsetEstimator ClockOffset;
+			size_t NextArrival = 0;
+			const double StartTime = Arrivals.front().LocalTime;
+			const double EndTime = Arrivals.back().LocalTime;
+			for(double LocalTime = StartTime; LocalTime <= EndTime; LocalTime += InSettings.ClientDt)
+			{
+				while(NextArrival < Arrivals.size() && Arrivals[NextArrival].LocalTime <= LocalTime)
+				{
+					const FArrival& Arrival = Arrivals[NextArrival++];
+					FReplayEntity& Entity = Entities[Arrival.Entity];
+					if(Arrival.State.Time <= Entity.LastServerTime)
+						continue;
+					Entity.LastServerTime = Arrival.State.Time;
+					++Result.Updates;
+
+					if(!Entity.bInitialized)
+					{
+						Entity.Extrapolator.Reset(Arrival.State);
+						Entity.Extrapolator.MaxBlendFactor = InSettings.MaxBlendFactor;
+						Entity.bInitialized = true;
+						++Result.Entities;
+					}
+
+					Entity.TimeStampCollector.Add(Arrival.State.Time);
+					float AverageServerUpdateTime = Entity.Extrapolator.AverageServerUpdateTime;
+					if(Entity.TimeStampCollector.IsValid())
+						AverageServerUpdateTime = static_cast<float>(Entity.TimeStampCollector.GetAverageDuration());
+
+					ClockOffset.AddSample(Arrival.LocalTime, Arrival.State.Time);
+					FKinematicState State = Arrival.State;
+					// The replayed server time is on the minimum offset, which already contains the fastest
+					// one-way delay, so there is no round trip to compensate here
+					State.Extrapolate(std::min(ClockOffset.GetLastSampleDelay(), InSettings.MaxSampleAge));
+					Entity.Extrapolator.SetServerState(State, AverageServerUpdateTime);
+				}
+
+				const double ServerTime = LocalTime - MinOffset;
+				for(FReplayEntity& Entity : Entities)
+				{
+					if(!Entity.bInitialized)
+						continue;
+
+					const FVec3& Predicted = Entity.Extrapolator.Step(static_cast<float>(InSettings.ClientDt));
+					FVec3 Truth;
+					if(Entity.GetTruth(ServerTime, Truth))
+					{
+						const double Error = FVec3::Distance(Predicted, Truth);
+						Result.SumSquaredError += Error * Error;
+						Result.MaxError = std::max(Result.MaxError, Error);
+						++Result.ErrorSamples;
+					}
+				}
+				++Result.Frames;
+			}
+			Result.Duration = EndTime - StartTime;
+			return Result;
+		}
+	}
+}
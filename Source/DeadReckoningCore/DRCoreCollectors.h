@@ -0,0 +1,547 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace DRCore
+{
+	// Samples kept by a collector unless a capacity is given, enough for 1s of updates at 100Hz
+	constexpr int DefaultCollectorCapacity = 128;
+
+	// FIFO over contiguous storage that is allocated once, when the buffer is constructed.
+	// Adding to a full buffer is a programming error, callers pop first. The capacity is at
+	// least 2, so a full buffer still has a First() after PopFront.
+	template<typename ElemType>
+	class TFixedRingBuffer
+	{
+	public:
+		template<typename BufferType, typename RefType>
+		class TIterator
+		{
+		public:
+			TIterator(BufferType& InBuffer, int InIndex): Buffer_(&InBuffer), Index_(InIndex) {}
+
+			RefType operator*() const { return (*Buffer_)[Index_]; }
+			auto* operator->() const { return &(*Buffer_)[Index_]; }
+			TIterator& operator++() { ++Index_; return *this; }
+			bool operator==(const TIterator& Other) const { return Index_ == Other.Index_; }
+			bool operator!=(const TIterator& Other) const { return Index_ != Other.Index_; }
+
+		private:
+			BufferType* Buffer_;
+			int Index_;
+		};
+
+		using FIterator = TIterator<TFixedRingBuffer, ElemType&>;
+		using FConstIterator = TIterator<const TFixedRingBuffer, const ElemType&>;
+
+		explicit TFixedRingBuffer(int InCapacity = 64): Storage_(InCapacity > 2 ? InCapacity : 2) {}
+
+		int Capacity() const { return static_cast<int>(Storage_.size()); }
+		size_t GetAllocatedSize() const { return Storage_.capacity() * sizeof(ElemType); }
+		int Num() const { return Num_; }
+		bool IsEmpty() const { return Num_ == 0; }
+		bool IsFull() const { return Num_ == Capacity(); }
+
+		void Add(const ElemType& InElem)
+		{
+			assert(!IsFull());
+			Storage_[Wrap(Head_ + Num_)] = InElem;
+			++Num_;
+		}
+
+		void PopFront()
+		{
+			assert(!IsEmpty());
+			Head_ = Wrap(Head_ + 1);
+			--Num_;
+		}
+
+		void PopBack()
+		{
+			assert(!IsEmpty());
+			--Num_;
+		}
+
+		void Clear()
+		{
+			Head_ = 0;
+			Num_ = 0;
+		}
+
+		// Index 0 is the oldest element
+		ElemType& operator[](int InIndex) { return Storage_[Wrap(Head_ + InIndex)]; }
+		const ElemType& operator[](int InIndex) const { return Storage_[Wrap(Head_ + InIndex)]; }
+
+		ElemType& First() { return (*this)[0]; }
+		const ElemType& First() const { return (*this)[0]; }
+		ElemType& Last(int InIndexFromEnd = 0) { return (*this)[Num_ - 1 - InIndexFromEnd]; }
+		const ElemType& Last(int InIndexFromEnd = 0) const { return (*this)[Num_ - 1 - InIndexFromEnd]; }
+
+		FIterator begin() { return FIterator(*this, 0); }
+		FIterator end() { return FIterator(*this, Num_); }
+		FConstIterator begin() const { return FConstIterator(*this, 0); }
+		FConstIterator end() const { return FConstIterator(*this, Num_); }
+
+	private:
+		int Wrap(int InIndex) const { return InIndex >= Capacity() ? InIndex - Capacity() : InIndex; }
+
+		std::vector<ElemType> Storage_;
+		int Head_ = 0;
+		int Num_ = 0;
+	};
+
+	// Min and max of a FIFO window in O(1) amortized, using two monotonic queues.
+	// Push/PopFront must mirror the pushes and pops of the window being tracked.
+	template<typename ValueType>
+	class TSlidingMinMax
+	{
+	private:
+		struct SEntry
+		{
+			uint64_t Seq_;
+			ValueType Value_;
+		};
+	public:
+
+		explicit TSlidingMinMax(int InCapacity = 64): MinQueue_(InCapacity), MaxQueue_(InCapacity) {}
+
+		void Push(ValueType InValue)
+		{
+			const uint64_t Seq = PushSeq_++;
+			while(!MinQueue_.IsEmpty() && !(MinQueue_.Last().Value_ < InValue))
+				MinQueue_.PopBack();
+			MinQueue_.Add(SEntry{ Seq, InValue });
+
+			while(!MaxQueue_.IsEmpty() && !(InValue < MaxQueue_.Last().Value_))
+				MaxQueue_.PopBack();
+			MaxQueue_.Add(SEntry{ Seq, InValue });
+		}
+
+		void PopFront()
+		{
+			if(!MinQueue_.IsEmpty() && MinQueue_.First().Seq_ == PopSeq_)
+				MinQueue_.PopFront();
+			if(!MaxQueue_.IsEmpty() && MaxQueue_.First().Seq_ == PopSeq_)
+				MaxQueue_.PopFront();
+			++PopSeq_;
+		}
+
+		bool IsEmpty() const { return MinQueue_.IsEmpty(); }
+		size_t GetAllocatedSize() const { return MinQueue_.GetAllocatedSize() + MaxQueue_.GetAllocatedSize(); }
+		ValueType GetMin() const { return MinQueue_.First().Value_; }
+		ValueType GetMax() const { return MaxQueue_.First().Value_; }
+
+		void Clear()
+		{
+			MinQueue_.Clear();
+			MaxQueue_.Clear();
+			PushSeq_ = 0;
+			PopSeq_ = 0;
+		}
+
+	private:
+		TFixedRingBuffer<SEntry> MinQueue_;
+		TFixedRingBuffer<SEntry> MaxQueue_;
+		uint64_t PushSeq_ = 0;
+		uint64_t PopSeq_ = 0;
+	};
+
+	// Streaming quantile with the P-square algorithm (Jain and Chlamtac, 1985): five markers
+	// track the minimum, the quantile, the maximum and two points in between, and are moved
+	// with piecewise-parabolic steps. Constant memory and time per sample, no allocations.
+	class FP2Quantile
+	{
+	public:
+		explicit FP2Quantile(double InQuantile = 0.5) { Reset(InQuantile); }
+
+		void Reset(double InQuantile)
+		{
+			Quantile_ = InQuantile < 0.0 ? 0.0 : (InQuantile > 1.0 ? 1.0 : InQuantile);
+			Reset();
+		}
+
+		void Reset() { Count_ = 0; }
+
+		void Add(double InValue)
+		{
+			if(Count_ < NumMarkers)
+			{
+				Heights_[Count_++] = InValue;
+				if(Count_ == NumMarkers)
+				{
+					std::sort(Heights_, Heights_ + NumMarkers);
+					const double Q = Quantile_;
+					const double Desired[NumMarkers] = { 1.0, 1.0 + 2.0 * Q, 1.0 + 4.0 * Q, 3.0 + 2.0 * Q, 5.0 };
+					const double Increments[NumMarkers] = { 0.0, Q * 0.5, Q, (1.0 + Q) * 0.5, 1.0 };
+					for(int i = 0; i < NumMarkers; ++i)
+					{
+						Positions_[i] = i + 1.0;
+						Desired_[i] = Desired[i];
+						Increments_[i] = Increments[i];
+					}
+				}
+				return;
+			}
+
+			// Cell of the new value, the extreme markers follow new minima and maxima
+			int Cell;
+			if(InValue < Heights_[0])
+			{
+				Heights_[0] = InValue;
+				Cell = 0;
+			}
+			else if(!(InValue < Heights_[NumMarkers - 1]))
+			{
+				Heights_[NumMarkers - 1] = InValue;
+				Cell = NumMarkers - 2;
+			}
+			else
+			{
+				Cell = 0;
+				while(!(InValue < Heights_[Cell + 1]))
+					++Cell;
+			}
+
+			for(int i = Cell + 1; i < NumMarkers; ++i)
+				Positions_[i] += 1.0;
+			for(int i = 0; i < NumMarkers; ++i)
+				Desired_[i] += Increments_[i];
+			++Count_;
+
+			for(int i = 1; i < NumMarkers - 1; ++i)
+			{
+				const double Offset = Desired_[i] - Positions_[i];
+				if((Offset >= 1.0 && Positions_[i + 1] - Positions_[i] > 1.0) || (Offset <= -1.0 && Positions_[i - 1] - Positions_[i] < -1.0))
+				{
+					const int Step = Offset >= 0.0 ? 1 : -1;
+					double Height = Parabolic(i, Step);
+					if(!(Heights_[i - 1] < Height && Height < Heights_[i + 1]))
+						Height = Heights_[i] + Step * (Heights_[i + Step] - Heights_[i]) / (Positions_[i + Step] - Positions_[i]);
+					Heights_[i] = Height;
+					Positions_[i] += Step;
+				}
+			}
+		}
+
+		// Nearest rank of the samples until there are enough for the markers
+		double Get() const
+		{
+			if(Count_ >= NumMarkers)
+				return Heights_[2];
+			if(Count_ == 0)
+				return 0.0;
+
+			double Sorted[NumMarkers];
+			std::copy(Heights_, Heights_ + Count_, Sorted);
+			std::sort(Sorted, Sorted + Count_);
+			return Sorted[static_cast<int>(Quantile_ * (Count_ - 1) + 0.5)];
+		}
+
+		double GetQuantile() const { return Quantile_; }
+		long long Num() const { return Count_; }
+
+	private:
+		static constexpr int NumMarkers = 5;
+
+		double Parabolic(int InIndex, int InStep) const
+		{
+			const double* N = Positions_;
+			const double* H = Heights_;
+			const int i = InIndex;
+			const double S = InStep;
+			return H[i] + S / (N[i + 1] - N[i - 1])
+				* ((N[i] - N[i - 1] + S) * (H[i + 1] - H[i]) / (N[i + 1] - N[i])
+				+ (N[i + 1] - N[i] - S) * (H[i] - H[i - 1]) / (N[i] - N[i - 1]));
+		}
+
+		double Quantile_ = 0.5;
+		long long Count_ = 0;
+		double Heights_[NumMarkers] = {};
+		double Positions_[NumMarkers] = {};
+		double Desired_[NumMarkers] = {};
+		double Increments_[NumMarkers] = {};
+	};
+
+	// Exponentially weighted moving mean and variance, InSmoothing is the weight of a new sample
+	class FEwma
+	{
+	public:
+		explicit FEwma(double InSmoothing = 0.1): Smoothing_(InSmoothing) {}
+
+		void Add(double InValue)
+		{
+			if(!bValid_)
+			{
+				Mean_ = InValue;
+				Variance_ = 0.0;
+				bValid_ = true;
+				return;
+			}
+
+			const double Diff = InValue - Mean_;
+			const double Increment = Smoothing_ * Diff;
+			Mean_ += Increment;
+			Variance_ = (1.0 - Smoothing_) * (Variance_ + Diff * Increment);
+		}
+
+		bool IsValid() const { return bValid_; }
+		double GetMean() const { return Mean_; }
+		double GetVariance() const { return Variance_; }
+		double GetStdDev() const { return std::sqrt(Variance_); }
+
+		void SetSmoothing(double InSmoothing) { Smoothing_ = InSmoothing; }
+		void Reset() { bValid_ = false; Mean_ = 0.0; Variance_ = 0.0; }
+
+	private:
+		double Smoothing_ = 0.1;
+		bool bValid_ = false;
+		double Mean_ = 0.0;
+		double Variance_ = 0.0;
+	};
+
+	// Which statistic of the update intervals normalizes the blend factor
+	enum class EIntervalEstimate
+	{
+		Mean, // Over the collector window
+		Ewma, // Exponentially weighted mean
+		Quantile, // Streaming quantile, see TTimeStampCollector::SetQuantile
+	};
+
+	// Intervals between time stamps over a sliding time window.
+	// A gap longer than the drop threshold restarts the window.
+	// Every interval also feeds a streaming quantile and an EWMA, which restart with the window.
+	template<typename TimeType>
+	class TTimeStampCollector
+	{
+	public:
+		struct SElem
+		{
+			TimeType Stamp_;
+			TimeType Duration_;
+		};
+
+		TTimeStampCollector(): Collection_(DefaultCollectorCapacity), MinMax_(DefaultCollectorCapacity) {}
+		TTimeStampCollector(TimeType InMaxTime, int InCapacity = DefaultCollectorCapacity)
+		: MaxTime_(InMaxTime), Collection_(InCapacity), MinMax_(InCapacity) {}
+		TTimeStampCollector(TimeType InMaxTime, TimeType InDropTimeThreshold, int InCapacity = DefaultCollectorCapacity)
+		: MaxTime_(InMaxTime), DropTimeThreshold_(InDropTimeThreshold), Collection_(InCapacity), MinMax_(InCapacity) {}
+
+		void Add(TimeType InTimeStamp)
+		{
+			if(Collection_.IsEmpty())
+			{
+				Push(SElem{ InTimeStamp, 0 });
+			}
+			else
+			{
+				TimeType Duration = InTimeStamp - Collection_.Last().Stamp_;
+				if(!IsNearlyZero(Duration))
+				{
+					if(Duration > DropTimeThreshold_)
+					{
+						Clear();
+						Push(SElem{ InTimeStamp, 0 });
+					}
+					else
+					{
+						if(Collection_.IsFull())
+							PopFront();
+						Push(SElem{ InTimeStamp, Duration});
+
+						FullDuration_ += Duration;
+						Quantile_.Add(Duration);
+						Ewma_.Add(Duration);
+
+						while(FullDuration_ > MaxTime_ && Collection_.Num() > 1)
+						{
+							PopFront();
+						}
+					}
+				}
+			}
+		}
+
+		bool IsValid() const { return Collection_.Num() > 1; }
+
+		TimeType GetFullTime() const
+		{
+			if(!IsValid())
+				return 0.;
+			return  FullDuration_;
+		}
+
+		TimeType GetLastDuration() const
+		{
+			return !IsValid() ? 0 : Collection_.Last().Duration_;
+		}
+
+		TimeType GetAverageDuration() const
+		{
+			return !IsValid() ? 0 : FullDuration_ / (Collection_.Num() - 1);
+		}
+
+		std::pair<TimeType, TimeType> GetMinMaxDuration() const
+		{
+			if(Collection_.IsEmpty())
+				return std::make_pair(TimeType(0), TimeType(0));
+
+			return std::make_pair(MinMax_.GetMin(), MinMax_.GetMax());
+		}
+
+		// Standard deviation of the intervals. Recomputed over the window in double, a running sum of
+		// squares that subtracts evicted intervals drifts in float and can go negative.
+		TimeType GetJitter() const
+		{
+			if(!IsValid())
+				return 0;
+			const int NumDurations = Collection_.Num() - 1;
+			double Sum = 0.0;
+			for(int i = 1; i <= NumDurations; ++i)
+				Sum += Collection_[i].Duration_;
+			const double Average = Sum / NumDurations;
+			double SumSquaredDeviations = 0.0;
+			for(int i = 1; i <= NumDurations; ++i)
+				SumSquaredDeviations += (Collection_[i].Duration_ - Average) * (Collection_[i].Duration_ - Average);
+			return static_cast<TimeType>(std::sqrt(SumSquaredDeviations / NumDurations));
+		}
+
+		// Streaming estimates over all intervals since the last restart, the window mean until there are any
+		TimeType GetQuantileDuration() const { return Quantile_.Num() > 0 ? static_cast<TimeType>(Quantile_.Get()) : GetAverageDuration(); }
+		TimeType GetEwmaDuration() const { return Ewma_.IsValid() ? static_cast<TimeType>(Ewma_.GetMean()) : GetAverageDuration(); }
+		TimeType GetEwmaJitter() const { return static_cast<TimeType>(Ewma_.GetStdDev()); }
+
+		TimeType GetDuration(EIntervalEstimate InEstimate) const
+		{
+			switch(InEstimate)
+			{
+			case EIntervalEstimate::Ewma: return GetEwmaDuration();
+			case EIntervalEstimate::Quantile: return GetQuantileDuration();
+			default: return GetAverageDuration();
+			}
+		}
+
+		// Both restart the estimate
+		void SetQuantile(double InQuantile) { Quantile_.Reset(InQuantile); }
+		void SetEwmaSmoothing(double InSmoothing) { Ewma_.SetSmoothing(InSmoothing); Ewma_.Reset(); }
+
+		void Clear()
+		{
+			FullDuration_ = 0;
+			Collection_.Clear();
+			MinMax_.Clear();
+			Quantile_.Reset();
+			Ewma_.Reset();
+		}
+
+		const TFixedRingBuffer<SElem>& GetCollection() const { return Collection_; }
+		size_t GetAllocatedSize() const { return Collection_.GetAllocatedSize() + MinMax_.GetAllocatedSize(); }
+
+	private:
+		static bool IsNearlyZero(TimeType InValue) { return std::abs(InValue) <= TimeType(1.e-8); }
+
+		void Push(const SElem& InElem)
+		{
+			Collection_.Add(InElem);
+			MinMax_.Push(InElem.Duration_);
+		}
+
+		void PopFront()
+		{
+			Collection_.PopFront();
+			MinMax_.PopFront();
+			FullDuration_ -= Collection_.First().Duration_;
+		}
+
+		TimeType MaxTime_ = 3;
+		TimeType DropTimeThreshold_ = 0.4f;
+		TFixedRingBuffer<SElem> Collection_;
+		TSlidingMinMax<TimeType> MinMax_; // Min/max of Duration_ over Collection_
+		TimeType FullDuration_ = 0;
+		FP2Quantile Quantile_{ 0.9 };
+		FEwma Ewma_;
+	};
+
+	// Filtered offset between a remote clock and the local monotonic clock.
+	// Every sample is local receive time minus remote send time, so it is the true
+	// offset plus the one-way delay. The minimum over a sliding window removes the
+	// queuing jitter and an exponential filter smooths the remaining steps.
+	class FClockOffsetEstimator
+	{
+	public:
+		FClockOffsetEstimator(): SampleTimes_(DefaultCollectorCapacity), MinMax_(DefaultCollectorCapacity) {}
+		FClockOffsetEstimator(double InWindowTime, double InSmoothing, int InCapacity = DefaultCollectorCapacity)
+		: WindowTime_(InWindowTime), Smoothing_(InSmoothing), SampleTimes_(InCapacity), MinMax_(InCapacity) {}
+
+		void AddSample(double InLocalTime, double InRemoteTime)
+		{
+			while(!SampleTimes_.IsEmpty() && (SampleTimes_.IsFull() || InLocalTime - SampleTimes_.First() > WindowTime_))
+			{
+				SampleTimes_.PopFront();
+				MinMax_.PopFront();
+			}
+
+			const double Sample = InLocalTime - InRemoteTime;
+			SampleTimes_.Add(InLocalTime);
+			MinMax_.Push(Sample);
+
+			const double WindowMin = MinMax_.GetMin();
+			if(!bValid_)
+			{
+				Offset_ = WindowMin;
+				bValid_ = true;
+			}
+			else
+			{
+				Offset_ += (WindowMin - Offset_) * Smoothing_;
+			}
+			LastSample_ = Sample;
+			DelayEwma_.Add(GetLastSampleDelay());
+		}
+
+		bool IsValid() const { return bValid_; }
+
+		// Local time minus remote time, including the smallest one-way delay seen in the window
+		double GetOffset() const { return Offset_; }
+
+		// How much later than the best case the last sample arrived
+		double GetLastSampleDelay() const { return bValid_ && LastSample_ > Offset_ ? LastSample_ - Offset_ : 0.0; }
+
+		// Average of the last sample delays, the jitter of the one-way delay
+		double GetAverageSampleDelay() const { return DelayEwma_.GetMean(); }
+
+		// Age of the last sample at the current remote time. The offset hides the fastest one-way
+		// delay, taken as half of InRoundTripTime less the average delay above it. Without a round
+		// trip only the delay above the fastest sample is covered.
+		double GetLastSampleAge(double InRoundTripTime) const
+		{
+			const double FastestOneWayDelay = InRoundTripTime * 0.5 - GetAverageSampleDelay();
+			return GetLastSampleDelay() + (FastestOneWayDelay > 0.0 ? FastestOneWayDelay : 0.0);
+		}
+
+		double ToLocalTime(double InRemoteTime) const { return InRemoteTime + Offset_; }
+
+		void Clear()
+		{
+			SampleTimes_.Clear();
+			MinMax_.Clear();
+			bValid_ = false;
+			Offset_ = 0;
+			LastSample_ = 0;
+			DelayEwma_.Reset();
+		}
+
+	private:
+		double WindowTime_ = 2.0;
+		double Smoothing_ = 0.1;
+		TFixedRingBuffer<double> SampleTimes_;
+		TSlidingMinMax<double> MinMax_; // Min over the offset samples in the window
+		bool bValid_ = false;
+		double Offset_ = 0;
+		double LastSample_ = 0;
+		FEwma DelayEwma_{ 0.05 };
+	};
+}
@@ -0,0 +1,197 @@
+#pragma once
+#include "DRCoreKinematicState.h"
+
+namespace DRCore
+{
+	// Largest blend factor, lets the client overshoot slightly towards the server state
+	constexpr float DefaultMaxBlendFactor = 1.2f;
+
+	// Normalized time since the last server state, DeadReckon_T_Hat on the pawn
+	inline float ComputeBlendFactor(float InTimeSinceUpdate, float InAverageUpdateTime, float InMaxBlendFactor = DefaultMaxBlendFactor)
+	{
+		const float T_Hat = InAverageUpdateTime > 0.0f ? InTimeSinceUpdate / InAverageUpdateTime : InMaxBlendFactor;
+		return T_Hat > InMaxBlendFactor ? InMaxBlendFactor : T_Hat;
+	}
+
+	// One projective velocity blending step. Both the client prediction and the last
+	// server state are projected by In_DeltaTime, then the client is pulled towards the
+	// server projection by the blend factor. Client acceleration follows the server one.
+	// Templated on the vector type so FVector arrays can use it without conversion.
+	template<typename VectorType>
+	inline void ProjectiveVelocityBlend(VectorType& InOut_ClientPosition, VectorType& InOut_ClientVelocity,
+		VectorType& InOut_ServerPosition, VectorType& InOut_ServerVelocity, const VectorType& InServerAcceleration,
+		double In_BlendFactor, double In_DeltaTime)
+	{
+		const double HalfDt2 = In_DeltaTime * In_DeltaTime * 0.5;
+		const VectorType P1 = InOut_ClientPosition + InOut_ClientVelocity * In_DeltaTime + InServerAcceleration * HalfDt2;
+		const VectorType P2 = InOut_ServerPosition + InOut_ServerVelocity * In_DeltaTime + InServerAcceleration * HalfDt2;
+
+		InOut_ClientPosition = P1 + (P2 - P1) * In_BlendFactor;
+
+		InOut_ServerPosition = P2;
+		InOut_ServerVelocity += InServerAcceleration * In_DeltaTime;
+
+		const VectorType BlendVelocity = InOut_ClientVelocity + InServerAcceleration * In_DeltaTime;
+		InOut_ClientVelocity = BlendVelocity + (InOut_ServerVelocity - BlendVelocity) * In_BlendFactor;
+	}
+
+	// ProjectiveVelocityBlend without the acceleration terms. Only for entities far enough away
+	// that the curvature over one update is not visible, the server projection goes straight too.
+	template<typename VectorType>
+	inline void LinearVelocityBlend(VectorType& InOut_ClientPosition, VectorType& InOut_ClientVelocity,
+		VectorType& InOut_ServerPosition, const VectorType& InServerVelocity, double In_BlendFactor, double In_DeltaTime)
+	{
+		const VectorType P1 = InOut_ClientPosition + InOut_ClientVelocity * In_DeltaTime;
+		const VectorType P2 = InOut_ServerPosition + InServerVelocity * In_DeltaTime;
+
+		InOut_ClientPosition = P1 + (P2 - P1) * In_BlendFactor;
+		InOut_ServerPosition = P2;
+		InOut_ClientVelocity = InOut_ClientVelocity + (InServerVelocity - InOut_ClientVelocity) * In_BlendFactor;
+	}
+
+	// Client extrapolation fidelity of an entity, from the most to the least expensive
+	enum class EExtrapolationTier : unsigned char
+	{
+		Full, // ProjectiveVelocityBlend every step
+		ReducedRate, // ProjectiveVelocityBlend over several steps at once
+		Linear, // LinearVelocityBlend over several steps at once
+	};
+
+	// Picks the tier of an entity from its distance to the viewer and whether it can be seen
+	struct FExtrapolationTierSettings
+	{
+		double ReducedRateDistance = 5000.0;
+		double LinearDistance = 15000.0;
+		int StepInterval = 4; // Steps advanced at once by the reduced tiers
+		bool bReduceHidden = true; // Hidden entities are at least in the reduced rate tier
+		double Hysteresis = 0.1; // Fraction of a distance an entity has to be back inside before it is promoted
+
+		int GetStepInterval(EExtrapolationTier InTier) const
+		{
+			return InTier == EExtrapolationTier::Full || StepInterval < 1 ? 1 : StepInterval;
+		}
+
+		EExtrapolationTier Classify(double InDistance, bool bInVisible, EExtrapolationTier InCurrent) const
+		{
+			// Demoted at the distance, promoted only inside it, so entities near it do not flip every update
+			const auto Exceeds = [&](double InThreshold, EExtrapolationTier InTier)
+			{
+				return InDistance > (InCurrent >= InTier ? InThreshold * (1.0 - Hysteresis) : InThreshold);
+			};
+
+			if(Exceeds(LinearDistance, EExtrapolationTier::Linear))
+				return EExtrapolationTier::Linear;
+			if(Exceeds(ReducedRateDistance, EExtrapolationTier::ReducedRate) || (bReduceHidden && !bInVisible))
+				return EExtrapolationTier::ReducedRate;
+			return EExtrapolationTier::Full;
+		}
+	};
+
+	// Client-side dead reckoning of one entity
+	struct FBlendingExtrapolator
+	{
+		FKinematicState Client; // Client's predicted state
+		FKinematicState Server; // Last server state, projected to the current time
+		float DeadReckon_T = 0.0f; // Time since the last server state
+		float AverageServerUpdateTime = 0.01f;
+		float MaxBlendFactor = DefaultMaxBlendFactor;
+
+		void Reset(const FKinematicState& InState)
+		{
+			Client = InState;
+			Server = InState;
+			DeadReckon_T = 0.0f;
+		}
+
+		void SetServerState(const FKinematicState& InServerState, float InAverageServerUpdateTime)
+		{
+			Server = InServerState;
+			AverageServerUpdateTime = InAverageServerUpdateTime;
+			DeadReckon_T = 0.0f;
+		}
+
+		// Returns the new client position
+		const FVec3& Step(float In_DeltaTime)
+		{
+			DeadReckon_T += In_DeltaTime;
+			const float T_Hat = ComputeBlendFactor(DeadReckon_T, AverageServerUpdateTime, MaxBlendFactor);
+			Client.Acceleration = Server.Acceleration;
+			ProjectiveVelocityBlend(Client.Position, Client.Velocity, Server.Position, Server.Velocity, Server.Acceleration, T_Hat, In_DeltaTime);
+			Client.Time += In_DeltaTime;
+			Server.Time += In_DeltaTime;
+			return Client.Position;
+		}
+	};
+
+	// FBlendingExtrapolator on float32 offsets from a double origin. The blend runs in float,
+	// positions are widened only when read. The origin moves to a new grid cell once the
+	// client drifts more than InRebaseDistance away from it, so precision does not depend
+	// on how far the entity is from the world origin. A rebase distance of zero keeps
+	// absolute float positions, which is only exact near the world origin.
+	struct FRebasedBlendingExtrapolator
+	{
+		FVec3 Origin;
+		FVec3f ClientPosition;
+		FVec3f ClientVelocity;
+		FVec3f ServerPosition;
+		FVec3f ServerVelocity;
+		FVec3f ServerAcceleration;
+		float DeadReckon_T = 0.0f;
+		float AverageServerUpdateTime = 0.01f;
+		float MaxBlendFactor = DefaultMaxBlendFactor;
+		double RebaseDistance = DefaultRebaseDistance;
+
+		void Reset(const FKinematicState& InState)
+		{
+			Origin = ComputeRebaseOrigin(InState.Position, RebaseDistance);
+			ClientPosition = FVec3f::FromOffset(InState.Position, Origin);
+			ClientVelocity = FVec3f::FromVector(InState.Velocity);
+			SetServerState(InState, AverageServerUpdateTime);
+		}
+
+		// A state out of range of the origin moves it to the state's cell before it is narrowed
+		void SetServerState(const FKinematicState& InServerState, float InAverageServerUpdateTime)
+		{
+			if(RebaseDistance > 0.0 && (InServerState.Position - Origin).SizeSquared() > RebaseDistance * RebaseDistance)
+				RebaseTo(InServerState.Position);
+			ServerPosition = FVec3f::FromOffset(InServerState.Position, Origin);
+			ServerVelocity = FVec3f::FromVector(InServerState.Velocity);
+			ServerAcceleration = FVec3f::FromVector(InServerState.Acceleration);
+			AverageServerUpdateTime = InAverageServerUpdateTime;
+			DeadReckon_T = 0.0f;
+		}
+
+		// Returns the new client position
+		FVec3 Step(float In_DeltaTime)
+		{
+			DeadReckon_T += In_DeltaTime;
+			const float T_Hat = ComputeBlendFactor(DeadReckon_T, AverageServerUpdateTime, MaxBlendFactor);
+			ProjectiveVelocityBlend(ClientPosition, ClientVelocity, ServerPosition, ServerVelocity, ServerAcceleration, T_Hat, In_DeltaTime);
+			RebaseIfNeeded();
+			return GetClientPosition();
+		}
+
+		FVec3 GetClientPosition() const { return ClientPosition.ToPosition(Origin); }
+		FVec3 GetServerPosition() const { return ServerPosition.ToPosition(Origin); }
+
+		// Moves both positions to the origin of the cell the client is in, computed in double
+		void RebaseIfNeeded()
+		{
+			const double MaxOffsetSquared = RebaseDistance * RebaseDistance;
+			if(RebaseDistance <= 0.0 || (ClientPosition.SizeSquared() <= MaxOffsetSquared && ServerPosition.SizeSquared() <= MaxOffsetSquared))
+				return;
+
+			RebaseTo(GetClientPosition());
+		}
+
+		// Moves both positions to the origin of the cell InPosition is in
+		void RebaseTo(const FVec3& InPosition)
+		{
+			const FVec3 ClientWorld = GetClientPosition();
+			const FVec3 ServerWorld = GetServerPosition();
+			Origin = ComputeRebaseOrigin(InPosition, RebaseDistance);
+			ClientPosition = FVec3f::FromOffset(ClientWorld, Origin);
+			ServerPosition = FVec3f::FromOffset(ServerWorld, Origin);
+		}
+	};
+}
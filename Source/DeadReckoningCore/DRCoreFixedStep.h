@@ -0,0 +1,61 @@
+#pragma once
+
+namespace DRCore
+{
+	constexpr double DefaultFixedStepTime = 1.0 / 60.0;
+	constexpr int DefaultMaxSubsteps = 8;
+
+	// Turns variable frame times into a whole number of fixed simulation steps.
+	// The time left over is carried to the next frame and exposed as an interpolation
+	// alpha between the last two steps. A frame runs at most InMaxSubsteps steps, time beyond
+	// that stays in the remainder and is worked off over the following frames, so the simulated
+	// time catches up with the frame time instead of falling behind it for good after a hitch.
+	// A step time of zero passes every frame through as a single step of its own length.
+	class FFixedStepAccumulator
+	{
+	public:
+		explicit FFixedStepAccumulator(double InStepTime = DefaultFixedStepTime, int InMaxSubsteps = DefaultMaxSubsteps)
+		{
+			Configure(InStepTime, InMaxSubsteps);
+		}
+
+		void Configure(double InStepTime, int InMaxSubsteps)
+		{
+			StepTime_ = InStepTime > 0.0 ? InStepTime : 0.0;
+			MaxSubsteps_ = InMaxSubsteps > 1 ? InMaxSubsteps : 1;
+			Remainder_ = 0.0;
+			VariableStepTime_ = 0.0;
+		}
+
+		// Number of GetStepTime() steps to run for a frame of InDeltaTime seconds
+		int Advance(double InDeltaTime)
+		{
+			if(StepTime_ <= 0.0)
+			{
+				VariableStepTime_ = InDeltaTime;
+				return 1;
+			}
+
+			Remainder_ += InDeltaTime;
+			int NumSteps = static_cast<int>(Remainder_ / StepTime_);
+			NumSteps = NumSteps < MaxSubsteps_ ? NumSteps : MaxSubsteps_;
+			Remainder_ -= NumSteps * StepTime_;
+			return NumSteps;
+		}
+
+		bool IsFixed() const { return StepTime_ > 0.0; }
+		double GetStepTime() const { return IsFixed() ? StepTime_ : VariableStepTime_; }
+		// Frame time not simulated yet, the last step ended this long before the frame time
+		double GetRemainder() const { return Remainder_; }
+		// Blend from the state before the last step (0) to the state after it (1), the last step while catching up
+		double GetAlpha() const { return IsFixed() ? (Remainder_ < StepTime_ ? Remainder_ / StepTime_ : 1.0) : 1.0; }
+		// Whole steps held back by the substep cap, run by later frames
+		double GetBacklogTime() const { return IsFixed() && Remainder_ > StepTime_ ? Remainder_ - StepTime_ : 0.0; }
+
+	private:
+		double StepTime_ = DefaultFixedStepTime;
+		int MaxSubsteps_ = DefaultMaxSubsteps;
+		double Remainder_ = 0.0;
+		double VariableStepTime_ = 0.0;
+	};
+}
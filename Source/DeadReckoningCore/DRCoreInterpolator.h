@@ -0,0 +1,104 @@
+#pragma once
+#include "DRCoreCollectors.h"
+#include "DRCoreKinematicState.h"
+
+namespace DRCore
+{
+	// Snapshots kept by an interpolator unless a capacity is given
+	constexpr int DefaultSnapshotCapacity = 32;
+
+	// Cubic Hermite between two states, InAlpha in [0, 1] over InDuration seconds.
+	// The curve matches both positions and both velocities at its ends.
+	inline void HermiteInterpolate(const FKinematicState& InFrom, const FKinematicState& InTo, double InDuration, double InAlpha,
+		FVec3& OutPosition, FVec3& OutVelocity)
+	{
+		const double S = InAlpha;
+		const double S2 = S * S;
+		const double S3 = S2 * S;
+
+		const double H00 = 2.0 * S3 - 3.0 * S2 + 1.0;
+		const double H10 = S3 - 2.0 * S2 + S;
+		const double H01 = -2.0 * S3 + 3.0 * S2;
+		const double H11 = S3 - S2;
+		OutPosition = InFrom.Position * H00 + InFrom.Velocity * (H10 * InDuration) + InTo.Position * H01 + InTo.Velocity * (H11 * InDuration);
+
+		const double DH00 = 6.0 * S2 - 6.0 * S;
+		const double DH10 = 3.0 * S2 - 4.0 * S + 1.0;
+		const double DH01 = -DH00;
+		const double DH11 = 3.0 * S2 - 2.0 * S;
+		OutVelocity = (InFrom.Position * DH00 + InTo.Position * DH01) / InDuration + InFrom.Velocity * DH10 + InTo.Velocity * DH11;
+	}
+
+	// Render delay that keeps the next snapshot in the buffer most of the time:
+	// one average send interval plus a multiple of the arrival jitter
+	inline double ComputeInterpolationDelay(double InAverageInterval, double InJitter, double InJitterMultiplier, double InMinDelay, double InMaxDelay)
+	{
+		const double Delay = InAverageInterval + InJitter * InJitterMultiplier;
+		return Delay < InMinDelay ? InMinDelay : (Delay > InMaxDelay ? InMaxDelay : Delay);
+	}
+
+	// Time-ordered buffer of received server states, sampled at a delayed render time.
+	// Storage is allocated once, when the interpolator is constructed.
+	class FSnapshotInterpolator
+	{
+	public:
+		explicit FSnapshotInterpolator(int InCapacity = DefaultSnapshotCapacity): Snapshots_(InCapacity) {}
+
+		// Out of order and duplicate snapshots are dropped, returns false for them
+		bool AddSnapshot(const FKinematicState& InState)
+		{
+			if(!Snapshots_.IsEmpty() && !(InState.Time > Snapshots_.Last().Time))
+				return false;
+
+			if(Snapshots_.IsFull())
+				Snapshots_.PopFront();
+			Snapshots_.Add(InState);
+			return true;
+		}
+
+		// Position and velocity at server time InRenderTime. Before the first snapshot the
+		// first one is held, past the last one it is extrapolated by at most InMaxExtrapolation.
+		// Snapshots no longer needed for later render times are released.
+		bool Sample(double InRenderTime, double InMaxExtrapolation, FVec3& OutPosition, FVec3& OutVelocity)
+		{
+			if(Snapshots_.IsEmpty())
+				return false;
+
+			// Keep the newest snapshot at or before the render time as the segment start
+			while(Snapshots_.Num() > 1 && !(Snapshots_[1].Time > InRenderTime))
+				Snapshots_.PopFront();
+
+			const FKinematicState& From = Snapshots_.First();
+			if(InRenderTime <= From.Time)
+			{
+				OutPosition = From.Position;
+				OutVelocity = From.Velocity;
+				return true;
+			}
+
+			if(Snapshots_.Num() == 1)
+			{
+				FKinematicState Extrapolated = From;
+				const double Time = InRenderTime - From.Time;
+				Extrapolated.Extrapolate(Time < InMaxExtrapolation ? Time : InMaxExtrapolation);
+				OutPosition = Extrapolated.Position;
+				OutVelocity = Extrapolated.Velocity;
+				return true;
+			}
+
+			const FKinematicState& To = Snapshots_[1];
+			const double Duration = To.Time - From.Time;
+			HermiteInterpolate(From, To, Duration, (InRenderTime - From.Time) / Duration, OutPosition, OutVelocity);
+			return true;
+		}
+
+		int Num() const { return Snapshots_.Num(); }
+		bool IsEmpty() const { return Snapshots_.IsEmpty(); }
+		void Clear() { Snapshots_.Clear(); }
+
+		const TFixedRingBuffer<FKinematicState>& GetSnapshots() const { return Snapshots_; }
+
+	private:
+		TFixedRingBuffer<FKinematicState> Snapshots_;
+	};
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include "DRCoreMath.h"
+
+namespace DRCore
+{
+	// State of motion (position, velocity, acceleration) sampled at server time Time
+	struct FKinematicState
+	{
+		FVec3 Position;
+		FVec3 Velocity;
+		FVec3 Acceleration;
+		double Time = 0.0;
+
+		FKinematicState() = default;
+		FKinematicState(const FVec3& InPosition, const FVec3& InVelocity, const FVec3& InAcceleration, double InTime = 0.0)
+		: Position(InPosition), Velocity(InVelocity), Acceleration(InAcceleration), Time(InTime) {}
+
+		// Advance the state by InTime seconds assuming constant acceleration
+		void Extrapolate(double InTime)
+		{
+			Position += Velocity * InTime + Acceleration * (InTime * InTime * 0.5);
+			Velocity += Acceleration * InTime;
+			Time += InTime;
+		}
+	};
+}
@@ -0,0 +1,133 @@
+#pragma once
+#include <cmath>
+
+// Minimal vector math for the engine-independent dead reckoning core.
+// Mirrors the FVector/FRotator operations the Unreal side relies on.
+namespace DRCore
+{
+	constexpr double SmallNumber = 1.e-8;
+	constexpr double Pi = 3.1415926535897932384626433832795;
+
+	inline double DegreesToRadians(double InDegrees) { return InDegrees * (Pi / 180.0); }
+
+	struct FVec3
+	{
+		double X = 0.0;
+		double Y = 0.0;
+		double Z = 0.0;
+
+		FVec3() = default;
+		constexpr FVec3(double InX, double InY, double InZ): X(InX), Y(InY), Z(InZ) {}
+
+		static constexpr FVec3 Zero() { return FVec3(0.0, 0.0, 0.0); }
+		static constexpr FVec3 Forward() { return FVec3(1.0, 0.0, 0.0); }
+		static constexpr FVec3 Up() { return FVec3(0.0, 0.0, 1.0); }
+
+		FVec3 operator+(const FVec3& V) const { return FVec3(X + V.X, Y + V.Y, Z + V.Z); }
+		FVec3 operator-(const FVec3& V) const { return FVec3(X - V.X, Y - V.Y, Z - V.Z); }
+		FVec3 operator*(double Scale) const { return FVec3(X * Scale, Y * Scale, Z * Scale); }
+		FVec3 operator/(double Scale) const { return FVec3(X / Scale, Y / Scale, Z / Scale); }
+		FVec3& operator+=(const FVec3& V) { X += V.X; Y += V.Y; Z += V.Z; return *this; }
+		FVec3& operator-=(const FVec3& V) { X -= V.X; Y -= V.Y; Z -= V.Z; return *this; }
+		FVec3& operator*=(double Scale) { X *= Scale; Y *= Scale; Z *= Scale; return *this; }
+		friend FVec3 operator*(double Scale, const FVec3& V) { return V * Scale; }
+
+		double Dot(const FVec3& V) const { return X * V.X + Y * V.Y + Z * V.Z; }
+		FVec3 Cross(const FVec3& V) const { return FVec3(Y * V.Z - Z * V.Y, Z * V.X - X * V.Z, X * V.Y - Y * V.X); }
+		double SizeSquared() const { return Dot(*this); }
+		double Size() const { return std::sqrt(SizeSquared()); }
+
+		// Leaves the vector unchanged when it is too small, like FVector::Normalize
+		bool Normalize(double Tolerance = SmallNumber)
+		{
+			const double SquareSum = SizeSquared();
+			if(SquareSum > Tolerance)
+			{
+				*this *= 1.0 / std::sqrt(SquareSum);
+				return true;
+			}
+			return false;
+		}
+
+		FVec3 GetSafeNormal(double Tolerance = SmallNumber) const
+		{
+			FVec3 Result = *this;
+			return Result.Normalize(Tolerance) ? Result : Zero();
+		}
+
+		static double Distance(const FVec3& A, const FVec3& B) { return (A - B).Size(); }
+	};
+
+	// Single precision vector for hot per-entity data, stored relative to a double origin (see FRebasedBlendingExtrapolator).
+	// Scales are applied in float so kernels on it stay float throughout.
+	struct FVec3f
+	{
+		float X = 0.0f;
+		float Y = 0.0f;
+		float Z = 0.0f;
+
+		FVec3f() = default;
+		constexpr FVec3f(float InX, float InY, float InZ): X(InX), Y(InY), Z(InZ) {}
+
+		FVec3f operator+(const FVec3f& V) const { return FVec3f(X + V.X, Y + V.Y, Z + V.Z); }
+		FVec3f operator-(const FVec3f& V) const { return FVec3f(X - V.X, Y - V.Y, Z - V.Z); }
+		template<typename ScaleType>
+		FVec3f operator*(ScaleType Scale) const { const float S = static_cast<float>(Scale); return FVec3f(X * S, Y * S, Z * S); }
+		FVec3f& operator+=(const FVec3f& V) { X += V.X; Y += V.Y; Z += V.Z; return *this; }
+		FVec3f& operator-=(const FVec3f& V) { X -= V.X; Y -= V.Y; Z -= V.Z; return *this; }
+
+		float SizeSquared() const { return X * X + Y * Y + Z * Z; }
+
+		// Narrowing and widening, offsets are taken from and added to a double origin
+		static FVec3f FromOffset(const FVec3& InPosition, const FVec3& InOrigin)
+		{
+			return FVec3f(static_cast<float>(InPosition.X - InOrigin.X), static_cast<float>(InPosition.Y - InOrigin.Y), static_cast<float>(InPosition.Z - InOrigin.Z));
+		}
+		static FVec3f FromVector(const FVec3& InVector)
+		{
+			return FVec3f(static_cast<float>(InVector.X), static_cast<float>(InVector.Y), static_cast<float>(InVector.Z));
+		}
+		FVec3 ToVector() const { return FVec3(X, Y, Z); }
+		FVec3 ToPosition(const FVec3& InOrigin) const { return FVec3(InOrigin.X + X, InOrigin.Y + Y, InOrigin.Z + Z); }
+	};
+
+	// Offsets from a rebased origin stay below this, where float32 steps are finer than 0.002 units
+	constexpr double DefaultRebaseDistance = 16384.0;
+
+	// Origin for float offsets around InPosition: the nearest corner of a grid of InCellSize,
+	// so nearby entities share origins. A cell size of zero keeps the world origin.
+	inline FVec3 ComputeRebaseOrigin(const FVec3& InPosition, double InCellSize = DefaultRebaseDistance)
+	{
+		if(InCellSize <= 0.0)
+			return FVec3::Zero();
+		return FVec3(std::floor(InPosition.X / InCellSize + 0.5) * InCellSize,
+			std::floor(InPosition.Y / InCellSize + 0.5) * InCellSize,
+			std::floor(InPosition.Z / InCellSize + 0.5) * InCellSize);
+	}
+
+	// Euler rotation in degrees, same convention as FRotator
+	struct FRotator3
+	{
+		double Pitch = 0.0;
+		double Yaw = 0.0;
+		double Roll = 0.0;
+
+		FRotator3() = default;
+		constexpr FRotator3(double InPitch, double InYaw, double InRoll): Pitch(InPitch), Yaw(InYaw), Roll(InRoll) {}
+
+		FRotator3 operator*(double Scale) const { return FRotator3(Pitch * Scale, Yaw * Scale, Roll * Scale); }
+
+		// Same rotation matrix as FRotationMatrix
+		FVec3 RotateVector(const FVec3& V) const
+		{
+			const double SP = std::sin(DegreesToRadians(Pitch)), CP = std::cos(DegreesToRadians(Pitch));
+			const double SY = std::sin(DegreesToRadians(Yaw)), CY = std::cos(DegreesToRadians(Yaw));
+			const double SR = std::sin(DegreesToRadians(Roll)), CR = std::cos(DegreesToRadians(Roll));
+
+			const FVec3 AxisX(CP * CY, CP * SY, SP);
+			const FVec3 AxisY(SR * SP * CY - CR * SY, SR * SP * SY + CR * CY, -SR * CP);
+			const FVec3 AxisZ(-(CR * SP * CY + SR * SY), CY * SR - CR * SP * SY, CR * CP);
+			return AxisX * V.X + AxisY * V.Y + AxisZ * V.Z;
+		}
+	};
+}
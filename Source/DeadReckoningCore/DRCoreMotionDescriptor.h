@@ -0,0 +1,82 @@
+#pragma once
+#include <cstddef>
+#include <variant>
+#include "DRCoreMover.h"
+
+namespace DRCore
+{
+	// Compact description of a deterministic scripted motion. Clients evaluate the
+	// position in closed form at any server time instead of receiving samples.
+	// Evaluation and description dispatch to the motion policy, so a new policy needs
+	// no changes here.
+	struct FMotionDescriptor
+	{
+		FMotionVariant Motion; // Only the parameters are used
+		double StartTime = 0.0; // Server time of the start of the motion
+
+		static FMotionDescriptor FromMover(const FMover& InMover, double InStartTime)
+		{
+			FMotionDescriptor Descriptor;
+			Descriptor.Motion = InMover.Motion;
+			Descriptor.StartTime = InStartTime - InMover.Phase * InMover.GetPeriod(); // The path was entered Phase of a period earlier
+			return Descriptor;
+		}
+
+		// The policy of InDescription.Type, the default motion if no policy has that type
+		static FMotionDescriptor FromDescription(const FMotionDescription& InDescription, double InStartTime)
+		{
+			FMotionDescriptor Descriptor;
+			Descriptor.EmplaceDescribed(InDescription);
+			Descriptor.StartTime = InStartTime;
+			return Descriptor;
+		}
+
+		FMotionDescription Describe() const
+		{
+			FMotionDescription Description;
+			std::visit([&Description](const auto& InMotion)
+			{
+				using FPolicy = typename std::decay_t<decltype(InMotion)>::FPolicy;
+				Description.Type = FPolicy::Type;
+				FPolicy::Describe(InMotion.Params, Description);
+			}, Motion);
+			return Description;
+		}
+
+		const char* GetName() const
+		{
+			return std::visit([](const auto& InMotion) { return std::decay_t<decltype(InMotion)>::FPolicy::Name; }, Motion);
+		}
+
+		const char* GetValueName(int InIndex) const
+		{
+			return std::visit([InIndex](const auto& InMotion) { return std::decay_t<decltype(InMotion)>::FPolicy::ValueNames[InIndex]; }, Motion);
+		}
+
+		// Position at server time InTime, optionally the velocity as well
+		FVec3 Evaluate(double InTime, FVec3* OutVelocity = nullptr) const
+		{
+			const double T = InTime - StartTime;
+			return std::visit([T, OutVelocity](const auto& InMotion)
+			{
+				return std::decay_t<decltype(InMotion)>::FPolicy::Evaluate(InMotion.Params, T, OutVelocity);
+			}, Motion);
+		}
+
+	private:
+		template<std::size_t Index = 0>
+		void EmplaceDescribed(const FMotionDescription& InDescription)
+		{
+			if constexpr(Index < std::variant_size_v<FMotionVariant>)
+			{
+				using FPolicy = typename std::variant_alternative_t<Index, FMotionVariant>::FPolicy;
+				if(FPolicy::Type != InDescription.Type)
+				{
+					EmplaceDescribed<Index + 1>(InDescription);
+					return;
+				}
+				Motion.template emplace<Index>().Params = FPolicy::FromDescription(InDescription);
+			}
+		}
+	};
+}
@@ -0,0 +1,295 @@
+#pragma once
+#include <cmath>
+#include "DRCoreMath.h"
+#include "DRCoreReplication.h"
+
+namespace DRCore
+{
+	// Scripted motion types, also the wire tag of FMotionDescriptor
+	enum class EMotionType : unsigned char
+	{
+		Circle,
+		Square,
+	};
+
+	// Parameters of the scripted motion, filled from ADRWorldSettings on the Unreal side
+	struct FMotionSettings
+	{
+		EMotionType MotionType = EMotionType::Circle;
+		float Radius = 300.0f;
+		FRotator3 AngularSpeed = FRotator3(0.0, 90.0, 0.0); // Degrees per second
+		float SideLength = 300.0f;
+		float Speed = 200.0f;
+		float ReplicationTime = 0.5f;
+		EReplicationPolicy ReplicationPolicy = EReplicationPolicy::Distance;
+		float ReplicationErrorTolerance = 20.0f; // Used by EReplicationPolicy::PredictionError
+	};
+
+	// Parameters of a policy in the form FMotionDescriptor replicates: where the path is placed
+	// and up to MaxValues scalars, whose meaning is given by the policy's ValueNames
+	struct FMotionDescription
+	{
+		static constexpr int MaxValues = 2;
+
+		EMotionType Type = EMotionType::Circle;
+		FVec3 Origin;
+		float Values[MaxValues] = {};
+	};
+
+	// Motion policies. Each one is a stateless type with
+	//   static constexpr EMotionType Type;
+	//   struct FParams;  immutable parameters, resolved once by MakeParams
+	//   struct FState;   what changes from step to step
+	//   static FParams MakeParams(const FMotionSettings&, const FVec3& InCenter);  InCenter is the center of the path
+	//   static FVec3 Start(const FParams&, FState&);  initial location
+	//   static FVec3 StartAtPhase(const FParams&, double InPhase, FState&);  InPhase in [0, 1)
+	//   static double GetPeriod(const FParams&);
+	//   static float GetReplicationDistance(const FParams&, float InReplicationTime);
+	//   static void Move(const FParams&, FState&, float In_DeltaTime, FVec3& InOut_Location, FVec3& Out_Velocity);
+	//   static double GetSentDistance(const FParams&, const FVec3& InLocation, const FVec3& InLastSentPosition);
+	//   static FVec3 Evaluate(const FParams&, double InTime, FVec3* Out_Velocity);  closed form, InTime since the start of the path
+	//   static constexpr const char* Name;  static constexpr const char* ValueNames[FMotionDescription::MaxValues];
+	//   static void Describe(const FParams&, FMotionDescription& Out_Description);
+	//   static FParams FromDescription(const FMotionDescription&);
+	// FMover instantiates its step loop once per policy, so the kernels inline and the
+	// per-step path has no motion type branches. FMotionDescriptor dispatches to the last four.
+
+	// Circle around the up axis
+	struct FCircleMotion
+	{
+		static constexpr EMotionType Type = EMotionType::Circle;
+
+		struct FParams
+		{
+			FVec3 Center;
+			float Radius = 0.0f;
+			FRotator3 AngularSpeed; // Degrees per second
+			float TangentialSpeed = 0.0f; // Radius times the yaw rate in radians
+		};
+
+		struct FState
+		{
+			FVec3 Direction = FVec3::Forward(); // From the center to the location
+		};
+
+		static FParams MakeParams(const FMotionSettings& InSettings, const FVec3& InCenter)
+		{
+			FParams Params;
+			Params.Center = InCenter;
+			Params.Radius = InSettings.Radius;
+			Params.AngularSpeed = InSettings.AngularSpeed;
+			Params.TangentialSpeed = static_cast<float>(DegreesToRadians(Params.AngularSpeed.Yaw) * Params.Radius);
+			return Params;
+		}
+
+		// Starts at the center and joins the circle with the first step
+		static FVec3 Start(const FParams& InParams, FState& Out_State)
+		{
+			Out_State = FState();
+			return InParams.Center;
+		}
+
+		static FVec3 StartAtPhase(const FParams& InParams, double InPhase, FState& Out_State)
+		{
+			Out_State.Direction = FRotator3(0.0, 360.0 * InPhase, 0.0).RotateVector(FVec3::Forward());
+			return InParams.Center + Out_State.Direction * InParams.Radius;
+		}
+
+		static double GetPeriod(const FParams& InParams)
+		{
+			return 360.0 / InParams.AngularSpeed.Yaw;
+		}
+
+		static float GetReplicationDistance(const FParams& InParams, float InReplicationTime)
+		{
+			return static_cast<float>(InReplicationTime * DegreesToRadians(InParams.AngularSpeed.Yaw) * InParams.Radius);
+		}
+
+		static void Move(const FParams& InParams, FState& InOut_State, float In_DeltaTime, FVec3& InOut_Location, FVec3& Out_Velocity)
+		{
+			const FRotator3 Rot = InParams.AngularSpeed * In_DeltaTime;
+			InOut_State.Direction = Rot.RotateVector(InOut_State.Direction);
+			InOut_State.Direction.Normalize();
+
+			const FVec3 Tangent = FVec3::Up().Cross(InOut_State.Direction);
+			Out_Velocity = Tangent * InParams.TangentialSpeed;
+			InOut_Location = InParams.Center + InOut_State.Direction * InParams.Radius;
+		}
+
+		// Arc length between the two positions
+		static double GetSentDistance(const FParams& InParams, const FVec3& InLocation, const FVec3& InLastSentPosition)
+		{
+			FVec3 VectorA = InLocation - InParams.Center;
+			FVec3 VectorB = InLastSentPosition - InParams.Center;
+
+			VectorA.Normalize();
+			VectorB.Normalize();
+
+			const double Dot = VectorA.Dot(VectorB);
+			const float AngleInRadians = static_cast<float>(std::acos(Dot < -1.0 ? -1.0 : (Dot > 1.0 ? 1.0 : Dot)));
+			return InParams.Radius * AngleInRadians;
+		}
+
+		static FVec3 Evaluate(const FParams& InParams, double InTime, FVec3* Out_Velocity)
+		{
+			const double AngularSpeedRad = DegreesToRadians(InParams.AngularSpeed.Yaw);
+			const double Angle = AngularSpeedRad * InTime;
+			const FVec3 Direction(std::cos(Angle), std::sin(Angle), 0.0);
+			if(Out_Velocity)
+				*Out_Velocity = FVec3::Up().Cross(Direction) * (AngularSpeedRad * InParams.Radius);
+			return InParams.Center + Direction * InParams.Radius;
+		}
+
+		static constexpr const char* Name = "Circle";
+		static constexpr const char* ValueNames[FMotionDescription::MaxValues] = { "Radius", "Degrees per Second" };
+
+		// Only the yaw rate is described, circles rotate around the up axis
+		static void Describe(const FParams& InParams, FMotionDescription& Out_Description)
+		{
+			Out_Description.Origin = InParams.Center;
+			Out_Description.Values[0] = InParams.Radius;
+			Out_Description.Values[1] = static_cast<float>(InParams.AngularSpeed.Yaw);
+		}
+
+		static FParams FromDescription(const FMotionDescription& InDescription)
+		{
+			FMotionSettings Settings;
+			Settings.Radius = InDescription.Values[0];
+			Settings.AngularSpeed = FRotator3(0.0, InDescription.Values[1], 0.0);
+			return MakeParams(Settings, InDescription.Origin);
+		}
+	};
+
+	// Square walked +X, +Y, -X, -Y, turning right at every corner
+	struct FSquareMotion
+	{
+		static constexpr EMotionType Type = EMotionType::Square;
+
+		struct FParams
+		{
+			FVec3 Corner; // Start of the first side
+			float SideLength = 0.0f;
+			float Speed = 0.0f;
+			FRotator3 TurnRight = FRotator3(0, 90.0, 0); // Rotation at corners
+		};
+
+		struct FState
+		{
+			FVec3 Velocity; // Along the current side
+			float PassedDistance = 0.0f; // Distance passed along the current side
+		};
+
+		static FParams MakeParams(const FMotionSettings& InSettings, const FVec3& InCenter)
+		{
+			FParams Params;
+			Params.SideLength = InSettings.SideLength;
+			Params.Speed = InSettings.Speed;
+			Params.Corner = FVec3(InCenter.X - Params.SideLength / 2, InCenter.Y - Params.SideLength / 2, 0);
+			return Params;
+		}
+
+		static FVec3 Start(const FParams& InParams, FState& Out_State)
+		{
+			Out_State = FState();
+			Out_State.Velocity = FVec3::Forward() * InParams.Speed;
+			return InParams.Corner;
+		}
+
+		static FVec3 StartAtPhase(const FParams& InParams, double InPhase, FState& Out_State)
+		{
+			// Walk the corners like Move does
+			double Distance = 4.0 * InParams.SideLength * InPhase;
+			FVec3 Location = InParams.Corner;
+			Out_State.Velocity = FVec3::Forward() * InParams.Speed;
+			while(Distance >= InParams.SideLength)
+			{
+				Location += Out_State.Velocity.GetSafeNormal() * InParams.SideLength;
+				Out_State.Velocity = InParams.TurnRight.RotateVector(Out_State.Velocity);
+				Distance -= InParams.SideLength;
+			}
+			Location += Out_State.Velocity.GetSafeNormal() * Distance;
+			Out_State.PassedDistance = static_cast<float>(Distance);
+			return Location;
+		}
+
+		static double GetPeriod(const FParams& InParams)
+		{
+			return 4.0 * InParams.SideLength / InParams.Speed;
+		}
+
+		static float GetReplicationDistance(const FParams& InParams, float InReplicationTime)
+		{
+			return InParams.Speed * InReplicationTime;
+		}
+
+		// Distance past a corner continues on the next side, a long step may turn several corners
+		static void Move(const FParams& InParams, FState& InOut_State, float In_DeltaTime, FVec3& InOut_Location, FVec3& Out_Velocity)
+		{
+			double Distance = InOut_State.Velocity.Size() * In_DeltaTime;
+			while(InParams.SideLength > 0.0f && InOut_State.PassedDistance + Distance > InParams.SideLength)
+			{
+				const double ToCorner = InParams.SideLength - InOut_State.PassedDistance;
+				InOut_Location += InOut_State.Velocity.GetSafeNormal() * ToCorner;
+				Distance -= ToCorner;
+				InOut_State.PassedDistance = 0.0f;
+				InOut_State.Velocity = InParams.TurnRight.RotateVector(InOut_State.Velocity);
+			}
+			InOut_Location += InOut_State.Velocity.GetSafeNormal() * Distance;
+			InOut_State.PassedDistance += static_cast<float>(Distance);
+			Out_Velocity = InOut_State.Velocity;
+		}
+
+		static double GetSentDistance(const FParams&, const FVec3& InLocation, const FVec3& InLastSentPosition)
+		{
+			return FVec3::Distance(InLocation, InLastSentPosition);
+		}
+
+		static FVec3 Evaluate(const FParams& InParams, double InTime, FVec3* Out_Velocity)
+		{
+			// Sides are walked +X, +Y, -X, -Y, turning right at every corner
+			static constexpr FVec3 Directions[4] = { FVec3(1, 0, 0), FVec3(0, 1, 0), FVec3(-1, 0, 0), FVec3(0, -1, 0) };
+			static constexpr double CornerX[4] = { 0, 1, 1, 0 };
+			static constexpr double CornerY[4] = { 0, 0, 1, 1 };
+
+			if(InParams.SideLength <= 0.0f || InParams.Speed <= 0.0f)
+			{
+				if(Out_Velocity)
+					*Out_Velocity = FVec3::Zero();
+				return InParams.Corner;
+			}
+
+			const double Perimeter = 4.0 * InParams.SideLength;
+			double Distance = std::fmod(InParams.Speed * InTime, Perimeter);
+			if(Distance < 0.0)
+				Distance += Perimeter;
+
+			int Side = static_cast<int>(Distance / InParams.SideLength);
+			Side = Side > 3 ? 3 : Side;
+			const double Along = Distance - Side * static_cast<double>(InParams.SideLength);
+
+			if(Out_Velocity)
+				*Out_Velocity = Directions[Side] * InParams.Speed;
+			const FVec3 Corner = InParams.Corner + FVec3(CornerX[Side], CornerY[Side], 0.0) * InParams.SideLength;
+			return Corner + Directions[Side] * Along;
+		}
+
+		static constexpr const char* Name = "Square";
+		static constexpr const char* ValueNames[FMotionDescription::MaxValues] = { "Side Length", "Speed" };
+
+		static void Describe(const FParams& InParams, FMotionDescription& Out_Description)
+		{
+			Out_Description.Origin = InParams.Corner;
+			Out_Description.Values[0] = InParams.SideLength;
+			Out_Description.Values[1] = InParams.Speed;
+		}
+
+		static FParams FromDescription(const FMotionDescription& InDescription)
+		{
+			FParams Params;
+			Params.Corner = InDescription.Origin;
+			Params.SideLength = InDescription.Values[0];
+			Params.Speed = InDescription.Values[1];
+			return Params;
+		}
+	};
+}
@@ -0,0 +1,166 @@
+#pragma once
+#include <cstddef>
+#include <utility>
+#include <variant>
+#include "DRCoreKinematicState.h"
+#include "DRCoreMotionPolicy.h"
+#include "DRCoreReplication.h"
+
+namespace DRCore
+{
+	// Parameters and state of one motion policy
+	template<typename TPolicy>
+	struct TMotionInstance
+	{
+		using FPolicy = TPolicy;
+		typename TPolicy::FParams Params;
+		typename TPolicy::FState State;
+	};
+
+	// New motion types are added here, FMover needs no other changes
+	using FMotionVariant = std::variant<TMotionInstance<FCircleMotion>, TMotionInstance<FSquareMotion>>;
+
+	// Replication settings shared by all motion types, resolved once in FMover::Initialize
+	struct FReplicationParams
+	{
+		float ReplicationTime = 0.5f;
+		float Distance = 50.0f; // Motion-specific distance threshold, see GetReplicationDistance of the policies
+		EReplicationPolicy Policy = EReplicationPolicy::Distance;
+		float ErrorTolerance = 20.0f; // Largest allowed client prediction error
+	};
+
+	// Scripted server-side motion of a single entity (circle or square path).
+	// Holds no engine references, so many movers can be advanced in parallel.
+	// The motion type is resolved once into Motion; Step dispatches on it once per
+	// call and then runs a loop instantiated for that policy.
+	struct FMover
+	{
+		FMotionVariant Motion;
+		FReplicationParams Replication;
+		FShadowClient ShadowClient; // Client extrapolator replica for EReplicationPolicy::PredictionError
+
+		FVec3 Location; // Simulated location
+		FVec3 PreviousLocation; // Location before the last step
+		FVec3 Velocity; // Velocity after the last step
+		double SimTime = 0.0; // Simulated time since Initialize
+		double Phase = 0.0; // Fraction of the path already covered when the motion started, see SetPhase
+
+		// Calls InFunc with the TMotionInstance of the mover's motion type
+		template<typename TFunc>
+		decltype(auto) Visit(TFunc&& InFunc) { return std::visit(std::forward<TFunc>(InFunc), Motion); }
+		template<typename TFunc>
+		decltype(auto) Visit(TFunc&& InFunc) const { return std::visit(std::forward<TFunc>(InFunc), Motion); }
+
+		// InCenter is the center of the path
+		void Initialize(const FMotionSettings& InSettings, const FVec3& InCenter)
+		{
+			EmplaceMotion(InSettings, InCenter);
+			Visit([this, &InSettings](auto& InOut_Motion)
+			{
+				using FPolicy = typename std::decay_t<decltype(InOut_Motion)>::FPolicy;
+				Location = FPolicy::Start(InOut_Motion.Params, InOut_Motion.State);
+				Replication.Distance = FPolicy::GetReplicationDistance(InOut_Motion.Params, InSettings.ReplicationTime);
+			});
+
+			Replication.ReplicationTime = InSettings.ReplicationTime;
+			Replication.Policy = InSettings.ReplicationPolicy;
+			Replication.ErrorTolerance = InSettings.ReplicationErrorTolerance;
+
+			PreviousLocation = Location;
+			Velocity = FVec3::Zero();
+			SimTime = 0.0;
+			Phase = 0.0;
+		}
+
+		EMotionType GetType() const
+		{
+			return Visit([](const auto& InMotion) { return std::decay_t<decltype(InMotion)>::FPolicy::Type; });
+		}
+
+		// Location between the last two steps, InAlpha from FFixedStepAccumulator::GetAlpha
+		FVec3 GetInterpolatedLocation(double InAlpha) const
+		{
+			return PreviousLocation + (Location - PreviousLocation) * InAlpha;
+		}
+
+		// Seconds to go once around the path
+		double GetPeriod() const
+		{
+			return Visit([](const auto& InMotion) { return std::decay_t<decltype(InMotion)>::FPolicy::GetPeriod(InMotion.Params); });
+		}
+
+		// Start InPhase of the way around the path instead of at its beginning, call after Initialize.
+		// Movers initialized with different phases spread out along the same path.
+		void SetPhase(double InPhase)
+		{
+			Phase = InPhase - std::floor(InPhase);
+			Location = Visit([this](auto& InOut_Motion)
+			{
+				using FPolicy = typename std::decay_t<decltype(InOut_Motion)>::FPolicy;
+				return FPolicy::StartAtPhase(InOut_Motion.Params, Phase, InOut_Motion.State);
+			});
+			PreviousLocation = Location;
+		}
+
+		// Advance the motion and update InOut_ServerState when the replication threshold is crossed.
+		// Returns true if the server state was changed.
+		bool Step(float In_DeltaTime, FKinematicState& InOut_ServerState)
+		{
+			return Step(1, In_DeltaTime, InOut_ServerState) >= 0;
+		}
+
+		// InNumSteps steps of In_DeltaTime. Returns the index of the last step that changed
+		// InOut_ServerState, -1 if none did.
+		int Step(int InNumSteps, float In_DeltaTime, FKinematicState& InOut_ServerState)
+		{
+			return Visit([&](auto& InOut_Motion) { return StepMotion(InOut_Motion, InNumSteps, In_DeltaTime, InOut_ServerState); });
+		}
+
+	private:
+		template<typename TPolicy>
+		int StepMotion(TMotionInstance<TPolicy>& InOut_Motion, int InNumSteps, float In_DeltaTime, FKinematicState& InOut_ServerState)
+		{
+			int LastSentStep = -1;
+			for(int StepIndex = 0; StepIndex < InNumSteps; ++StepIndex)
+			{
+				PreviousLocation = Location;
+				SimTime += In_DeltaTime;
+				TPolicy::Move(InOut_Motion.Params, InOut_Motion.State, In_DeltaTime, Location, Velocity);
+
+				bool bSend;
+				if(Replication.Policy == EReplicationPolicy::PredictionError)
+					bSend = ShadowClient.Step(In_DeltaTime, InOut_ServerState, Location) > Replication.ErrorTolerance;
+				else
+					bSend = TPolicy::GetSentDistance(InOut_Motion.Params, Location, InOut_ServerState.Position) > Replication.Distance;
+
+				if(bSend)
+				{
+					InOut_ServerState.Velocity = Velocity;
+					InOut_ServerState.Position = Location;
+					if(Replication.Policy == EReplicationPolicy::PredictionError)
+					{
+						ShadowClient.OnStateSent(InOut_ServerState, SimTime);
+					}
+					LastSentStep = StepIndex;
+				}
+			}
+			return LastSentStep;
+		}
+
+		// Selects the alternative of Motion whose policy matches InSettings.MotionType
+		template<std::size_t Index = 0>
+		void EmplaceMotion(const FMotionSettings& InSettings, const FVec3& InCenter)
+		{
+			if constexpr(Index < std::variant_size_v<FMotionVariant>)
+			{
+				using FPolicy = typename std::variant_alternative_t<Index, FMotionVariant>::FPolicy;
+				if(FPolicy::Type != InSettings.MotionType)
+				{
+					EmplaceMotion<Index + 1>(InSettings, InCenter);
+					return;
+				}
+				Motion.template emplace<Index>().Params = FPolicy::MakeParams(InSettings, InCenter);
+			}
+		}
+	};
+}
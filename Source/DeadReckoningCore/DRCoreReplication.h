@@ -0,0 +1,49 @@
+#pragma once
+#include "DRCoreCollectors.h"
+#include "DRCoreExtrapolator.h"
+
+namespace DRCore
+{
+	// Sequence numbers of an unreliable stream wrap around. A sequence is newer than the last
+	// one when it is less than half the range ahead of it.
+	inline bool IsNewerSequence(uint16_t InSequence, uint16_t InLast)
+	{
+		return InSequence != InLast && static_cast<uint16_t>(InSequence - InLast) < 0x8000;
+	}
+
+	// How the server decides that a new kinematic state has to be sent
+	enum class EReplicationPolicy : unsigned char
+	{
+		Distance, // Motion-specific distance since the last sent state, see FReplicationParams::Distance
+		PredictionError, // Distance between the true position and what the client extrapolates
+	};
+
+	// Server-side copy of the client extrapolator for one entity. The client is assumed
+	// to receive every sent state immediately, its own sample-age compensation covers latency.
+	struct FShadowClient
+	{
+		FBlendingExtrapolator Extrapolator;
+		TTimeStampCollector<double> TimeStampCollector{ 1.0, 1.0 }; // Same window as the client pawn
+		bool bInitialized = false;
+
+		// Advance the shadow by one step and return its distance to the true position
+		double Step(float In_DeltaTime, const FKinematicState& InLastSentState, const FVec3& InTruePosition)
+		{
+			if(!bInitialized)
+			{
+				Extrapolator.Reset(InLastSentState);
+				bInitialized = true;
+			}
+			return FVec3::Distance(Extrapolator.Step(In_DeltaTime), InTruePosition);
+		}
+
+		void OnStateSent(const FKinematicState& InState, double InServerTime)
+		{
+			TimeStampCollector.Add(InServerTime);
+			const float AverageServerUpdateTime = TimeStampCollector.IsValid()
+				? static_cast<float>(TimeStampCollector.GetAverageDuration())
+				: Extrapolator.AverageServerUpdateTime;
+			Extrapolator.SetServerState(InState, AverageServerUpdateTime);
+		}
+	};
+}
@@ -11,5 +11,11 @@ public class DeadReckoningTestTarget : TargetRules
 		DefaultBuildSettings = BuildSettingsVersion.V5;
 		IncludeOrderVersion = EngineIncludeOrderVersion.Unreal5_4;
 		ExtraModuleNames.Add("DeadReckoningTest");
+
+		// Server_KinematicState is marked dirty explicitly instead of being compared every net tick
+		bWithPushModel = true;
+
+		// Built with Iris so both replication systems can be compared, which one runs is chosen by net.Iris.UseIrisReplication
+		bUseIris = true;
 	}
 }
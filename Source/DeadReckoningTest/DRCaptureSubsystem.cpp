@@ -0,0 +1,223 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "DRCaptureSubsystem.h"
+
+#include "Async/MappedFileHandle.h"
+#include "DRMover.h"
+#include "Engine/Engine.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/Paths.h"
+
+static TAutoConsoleVariable<float> CVarDRCaptureTruthInterval(
+	TEXT("DR.Capture.TruthInterval"),
+	0.0f,
+	TEXT("Seconds between ground-truth samples of a pawn in server captures, 0 records every server tick."));
+
+static FAutoConsoleCommandWithWorldAndArgs CmdCaptureStart(
+	TEXT("DR.Capture.Start"),
+	TEXT("Start capturing the kinematic stream in every game world. Usage: DR.Capture.Start [Name=Capture]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&UDRCaptureSubsystem::StartAll));
+
+static FAutoConsoleCommandWithWorldAndArgs CmdCaptureStop(
+	TEXT("DR.Capture.Stop"),
+	TEXT("Stop capturing in every game world."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&UDRCaptureSubsystem::StopAll));
+
+static FAutoConsoleCommandWithWorldAndArgs CmdCaptureReplay(
+	TEXT("DR.Capture.Replay"),
+	TEXT("Replay captures through the client extrapolation and log the error. Usage: DR.Capture.Replay <ServerFile> [ClientFile|-] [MaxBlendFactor=1.2] [ResendTolerance=0]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&UDRCaptureSubsystem::Replay));
+
+namespace DRCapture
+{
+	constexpr int32 RecordsPerFlush = 4096;
+
+	FString GetCaptureDir()
+	{
+		return FPaths::ProjectSavedDir() / TEXT("DeadReckoning");
+	}
+
+	// Read-only mapping of a capture file, the region is released before the handle
+	struct FMappedCapture
+	{
+		TUniquePtr<IMappedFileHandle> Handle;
+		TUniquePtr<IMappedFileRegion> Region;
+		DRCore::Capture::FCaptureView View;
+
+		bool Open(const FString& InFileName)
+		{
+			const FString Path = FPaths::IsRelative(InFileName) ? GetCaptureDir() / InFileName : InFileName;
+			FOpenMappedResult Result = FPlatformFileManager::Get().GetPlatformFile().OpenMappedEx(*Path);
+			if(Result.HasError())
+			{
+				UE_LOG(LogTemp, Warning, TEXT("Cannot map %s: %s"), *Path, *Result.GetError().GetMessage());
+				return false;
+			}
+			Handle = Result.StealValue();
+			Region.Reset(Handle->MapRegion(0, Handle->GetFileSize()));
+			if(!Region.IsValid())
+				return false;
+
+			View = DRCore::Capture::FCaptureView(Region->GetMappedPtr(), static_cast<size_t>(Region->GetMappedSize()));
+			if(!View.IsValid())
+			{
+				UE_LOG(LogTemp, Warning, TEXT("%s is not a capture file"), *Path);
+			}
+			return View.IsValid();
+		}
+	};
+}
+
+
+bool UDRCaptureSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UDRCaptureSubsystem::Deinitialize()
+{
+	StopCapture();
+	Super::Deinitialize();
+}
+
+bool UDRCaptureSubsystem::StartCapture(const FString& InName)
+{
+	StopCapture();
+
+	// PIE runs the server and the clients in one process, so clients are told apart by instance
+	const bool bClient = GetWorld()->GetNetMode() == NM_Client;
+	const int32 PIEInstance = GetWorld()->GetOutermost()->GetPIEInstanceID();
+	const FString Suffix = !bClient ? TEXT("Server") : (PIEInstance != INDEX_NONE ? FString::Printf(TEXT("Client%d"), PIEInstance) : TEXT("Client"));
+	FileName = DRCapture::GetCaptureDir() / FString::Printf(TEXT("%s_%s.drcap"), *InName, *Suffix);
+
+	Writer.Reset(IFileManager::Get().CreateFileWriter(*FileName));
+	if(!Writer.IsValid())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Cannot open capture file %s"), *FileName);
+		return false;
+	}
+
+	DRCore::Capture::FFileHeader Header = DRCore::Capture::MakeHeader();
+	Writer->Serialize(&Header, sizeof(Header));
+	PendingRecords.Reset(DRCapture::RecordsPerFlush);
+	UE_LOG(LogTemp, Log, TEXT("Capturing to %s"), *FileName);
+	return true;
+}
+
+void UDRCaptureSubsystem::StopCapture()
+{
+	if(!Writer.IsValid())
+		return;
+
+	Flush();
+	Writer->Close();
+	UE_LOG(LogTemp, Log, TEXT("Capture %s written, %lld bytes"), *FileName, Writer->TotalSize());
+	Writer.Reset();
+}
+
+void UDRCaptureSubsystem::RecordState(uint32 InPawnId, const FKinematicState& InState)
+{
+	const DRCore::FKinematicState State = ToCore(InState);
+	Write(DRCore::Capture::MakeRecord(DRCore::Capture::ERecordType::State, InPawnId, State.Time, 0.0, State));
+}
+
+void UDRCaptureSubsystem::RecordTruth(uint32 InPawnId, double InServerTime, const FVector& InPosition, const FVector& InVelocity)
+{
+	const DRCore::FKinematicState State(ToCore(InPosition), ToCore(InVelocity), DRCore::FVec3::Zero(), InServerTime);
+	Write(DRCore::Capture::MakeRecord(DRCore::Capture::ERecordType::Truth, InPawnId, InServerTime, 0.0, State));
+}
+
+bool UDRCaptureSubsystem::ShouldRecordTruth(double& InOut_LastTruthTime, double InServerTime) const
+{
+	if(InServerTime - InOut_LastTruthTime < CVarDRCaptureTruthInterval.GetValueOnGameThread())
+		return false;
+	InOut_LastTruthTime = InServerTime;
+	return true;
+}
+
+void UDRCaptureSubsystem::RecordReceive(uint32 InPawnId, const FKinematicState& InState, double InReceiveTime)
+{
+	const DRCore::FKinematicState State = ToCore(InState);
+	Write(DRCore::Capture::MakeRecord(DRCore::Capture::ERecordType::Receive, InPawnId, State.Time, InReceiveTime, State));
+}
+
+void UDRCaptureSubsystem::Write(const DRCore::Capture::FRecord& InRecord)
+{
+	if(!Writer.IsValid())
+		return;
+
+	PendingRecords.Add(InRecord);
+	if(PendingRecords.Num() >= DRCapture::RecordsPerFlush)
+		Flush();
+}
+
+void UDRCaptureSubsystem::Flush()
+{
+	if(PendingRecords.Num() > 0)
+	{
+		Writer->Serialize(PendingRecords.GetData(), PendingRecords.Num() * sizeof(DRCore::Capture::FRecord));
+		PendingRecords.Reset();
+	}
+}
+
+void UDRCaptureSubsystem::StartAll(const TArray<FString>& Args, UWorld* World)
+{
+	const FString Name = Args.Num() > 0 ? Args[0] : TEXT("Capture");
+	for(const FWorldContext& Context : GEngine->GetWorldContexts())
+	{
+		if(UWorld* ContextWorld = Context.World())
+		{
+			if(UDRCaptureSubsystem* Subsystem = ContextWorld->GetSubsystem<UDRCaptureSubsystem>())
+			{
+				Subsystem->StartCapture(Name);
+			}
+		}
+	}
+}
+
+void UDRCaptureSubsystem::StopAll(const TArray<FString>& Args, UWorld* World)
+{
+	for(const FWorldContext& Context : GEngine->GetWorldContexts())
+	{
+		if(UWorld* ContextWorld = Context.World())
+		{
+			if(UDRCaptureSubsystem* Subsystem = ContextWorld->GetSubsystem<UDRCaptureSubsystem>())
+			{
+				Subsystem->StopCapture();
+			}
+		}
+	}
+}
+
+void UDRCaptureSubsystem::Replay(const TArray<FString>& Args, UWorld* World)
+{
+	if(Args.Num() < 1)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Usage: DR.Capture.Replay <ServerFile> [ClientFile|-] [MaxBlendFactor] [ResendTolerance]"));
+		return;
+	}
+
+	DRCapture::FMappedCapture Server;
+	if(!Server.Open(Args[0]))
+		return;
+
+	DRCapture::FMappedCapture Client;
+	const bool bHasClient = Args.Num() > 1 && Args[1] != TEXT("-");
+	if(bHasClient && !Client.Open(Args[1]))
+		return;
+
+	DRCore::Capture::FReplaySettings Settings;
+	if(Args.Num() > 2)
+		Settings.MaxBlendFactor = FCString::Atof(*Args[2]);
+	if(Args.Num() > 3)
+		Settings.ResendTolerance = FCString::Atod(*Args[3]);
+
+	const double StartTime = FPlatformTime::Seconds();
+	const DRCore::Capture::FReplayResult Result = DRCore::Capture::Replay(Server.View, bHasClient ? &Client.View : nullptr, Settings);
+	const double WallTime = FPlatformTime::Seconds() - StartTime;
+
+	UE_LOG(LogTemp, Log, TEXT("Replayed %.1fs of %lld pawns in %.3fs: %.2f updates/s per pawn, error rms %.3f, max %.3f"),
+		Result.Duration, Result.Entities, WallTime, Result.GetUpdatesPerSecond(), Result.GetRmsError(), Result.MaxError);
+}
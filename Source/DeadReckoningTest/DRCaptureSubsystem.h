@@ -0,0 +1,53 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DeadReckoningCore/DRCoreCapture.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "DRCaptureSubsystem.generated.h"
+
+struct FKinematicState;
+
+/**
+ * Records the replicated kinematic stream of this world into an append-only capture file
+ * (DeadReckoningCore/DRCoreCapture.h). Servers record every Server_KinematicState change and
+ * the ground-truth motion, clients record what they received and when. Captures are scored
+ * offline with DR.Capture.Replay or Tools/DRBenchmark/DRReplay.
+ */
+UCLASS()
+class DEADRECKONINGTEST_API UDRCaptureSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	// Files go to Saved/DeadReckoning/<InName>_<Server|Client>.drcap
+	bool StartCapture(const FString& InName);
+	void StopCapture();
+	bool IsCapturing() const { return Writer.IsValid(); }
+
+	// Server
+	void RecordState(uint32 InPawnId, const FKinematicState& InState);
+	void RecordTruth(uint32 InPawnId, double InServerTime, const FVector& InPosition, const FVector& InVelocity);
+	bool ShouldRecordTruth(double& InOut_LastTruthTime, double InServerTime) const;
+	// Client, InReceiveTime is FPlatformTime::Seconds()
+	void RecordReceive(uint32 InPawnId, const FKinematicState& InState, double InReceiveTime);
+
+	// DR.Capture.Start [Name], DR.Capture.Stop, DR.Capture.Replay <ServerFile> [ClientFile] [MaxBlendFactor] [ResendTolerance]
+	static void StartAll(const TArray<FString>& Args, UWorld* World);
+	static void StopAll(const TArray<FString>& Args, UWorld* World);
+	static void Replay(const TArray<FString>& Args, UWorld* World);
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	void Write(const DRCore::Capture::FRecord& InRecord);
+	void Flush();
+
+	TUniquePtr<FArchive> Writer;
+	TArray<DRCore::Capture::FRecord> PendingRecords; // Written in blocks of RecordsPerFlush
+	FString FileName;
+};
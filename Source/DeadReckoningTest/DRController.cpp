@@ -4,6 +4,10 @@
 #include "DRController.h"
 
 #include "Blueprint/UserWidget.h"
+#include "DRGameMode.h"
+#include "DRPawn.h"
+#include "DRTelemetry.h"
+#include "TimerManager.h"
 
 
 void ADRController::BeginPlay()
@@ -16,22 +20,46 @@ void ADRController::BeginPlay()
 		if (InfoWidget != nullptr)
 		{
 			InfoWidget->AddToViewport();
+			GetWorldTimerManager().SetTimer(InfoWidgetRefreshTimer, this, &ADRController::RefreshInfoWidget, InfoWidgetRefreshInterval, true);
 		}
 	}
 }
 
-void ADRController::UpdateAverageServerUpdateTimeInfoWidget(float InAverageServerUpdateTime) const
+void ADRController::RefreshInfoWidget() const
 {
 	if (InfoWidget != nullptr)
 	{
-		InfoWidget->UpdateAverageServerUpdateTimeText(InAverageServerUpdateTime);
+		if (const ADRPawn* DRPawn = Cast<ADRPawn>(GetPawn()))
+		{
+			InfoWidget->UpdateAverageServerUpdateTimeText(DRPawn->GetAverageServerUpdateTime());
+		}
+		InfoWidget->UpdateTelemetryText(FDRTelemetry::Get().GetLastWindow());
 	}
 }
 
-void ADRController::UpdateMotionInfoWidget(bool IsCircle, float InCircleRadius, float InAngularSpeed, float InSquareSideLength, float Speed) const
+void ADRController::UpdateMotionInfoWidget(const FString& InMotionInfo) const
 {
 	if (InfoWidget != nullptr)
 	{
-		InfoWidget->UpdateMotionInfoText(IsCircle, InCircleRadius, InAngularSpeed, InSquareSideLength, Speed);
+		InfoWidget->UpdateMotionInfoText(InMotionInfo);
+	}
+}
+
+void ADRController::ClientBeginStressMeasurement_Implementation(float InDuration)
+{
+	StressRecorder.Start(GetWorld());
+	GetWorldTimerManager().SetTimer(StressMeasurementTimer, this, &ADRController::EndStressMeasurement, InDuration, false);
+}
+
+void ADRController::EndStressMeasurement()
+{
+	ServerReportStressResult(StressRecorder.Stop());
+}
+
+void ADRController::ServerReportStressResult_Implementation(const FDRStressTestResult& InResult)
+{
+	if (ADRGameMode* GameMode = GetWorld()->GetAuthGameMode<ADRGameMode>())
+	{
+		GameMode->ReportClientStressResult(this, InResult);
 	}
 }
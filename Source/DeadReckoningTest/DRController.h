@@ -3,6 +3,7 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "DRStressTest.h"
 #include "InfoWidget.h"
 #include "GameFramework/PlayerController.h"
 #include "DRController.generated.h"
@@ -16,8 +17,13 @@ class DEADRECKONINGTEST_API ADRController : public APlayerController
 	GENERATED_BODY()
 
 public:
-	void UpdateAverageServerUpdateTimeInfoWidget(float InAverageServerUpdateTime) const;
-	void UpdateMotionInfoWidget(bool IsCircle, float InCircleRadius, float InAngularSpeed, float InSquareSideLength, float Speed) const;
+	void UpdateMotionInfoWidget(const FString& InMotionInfo) const;
+
+	// Stress test measurement on the client, the result is reported back to ADRGameMode
+	UFUNCTION(Client, Reliable)
+	void ClientBeginStressMeasurement(float InDuration);
+	UFUNCTION(Server, Reliable)
+	void ServerReportStressResult(const FDRStressTestResult& InResult);
 	
 protected:
 	virtual void BeginPlay() override;
@@ -26,5 +32,16 @@ private:
 	UPROPERTY(EditAnywhere, Category = "HUD")
 	TSubclassOf<UInfoWidget> InfoWidgetClass;
 
+	// The widget is refreshed on a timer instead of on every replicated update
+	UPROPERTY(EditAnywhere, Category = "HUD", meta = (ClampMin = "0.02"))
+	float InfoWidgetRefreshInterval = 0.25f;
+
 	TWeakObjectPtr<UInfoWidget> InfoWidget;
+	FTimerHandle InfoWidgetRefreshTimer;
+
+	void RefreshInfoWidget() const;
+
+	FDRStressRecorder StressRecorder;
+	FTimerHandle StressMeasurementTimer;
+	void EndStressMeasurement();
 };
@@ -0,0 +1,329 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "DRCrowdActor.h"
+
+#include "Async/ParallelFor.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "DeadReckoningTest.h"
+#include "DRDeadReckoningSubsystem.h"
+#include "DRTelemetry.h"
+#include "DRWorldSettings.h"
+#include "GameFramework/PlayerStart.h"
+#include "Kismet/GameplayStatics.h"
+#include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
+
+DECLARE_CYCLE_STAT(TEXT("Crowd Simulate"), STAT_DRCrowdSimulate, STATGROUP_DeadReckoning);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Crowd Entities"), STAT_DRCrowdEntities, STATGROUP_DeadReckoning);
+
+
+void FDRCrowdEntity::PostReplicatedAdd(const FDRCrowdEntityArray& InArraySerializer)
+{
+	if(InArraySerializer.Owner != nullptr)
+		InArraySerializer.Owner->OnEntityAdded(*this);
+}
+
+void FDRCrowdEntity::PostReplicatedChange(const FDRCrowdEntityArray& InArraySerializer)
+{
+	if(InArraySerializer.Owner != nullptr)
+		InArraySerializer.Owner->OnEntityChanged(*this);
+}
+
+void FDRCrowdEntity::PreReplicatedRemove(const FDRCrowdEntityArray& InArraySerializer)
+{
+	if(InArraySerializer.Owner != nullptr)
+		InArraySerializer.Owner->OnEntityRemoved(*this);
+}
+
+
+ADRCrowdActor::ADRCrowdActor()
+{
+	PrimaryActorTick.bCanEverTick = true;
+
+	bReplicates = true;
+	bAlwaysRelevant = true;
+	NetUpdateFrequency = 100;
+
+	InstancedMesh = CreateDefaultSubobject<UInstancedStaticMeshComponent>(TEXT("InstancedMesh"));
+	InstancedMesh->SetMobility(EComponentMobility::Movable);
+	InstancedMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	RootComponent = InstancedMesh;
+
+	Entities.Owner = this;
+}
+
+void ADRCrowdActor::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	FDoRepLifetimeParams PushParams;
+	PushParams.bIsPushBased = true;
+	DOREPLIFETIME_WITH_PARAMS_FAST(ADRCrowdActor, Entities, PushParams);
+	DOREPLIFETIME_CONDITION(ADRCrowdActor, ProxyMesh, COND_InitialOnly);
+	DOREPLIFETIME_CONDITION(ADRCrowdActor, ProxyScale, COND_InitialOnly);
+}
+
+void ADRCrowdActor::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+
+	// Initial replication adds entities before BeginPlay, so the settings are resolved here
+	if(const ADRWorldSettings* Settings = Cast<ADRWorldSettings>(GetWorldSettings()))
+	{
+		BlendTimeEstimate = Settings->GetBlendTimeEstimate();
+		BlendTimePercentile = Settings->BlendTimePercentile;
+		BlendTimeEwmaSmoothing = Settings->BlendTimeEwmaSmoothing;
+		ServerStepper = Settings->MakeFixedStepAccumulator();
+		BatchSize = FMath::Max(1, Settings->ServerMotionBatchSize);
+	}
+	bDrawServerMotion = HasAuthority() && GetNetMode() != NM_DedicatedServer;
+	OnRep_ProxyMesh();
+}
+
+void ADRCrowdActor::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// Clients only react to replication
+	SetActorTickEnabled(HasAuthority());
+}
+
+void ADRCrowdActor::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	for(int32 Instance = 0; Instance < InstanceTransforms.Num(); ++Instance)
+	{
+		if(HasProxy(Instance))
+			RemoveProxy(Instance);
+	}
+	Super::EndPlay(EndPlayReason);
+}
+
+void ADRCrowdActor::SetProxyMesh(UStaticMesh* InMesh, const FVector& InScale)
+{
+	ProxyMesh = InMesh;
+	ProxyScale = InScale;
+	OnRep_ProxyMesh();
+}
+
+void ADRCrowdActor::OnRep_ProxyMesh()
+{
+	if(ProxyMesh != nullptr)
+	{
+		InstancedMesh->SetStaticMesh(ProxyMesh);
+	}
+}
+
+void ADRCrowdActor::AddStressMovers(int32 InFirstIndex, int32 InNum)
+{
+	const ADRWorldSettings* Settings = Cast<ADRWorldSettings>(GetWorldSettings());
+	if(Settings == nullptr || !HasAuthority())
+		return;
+
+	// Same spread origin as ADRPawn::GetPlayerStartPosition
+	const AActor* PlayerStart = UGameplayStatics::GetActorOfClass(GetWorld(), APlayerStart::StaticClass());
+	const FVector Origin = PlayerStart != nullptr ? PlayerStart->GetActorLocation() : FVector::ZeroVector;
+
+	TArray<FDRMover> NewMovers;
+	NewMovers.SetNum(InNum);
+	Entities.Items.Reserve(Entities.Items.Num() + InNum);
+	for(int32 Index = InFirstIndex; Index < InFirstIndex + InNum; ++Index)
+	{
+		FDRMover& Mover = NewMovers[Index - InFirstIndex];
+		Mover.InitializeStress(*Settings, Index, Origin);
+
+		FDRCrowdEntity& Entity = Entities.Items.AddDefaulted_GetRef();
+		Entity.State = FKinematicState(ToFVector(Mover.Location), FVector::Zero(), FVector::Zero());
+		Entity.State.SetServerTime(GetWorld()->GetTimeSeconds());
+		Entities.MarkItemDirty(Entity);
+
+		if(bDrawServerMotion)
+			Entity.Instance = AddInstance(Entity.State.Position);
+	}
+	LastSentSteps.SetNumZeroed(Entities.Items.Num());
+	AddMovers(MoveTemp(NewMovers));
+	MARK_PROPERTY_DIRTY_FROM_NAME(ADRCrowdActor, Entities, this);
+}
+
+void ADRCrowdActor::AddMovers(TArray<FDRMover>&& InMovers)
+{
+	Movers.Append(MoveTemp(InMovers));
+}
+
+void ADRCrowdActor::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if(HasAuthority())
+	{
+		SimulateServerMotion(DeltaTime);
+	}
+}
+
+// Same stepping as ADRPawn::SimulateServerMotion, in one parallel pass over all movers
+void ADRCrowdActor::SimulateServerMotion(float In_DeltaTime)
+{
+	const int32 NumMovers = Entities.Items.Num();
+	const int32 NumSteps = ServerStepper.Advance(In_DeltaTime);
+	if(NumMovers == 0 || NumSteps == 0)
+		return;
+
+	SET_DWORD_STAT(STAT_DRCrowdEntities, NumMovers);
+	const float StepTime = static_cast<float>(ServerStepper.GetStepTime());
+	const double LastStepTime = GetWorld()->GetTimeSeconds() - ServerStepper.GetRemainder();
+	{
+		SCOPE_CYCLE_COUNTER(STAT_DRCrowdSimulate);
+		StepMovers(NumSteps, StepTime);
+	}
+
+	// Fast array and push model dirty tracking are not thread safe
+	bool bChanged = false;
+	for(int32 Index = 0; Index < NumMovers; ++Index)
+	{
+		if(LastSentSteps[Index] == INDEX_NONE)
+			continue;
+
+		FDRCrowdEntity& Entity = Entities.Items[Index];
+		Entity.State.SetServerTime(LastStepTime - (NumSteps - 1 - LastSentSteps[Index]) * StepTime);
+		Entities.MarkItemDirty(Entity);
+		FDRTelemetry::Get().RecordUpdateSent();
+		bChanged = true;
+	}
+	if(bChanged)
+	{
+		MARK_PROPERTY_DIRTY_FROM_NAME(ADRCrowdActor, Entities, this);
+	}
+
+	if(bDrawServerMotion)
+	{
+		const double Alpha = ServerStepper.GetAlpha();
+		for(int32 Index = 0; Index < NumMovers; ++Index)
+		{
+			SetInstanceLocation(Entities.Items[Index].Instance, GetMoverLocation(Index, Alpha));
+		}
+		FlushInstanceTransforms();
+	}
+}
+
+void ADRCrowdActor::StepMovers(int32 InNumSteps, float In_StepTime)
+{
+	ParallelFor(TEXT("DRCrowdMotion"), Movers.Num(), BatchSize, [this, InNumSteps, In_StepTime](int32 Index)
+	{
+		LastSentSteps[Index] = Movers[Index].Step(InNumSteps, In_StepTime, Entities.Items[Index].State);
+	});
+}
+
+FVector ADRCrowdActor::GetMoverLocation(int32 InItem, double InAlpha) const
+{
+	return ToFVector(Movers[InItem].GetInterpolatedLocation(InAlpha));
+}
+
+int32 ADRCrowdActor::AddInstance(const FVector& InLocation)
+{
+	const FTransform& Transform = InstanceTransforms.Emplace_GetRef(FQuat::Identity, InLocation, ProxyScale);
+	const int32 Instance = InstancedMesh->AddInstance(Transform, true);
+	check(Instance == InstanceTransforms.Num() - 1);
+	return Instance;
+}
+
+void ADRCrowdActor::FlushInstanceTransforms()
+{
+	if(InstanceTransforms.Num() > 0)
+	{
+		InstancedMesh->BatchUpdateInstancesTransforms(0, InstanceTransforms, true, true, true);
+	}
+}
+
+void ADRCrowdActor::OnEntityAdded(FDRCrowdEntity& InOut_Entity)
+{
+	InOut_Entity.Instance = AddInstance(InOut_Entity.State.Position);
+
+	FTimeStampCollector<double>& Collector = TimeStampCollectors.Emplace_GetRef(1.0, 1.0);
+	Collector.SetQuantile(BlendTimePercentile);
+	Collector.SetEwmaSmoothing(BlendTimeEwmaSmoothing);
+	Collector.Add(InOut_Entity.State.GetServerTime());
+
+	AddProxy(InOut_Entity.Instance, InOut_Entity.State, 1.0f / NetUpdateFrequency);
+}
+
+// Same handling as ADRPawn::OnRep_KinematicState
+void ADRCrowdActor::OnEntityChanged(const FDRCrowdEntity& InEntity)
+{
+	if(!HasProxy(InEntity.Instance))
+		return;
+
+	const double ServerTime = InEntity.State.GetServerTime();
+	FTimeStampCollector<double>& Collector = TimeStampCollectors[InEntity.Instance];
+	Collector.Add(ServerTime);
+	const float BlendTime = Collector.IsValid() ? static_cast<float>(Collector.GetDuration(BlendTimeEstimate)) : 1.0f / NetUpdateFrequency;
+
+	ServerClockOffset.AddSample(FPlatformTime::Seconds(), ServerTime);
+	const UDRDeadReckoningSubsystem* Subsystem = GetWorld()->GetSubsystem<UDRDeadReckoningSubsystem>();
+	FKinematicState State = InEntity.State;
+	const double StateAge = ServerClockOffset.GetLastSampleAge(Subsystem != nullptr ? Subsystem->GetRoundTripTime() : 0.0);
+	State.Extrapolate(FMath::Min(static_cast<float>(StateAge), MaxSampleAge));
+	FDRTelemetry::Get().RecordStateAge(StateAge);
+
+	FDRTelemetry::Get().RecordUpdateReceived(static_cast<float>(FVector::Dist(GetProxyPosition(InEntity.Instance), State.Position)));
+	SetProxyServerState(InEntity.Instance, State, BlendTime);
+}
+
+void ADRCrowdActor::OnEntityRemoved(const FDRCrowdEntity& InEntity)
+{
+	if(!InstanceTransforms.IsValidIndex(InEntity.Instance))
+		return;
+
+	// Instances are not removed, that would renumber the ones after it
+	if(HasProxy(InEntity.Instance))
+		RemoveProxy(InEntity.Instance);
+	InstanceTransforms[InEntity.Instance].SetScale3D(FVector::ZeroVector);
+	InstancedMesh->UpdateInstanceTransform(InEntity.Instance, InstanceTransforms[InEntity.Instance], true, true, true);
+}
+
+void ADRCrowdActor::AddProxy(int32 InInstance, const FKinematicState& InState, float InBlendTime)
+{
+	check(InInstance == ProxyHandles.Num());
+	UDRDeadReckoningSubsystem* Subsystem = GetWorld()->GetSubsystem<UDRDeadReckoningSubsystem>();
+	ProxyHandles.Add(Subsystem != nullptr ? Subsystem->RegisterProxy(this, InInstance, InState, InBlendTime) : INDEX_NONE);
+}
+
+void ADRCrowdActor::RemoveProxy(int32 InInstance)
+{
+	// Unregistering moves another proxy into the freed slot, which updates its ProxyHandles entry
+	const int32 Handle = ProxyHandles[InInstance];
+	ProxyHandles[InInstance] = INDEX_NONE;
+	if(UDRDeadReckoningSubsystem* Subsystem = GetWorld()->GetSubsystem<UDRDeadReckoningSubsystem>())
+	{
+		Subsystem->Unregister(Handle);
+	}
+}
+
+bool ADRCrowdActor::HasProxy(int32 InInstance) const
+{
+	return ProxyHandles.IsValidIndex(InInstance) && ProxyHandles[InInstance] != INDEX_NONE;
+}
+
+FVector ADRCrowdActor::GetProxyPosition(int32 InInstance) const
+{
+	return GetWorld()->GetSubsystem<UDRDeadReckoningSubsystem>()->GetClientPosition(ProxyHandles[InInstance]);
+}
+
+void ADRCrowdActor::SetProxyServerState(int32 InInstance, const FKinematicState& InState, float InBlendTime)
+{
+	GetWorld()->GetSubsystem<UDRDeadReckoningSubsystem>()->SetServerState(ProxyHandles[InInstance], InState, InBlendTime);
+}
+
+SIZE_T ADRCrowdActor::GetAllocatedSize() const
+{
+	SIZE_T Size = Movers.GetAllocatedSize() + LastSentSteps.GetAllocatedSize() + ProxyHandles.GetAllocatedSize()
+		+ TimeStampCollectors.GetAllocatedSize() + InstanceTransforms.GetAllocatedSize();
+	for(const FDRMover& Mover : Movers)
+	{
+		Size += Mover.ShadowClient.TimeStampCollector.GetAllocatedSize();
+	}
+	for(const FTimeStampCollector<double>& Collector : TimeStampCollectors)
+	{
+		Size += Collector.GetAllocatedSize();
+	}
+	return Size;
+}
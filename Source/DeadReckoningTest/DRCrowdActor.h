@@ -0,0 +1,155 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DRKinematicState.h"
+#include "DRMover.h"
+#include "DeadReckoningCore/DRCoreCollectors.h"
+#include "DeadReckoningCore/DRCoreFixedStep.h"
+#include "GameFramework/Actor.h"
+#include "Net/Serialization/FastArraySerializer.h"
+#include "Utilities/ClockOffsetEstimator.h"
+#include "Utilities/TimeDataCollector.h"
+#include "DRCrowdActor.generated.h"
+
+class ADRCrowdActor;
+class UInstancedStaticMeshComponent;
+struct FDRCrowdEntityArray;
+
+// Replicated state of one crowd mover
+USTRUCT()
+struct FDRCrowdEntity : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FKinematicState State;
+
+	int32 Instance = INDEX_NONE; // Instance in the crowd's mesh, client only
+
+	void PostReplicatedAdd(const FDRCrowdEntityArray& InArraySerializer);
+	void PostReplicatedChange(const FDRCrowdEntityArray& InArraySerializer);
+	void PreReplicatedRemove(const FDRCrowdEntityArray& InArraySerializer);
+};
+
+// Only the entities whose state changed are sent
+USTRUCT()
+struct FDRCrowdEntityArray : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<FDRCrowdEntity> Items;
+
+	ADRCrowdActor* Owner = nullptr;
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FDRCrowdEntity, FDRCrowdEntityArray>(Items, DeltaParms, *this);
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FDRCrowdEntityArray> : public TStructOpsTypeTraitsBase2<FDRCrowdEntityArray>
+{
+	enum { WithNetDeltaSerializer = true };
+};
+
+/**
+ * Stress test movers without an actor each. The server steps their FDRMovers and replicates
+ * the kinematic states through one fast array; clients dead reckon them in
+ * UDRDeadReckoningSubsystem as proxies, which write the positions into this actor's
+ * instanced mesh in one batch per frame.
+ */
+UCLASS()
+class DEADRECKONINGTEST_API ADRCrowdActor : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	ADRCrowdActor();
+	virtual void PostInitializeComponents() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// Server: add stress test movers [InFirstIndex, InFirstIndex + InNum), see FDRMover::InitializeStress
+	void AddStressMovers(int32 InFirstIndex, int32 InNum);
+	// Server: rendered mesh of the proxies, set before the first replication
+	void SetProxyMesh(UStaticMesh* InMesh, const FVector& InScale);
+
+	int32 Num() const { return Entities.Items.Num(); }
+	virtual SIZE_T GetAllocatedSize() const; // Non-reflected per-entity data, see DRStressTest GetBytesPerStressEntity
+
+	// Called by UDRDeadReckoningSubsystem
+	void SetProxyHandle(int32 InInstance, int32 InHandle) { ProxyHandles[InInstance] = InHandle; }
+	void SetInstanceLocation(int32 InInstance, const FVector& InLocation) { InstanceTransforms[InInstance].SetTranslation(InLocation); }
+	void FlushInstanceTransforms();
+
+protected:
+	virtual void BeginPlay() override;
+
+	// Storage of the movers and proxies, UDRMassCrowdActor keeps them in Mass entities instead
+	virtual void AddMovers(TArray<FDRMover>&& InMovers); // Server, items [Num() - InMovers.Num(), Num())
+	virtual void StepMovers(int32 InNumSteps, float In_StepTime); // Server, fills LastSentSteps and the item states
+	virtual FVector GetMoverLocation(int32 InItem, double InAlpha) const; // Server, between the last two steps
+	virtual void AddProxy(int32 InInstance, const FKinematicState& InState, float InBlendTime); // Client, instances are added in order
+	virtual void RemoveProxy(int32 InInstance);
+	virtual bool HasProxy(int32 InInstance) const;
+	virtual FVector GetProxyPosition(int32 InInstance) const; // Current prediction in world space
+	virtual void SetProxyServerState(int32 InInstance, const FKinematicState& InState, float InBlendTime);
+
+	// Written by StepMovers, possibly from worker threads, one item per mover
+	void SetStepResult(int32 InItem, int32 InLastSentStep, const FKinematicState& InState)
+	{
+		LastSentSteps[InItem] = InLastSentStep;
+		if(InLastSentStep != INDEX_NONE)
+			Entities.Items[InItem].State = InState;
+	}
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	TObjectPtr<UInstancedStaticMeshComponent> InstancedMesh;
+
+	UPROPERTY(EditAnywhere, ReplicatedUsing = OnRep_ProxyMesh)
+	TObjectPtr<UStaticMesh> ProxyMesh;
+	UPROPERTY(EditAnywhere, Replicated)
+	FVector ProxyScale = FVector::OneVector;
+
+	UPROPERTY(Replicated)
+	FDRCrowdEntityArray Entities;
+
+	UFUNCTION()
+	void OnRep_ProxyMesh();
+
+	// Server
+	DRCore::FFixedStepAccumulator ServerStepper;
+	int32 BatchSize = 256; // Minimum number of movers per parallel task
+	bool bDrawServerMotion = false; // The server only draws when it has a local view
+
+private:
+	friend struct FDRCrowdEntity;
+
+	// Client side of the fast array callbacks
+	void OnEntityAdded(FDRCrowdEntity& InOut_Entity);
+	void OnEntityChanged(const FDRCrowdEntity& InEntity);
+	void OnEntityRemoved(const FDRCrowdEntity& InEntity);
+	int32 AddInstance(const FVector& InLocation);
+
+	void SimulateServerMotion(float In_DeltaTime);
+
+	// Server
+	TArray<FDRMover> Movers; // Same order as Entities.Items
+	TArray<int32> LastSentSteps; // Per item, written by StepMovers
+
+	// Client, indexed by instance
+	TArray<int32> ProxyHandles; // UDRDeadReckoningSubsystem handles
+	TArray<FTimeStampCollector<double>> TimeStampCollectors; // Server sample times of received states
+	DRCore::EIntervalEstimate BlendTimeEstimate = DRCore::EIntervalEstimate::Mean;
+	float BlendTimePercentile = 0.9f;
+	float BlendTimeEwmaSmoothing = 0.1f;
+	FClockOffsetEstimator ServerClockOffset; // Shared by all entities, they run on the same server clock
+	static constexpr float MaxSampleAge = 0.5f; // Same as ADRPawn
+
+	// Both sides
+	TArray<FTransform> InstanceTransforms;
+};
@@ -0,0 +1,423 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "DRDeadReckoningSubsystem.h"
+
+#include "DeadReckoningTest.h"
+#include "DRCrowdActor.h"
+#include "DRPawn.h"
+#include "DRMover.h"
+#include "DRTelemetry.h"
+#include "DRWorldSettings.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "DeadReckoningCore/DRCoreExtrapolator.h"
+#include "GameFramework/PlayerController.h"
+#include "Misc/App.h"
+
+DECLARE_CYCLE_STAT(TEXT("Batched Dead Reckoning"), STAT_DRBatchedDeadReckoning, STATGROUP_DeadReckoning);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Batched Entities"), STAT_DRBatchedEntities, STATGROUP_DeadReckoning);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Batched ns/entity"), STAT_DRBatchedNsPerEntity, STATGROUP_DeadReckoning);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Batched Reduced Rate Entities"), STAT_DRBatchedReducedRate, STATGROUP_DeadReckoning);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Batched Linear Entities"), STAT_DRBatchedLinear, STATGROUP_DeadReckoning);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Batched Blend Steps"), STAT_DRBatchedBlendSteps, STATGROUP_DeadReckoning);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Per-Actor Entities"), STAT_DRPerActorEntities, STATGROUP_DeadReckoning);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Per-Actor ns/entity"), STAT_DRPerActorNsPerEntity, STATGROUP_DeadReckoning);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Round Trip ms"), STAT_DRRoundTripMs, STATGROUP_DeadReckoning);
+
+namespace DeadReckoningLOD
+{
+	constexpr float ViewConeMargin = 10.0f; // Degrees added to half the field of view, entities at the edges count as visible
+	constexpr float RenderedTolerance = 0.2f; // Seconds since an actor was last rendered for it to count as visible
+
+	// Advances one entity by In_DeltaTime, several fixed steps at once in the reduced tiers. The
+	// position before it is then put one step back along the velocity, so the render blend lags
+	// the simulation by one step as it does in the full tier. InMaxBlendFactor is the pawn's
+	// blend factor clamp, passed in by the subsystem.
+	FORCEINLINE float AdvanceEntity(FVector3f& InOut_ClientPosition, FVector3f& InOut_ClientVelocity, FVector3f& Out_PreviousClientPosition,
+		FVector3f& InOut_ServerPosition, FVector3f& InOut_ServerVelocity, const FVector3f& InServerAcceleration, float& InOut_DeadReckon_T,
+		float InAverageServerUpdateTime, bool bInLinear, float In_DeltaTime, float In_StepTime, float InMaxBlendFactor)
+	{
+		InOut_DeadReckon_T += In_DeltaTime;
+		const float T_Hat = DRCore::ComputeBlendFactor(InOut_DeadReckon_T, InAverageServerUpdateTime, InMaxBlendFactor);
+
+		Out_PreviousClientPosition = InOut_ClientPosition;
+		if(bInLinear)
+			DRCore::LinearVelocityBlend(InOut_ClientPosition, InOut_ClientVelocity, InOut_ServerPosition, InOut_ServerVelocity, T_Hat, In_DeltaTime);
+		else
+			DRCore::ProjectiveVelocityBlend(InOut_ClientPosition, InOut_ClientVelocity, InOut_ServerPosition, InOut_ServerVelocity, InServerAcceleration, T_Hat, In_DeltaTime);
+
+		if(In_DeltaTime > In_StepTime)
+			Out_PreviousClientPosition = InOut_ClientPosition - InOut_ClientVelocity * In_StepTime;
+		return T_Hat;
+	}
+}
+
+
+bool UDRDeadReckoningSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UDRDeadReckoningSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UDRDeadReckoningSubsystem, STATGROUP_Tickables);
+}
+
+void UDRDeadReckoningSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	if(const ADRWorldSettings* WorldSettings = Cast<ADRWorldSettings>(InWorld.GetWorldSettings()))
+	{
+		Stepper = WorldSettings->MakeFixedStepAccumulator();
+		bCompensateLatency = WorldSettings->bCompensateOneWayLatency;
+		bUseSignificance = WorldSettings->bUseSignificanceLOD;
+		TierSettings = WorldSettings->MakeExtrapolationTierSettings();
+		SignificanceUpdateInterval = WorldSettings->SignificanceUpdateInterval;
+	}
+}
+
+int32 UDRDeadReckoningSubsystem::RegisterPawn(ADRPawn* InPawn, const FKinematicState& InClientState, const FKinematicState& InServerState, float InAverageServerUpdateTime)
+{
+	if(InPawn == nullptr)
+		return INDEX_NONE;
+
+	Pawns.Add(InPawn);
+	Crowds.Add(nullptr);
+	ProxyInstance.Add(INDEX_NONE);
+	return AddEntity(InClientState, InServerState, InAverageServerUpdateTime);
+}
+
+int32 UDRDeadReckoningSubsystem::RegisterProxy(ADRCrowdActor* InCrowd, int32 InInstance, const FKinematicState& InServerState, float InAverageServerUpdateTime)
+{
+	if(InCrowd == nullptr)
+		return INDEX_NONE;
+
+	Pawns.Add(nullptr);
+	Crowds.Add(InCrowd);
+	ProxyInstance.Add(InInstance);
+	return AddEntity(InServerState, InServerState, InAverageServerUpdateTime);
+}
+
+int32 UDRDeadReckoningSubsystem::AddEntity(const FKinematicState& InClientState, const FKinematicState& InServerState, float InAverageServerUpdateTime)
+{
+	const int32 Handle = Origin.Num();
+	const FVector EntityOrigin = ToFVector(DRCore::ComputeRebaseOrigin(ToCore(InClientState.Position)));
+	Origin.Add(EntityOrigin);
+	ClientPosition.Add(FVector3f(InClientState.Position - EntityOrigin));
+	ClientVelocity.Add(FVector3f(InClientState.Velocity));
+	PreviousClientPosition.Add(FVector3f(InClientState.Position - EntityOrigin));
+	OldClientPosition.Add(InClientState.Position);
+	ServerPosition.AddDefaulted();
+	ServerVelocity.Add(FVector3f(InServerState.Velocity));
+	ServerAcceleration.Add(FVector3f(InServerState.Acceleration));
+	DeadReckon_T.Add(0.0f);
+	AverageServerUpdateTime.Add(InAverageServerUpdateTime);
+	Tier.Add(DRCore::EExtrapolationTier::Full);
+	PendingSteps.Add(0);
+	PendingTime.Add(0.0f);
+	SetServerPosition(Handle, InServerState.Position);
+	return Handle;
+}
+
+void UDRDeadReckoningSubsystem::Unregister(int32 InHandle)
+{
+	if(!Pawns.IsValidIndex(InHandle))
+		return;
+
+	Pawns.RemoveAtSwap(InHandle, 1, EAllowShrinking::No);
+	Crowds.RemoveAtSwap(InHandle, 1, EAllowShrinking::No);
+	ProxyInstance.RemoveAtSwap(InHandle, 1, EAllowShrinking::No);
+	Origin.RemoveAtSwap(InHandle, 1, EAllowShrinking::No);
+	ClientPosition.RemoveAtSwap(InHandle, 1, EAllowShrinking::No);
+	ClientVelocity.RemoveAtSwap(InHandle, 1, EAllowShrinking::No);
+	PreviousClientPosition.RemoveAtSwap(InHandle, 1, EAllowShrinking::No);
+	OldClientPosition.RemoveAtSwap(InHandle, 1, EAllowShrinking::No);
+	ServerPosition.RemoveAtSwap(InHandle, 1, EAllowShrinking::No);
+	ServerVelocity.RemoveAtSwap(InHandle, 1, EAllowShrinking::No);
+	ServerAcceleration.RemoveAtSwap(InHandle, 1, EAllowShrinking::No);
+	DeadReckon_T.RemoveAtSwap(InHandle, 1, EAllowShrinking::No);
+	AverageServerUpdateTime.RemoveAtSwap(InHandle, 1, EAllowShrinking::No);
+	Tier.RemoveAtSwap(InHandle, 1, EAllowShrinking::No);
+	PendingSteps.RemoveAtSwap(InHandle, 1, EAllowShrinking::No);
+	PendingTime.RemoveAtSwap(InHandle, 1, EAllowShrinking::No);
+
+	// The last entity was moved into the freed slot
+	if(Pawns.IsValidIndex(InHandle) && Pawns[InHandle] != nullptr)
+	{
+		Pawns[InHandle]->DeadReckoningHandle = InHandle;
+	}
+	else if(Crowds.IsValidIndex(InHandle) && Crowds[InHandle] != nullptr)
+	{
+		Crowds[InHandle]->SetProxyHandle(ProxyInstance[InHandle], InHandle);
+	}
+}
+
+void UDRDeadReckoningSubsystem::SetServerState(int32 InHandle, const FKinematicState& InServerState, float InAverageServerUpdateTime)
+{
+	if(!Pawns.IsValidIndex(InHandle))
+		return;
+
+	// Entities in a reduced tier are behind by their pending steps, they catch up on the old state first
+	if(PendingTime[InHandle] > 0.0f)
+	{
+		DeadReckoningLOD::AdvanceEntity(ClientPosition[InHandle], ClientVelocity[InHandle], PreviousClientPosition[InHandle], ServerPosition[InHandle],
+			ServerVelocity[InHandle], ServerAcceleration[InHandle], DeadReckon_T[InHandle], AverageServerUpdateTime[InHandle],
+			Tier[InHandle] == DRCore::EExtrapolationTier::Linear, PendingTime[InHandle], static_cast<float>(Stepper.GetStepTime()), ADRPawn::MaxDeadReckon_T_Hat);
+	}
+	PendingSteps[InHandle] = 0;
+	PendingTime[InHandle] = 0.0f;
+
+	SetServerPosition(InHandle, InServerState.Position);
+	ServerVelocity[InHandle] = FVector3f(InServerState.Velocity);
+	ServerAcceleration[InHandle] = FVector3f(InServerState.Acceleration);
+	DeadReckon_T[InHandle] = 0.0f;
+	AverageServerUpdateTime[InHandle] = InAverageServerUpdateTime;
+}
+
+FVector UDRDeadReckoningSubsystem::GetClientPosition(int32 InHandle) const
+{
+	return Origin.IsValidIndex(InHandle) ? Origin[InHandle] + FVector(ClientPosition[InHandle]) : FVector::ZeroVector;
+}
+
+void UDRDeadReckoningSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	// The clock keeps running without entities so newly registered ones join in step
+	const int32 NumSteps = Stepper.Advance(DeltaTime);
+	UpdateRoundTripTime();
+	UpdateView();
+	PublishPerActorStats();
+	const int32 NumEntities = Pawns.Num();
+	if(NumEntities == 0)
+		return;
+
+	SCOPE_CYCLE_COUNTER(STAT_DRBatchedDeadReckoning);
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+
+	const double Now = GetWorld()->GetTimeSeconds();
+	if(bHasView && Now >= NextSignificanceTime)
+	{
+		NextSignificanceTime = Now + SignificanceUpdateInterval;
+		UpdateSignificance();
+	}
+
+	ExtrapolateAll(NumSteps, static_cast<float>(Stepper.GetStepTime()));
+	WriteBackTransforms();
+
+	const double ElapsedNs = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles) * 1000000.0;
+	SET_DWORD_STAT(STAT_DRBatchedEntities, NumEntities);
+	SET_FLOAT_STAT(STAT_DRBatchedNsPerEntity, ElapsedNs / NumEntities);
+}
+
+// Received states are stamped with the server time they were sampled at. Their clock offset
+// includes the fastest one-way delay, so only the connection's round trip tells how far the
+// server has moved on since. AvgLag is measured by the engine from packet acks.
+void UDRDeadReckoningSubsystem::UpdateRoundTripTime()
+{
+	const UNetDriver* NetDriver = bCompensateLatency ? GetWorld()->GetNetDriver() : nullptr;
+	const UNetConnection* Connection = NetDriver != nullptr ? NetDriver->ServerConnection.Get() : nullptr;
+	RoundTripTime = Connection != nullptr ? static_cast<float>(Connection->AvgLag) : 0.0f;
+	SET_FLOAT_STAT(STAT_DRRoundTripMs, RoundTripTime * 1000.0f);
+}
+
+// Tickable objects tick after the actors, so this is the cost of the per-actor pawns of this frame
+void UDRDeadReckoningSubsystem::PublishPerActorStats()
+{
+	if(NumPerActor == 0)
+		return;
+
+	const double ElapsedNs = FPlatformTime::ToMilliseconds64(PerActorCycles) * 1000000.0;
+	SET_DWORD_STAT(STAT_DRPerActorEntities, NumPerActor);
+	SET_FLOAT_STAT(STAT_DRPerActorNsPerEntity, ElapsedNs / NumPerActor);
+	PerActorCycles = 0;
+	NumPerActor = 0;
+}
+
+// Per-actor pawns use the same view, refreshed every frame for them
+void UDRDeadReckoningSubsystem::UpdateView()
+{
+	const APlayerController* PlayerController = bUseSignificance ? GetWorld()->GetFirstPlayerController() : nullptr;
+	bHasView = PlayerController != nullptr && PlayerController->IsLocalController();
+	if(!bHasView)
+		return;
+
+	FRotator ViewRotation;
+	PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+	ViewDirection = ViewRotation.Vector();
+	const float HalfFov = PlayerController->PlayerCameraManager != nullptr ? PlayerController->PlayerCameraManager->GetFOVAngle() * 0.5f : 45.0f;
+	ViewConeCos = FMath::Cos(FMath::DegreesToRadians(FMath::Min(HalfFov + DeadReckoningLOD::ViewConeMargin, 180.0f)));
+}
+
+DRCore::EExtrapolationTier UDRDeadReckoningSubsystem::ClassifySignificance(const FVector& InLocation, const AActor* InActor, DRCore::EExtrapolationTier InCurrent) const
+{
+	if(!bHasView)
+		return DRCore::EExtrapolationTier::Full;
+
+	const FVector ToEntity = InLocation - ViewLocation;
+	const double Distance = ToEntity.Size();
+	bool bVisible = FVector::DotProduct(ToEntity, ViewDirection) >= ViewConeCos * Distance;
+
+	// Occlusion comes from the renderer, which never marks actors as rendered without an output
+	if(bVisible && InActor != nullptr && FApp::CanEverRender())
+		bVisible = InActor->WasRecentlyRendered(DeadReckoningLOD::RenderedTolerance);
+	return TierSettings.Classify(Distance, bVisible, InCurrent);
+}
+
+void UDRDeadReckoningSubsystem::UpdateSignificance()
+{
+	const int32 NumEntities = Pawns.Num();
+	for(int32 i = 0; i < NumEntities; ++i)
+	{
+		const DRCore::EExtrapolationTier NewTier = ClassifySignificance(Origin[i] + FVector(ClientPosition[i]), Pawns[i], Tier[i]);
+
+		// Entities demoted together are spread over the steps of the interval instead of all advancing on the same one
+		if(Tier[i] == DRCore::EExtrapolationTier::Full && NewTier != DRCore::EExtrapolationTier::Full)
+			PendingSteps[i] = static_cast<uint8>(i % TierSettings.GetStepInterval(NewTier));
+		Tier[i] = NewTier;
+	}
+}
+
+// Same projective velocity blending as ADRPawn::DeadReckoningMove, for every entity at once.
+// Entities in a reduced tier collect their steps and advance once every few of them. Each step
+// first compacts the entities due on it into one list per blend model, without a branch, and
+// then blends the lists, so the blend loops test neither the tier nor the pending steps.
+void UDRDeadReckoningSubsystem::ExtrapolateAll(int32 InNumSteps, float In_StepTime)
+{
+	const int32 NumEntities = Pawns.Num();
+
+	FVector3f* RESTRICT Cp = ClientPosition.GetData();
+	FVector3f* RESTRICT Cv = ClientVelocity.GetData();
+	FVector3f* RESTRICT PrevCp = PreviousClientPosition.GetData();
+	FVector3f* RESTRICT Sp = ServerPosition.GetData();
+	FVector3f* RESTRICT Sv = ServerVelocity.GetData();
+	const FVector3f* RESTRICT Sa = ServerAcceleration.GetData();
+	float* RESTRICT T = DeadReckon_T.GetData();
+	const float* RESTRICT AvgT = AverageServerUpdateTime.GetData();
+	const DRCore::EExtrapolationTier* RESTRICT Tiers = Tier.GetData();
+	uint8* RESTRICT Pending = PendingSteps.GetData();
+	float* RESTRICT PendingT = PendingTime.GetData();
+	uint32 BlendFactorHistogram[FDRTelemetryWindow::NumBlendBuckets] = {};
+	uint32 NumPerTier[3] = {};
+	uint32 NumBlendSteps = 0;
+
+	const int32 StepIntervals[3] = { TierSettings.GetStepInterval(DRCore::EExtrapolationTier::Full),
+		TierSettings.GetStepInterval(DRCore::EExtrapolationTier::ReducedRate), TierSettings.GetStepInterval(DRCore::EExtrapolationTier::Linear) };
+	for(int32 i = 0; i < NumEntities; ++i)
+	{
+		++NumPerTier[static_cast<int32>(Tiers[i])];
+	}
+
+	// Index 0 blends projectively, index 1 linearly
+	for(int32 Model = 0; Model < 2; ++Model)
+	{
+		DueIndex[Model].SetNumUninitialized(NumEntities, EAllowShrinking::No);
+		DueTime[Model].SetNumUninitialized(NumEntities, EAllowShrinking::No);
+	}
+	int32* RESTRICT DueIndices[2] = { DueIndex[0].GetData(), DueIndex[1].GetData() };
+	float* RESTRICT DueTimes[2] = { DueTime[0].GetData(), DueTime[1].GetData() };
+
+	for(int32 Step = 0; Step < InNumSteps; ++Step)
+	{
+		int32 NumDue[2] = {};
+		for(int32 i = 0; i < NumEntities; ++i)
+		{
+			const int32 Model = Tiers[i] == DRCore::EExtrapolationTier::Linear;
+			const float Time = PendingT[i] + In_StepTime;
+			const bool bDue = Pending[i] + 1 >= StepIntervals[static_cast<int32>(Tiers[i])];
+
+			// Always written, kept only when due
+			DueIndices[Model][NumDue[Model]] = i;
+			DueTimes[Model][NumDue[Model]] = Time;
+			NumDue[Model] += bDue;
+			Pending[i] = static_cast<uint8>(bDue ? 0 : Pending[i] + 1);
+			PendingT[i] = bDue ? 0.0f : Time;
+		}
+
+		for(int32 j = 0; j < NumDue[0]; ++j)
+		{
+			const int32 i = DueIndices[0][j];
+			const float T_Hat = DeadReckoningLOD::AdvanceEntity(Cp[i], Cv[i], PrevCp[i], Sp[i], Sv[i], Sa[i], T[i], AvgT[i], false, DueTimes[0][j], In_StepTime, ADRPawn::MaxDeadReckon_T_Hat);
+			++BlendFactorHistogram[FDRTelemetry::GetBlendBucket(T_Hat, ADRPawn::MaxDeadReckon_T_Hat)];
+		}
+		for(int32 j = 0; j < NumDue[1]; ++j)
+		{
+			const int32 i = DueIndices[1][j];
+			const float T_Hat = DeadReckoningLOD::AdvanceEntity(Cp[i], Cv[i], PrevCp[i], Sp[i], Sv[i], Sa[i], T[i], AvgT[i], true, DueTimes[1][j], In_StepTime, ADRPawn::MaxDeadReckon_T_Hat);
+			++BlendFactorHistogram[FDRTelemetry::GetBlendBucket(T_Hat, ADRPawn::MaxDeadReckon_T_Hat)];
+		}
+		NumBlendSteps += NumDue[0] + NumDue[1];
+	}
+
+	FDRTelemetry::Get().RecordBlendFactors(BlendFactorHistogram);
+	SET_DWORD_STAT(STAT_DRBatchedReducedRate, NumPerTier[static_cast<int32>(DRCore::EExtrapolationTier::ReducedRate)]);
+	SET_DWORD_STAT(STAT_DRBatchedLinear, NumPerTier[static_cast<int32>(DRCore::EExtrapolationTier::Linear)]);
+	SET_DWORD_STAT(STAT_DRBatchedBlendSteps, NumBlendSteps);
+}
+
+// Pawns are separate actors, so each one still moves its own root component. Only the crowd
+// instances are written in one batch per crowd.
+void UDRDeadReckoningSubsystem::WriteBackTransforms()
+{
+	const int32 NumEntities = Pawns.Num();
+	const float Alpha = static_cast<float>(Stepper.GetAlpha());
+	const float StepTime = static_cast<float>(Stepper.GetStepTime());
+	constexpr float MaxOffsetSquared = static_cast<float>(DRCore::DefaultRebaseDistance * DRCore::DefaultRebaseDistance);
+	TArray<ADRCrowdActor*, TInlineAllocator<4>> UpdatedCrowds;
+	for(int32 i = 0; i < NumEntities; ++i)
+	{
+		if(ClientPosition[i].SizeSquared() > MaxOffsetSquared || ServerPosition[i].SizeSquared() > MaxOffsetSquared)
+		{
+			Rebase(i, Origin[i] + FVector(ClientPosition[i]));
+		}
+
+		// Widened to world space only here. Entities waiting on pending steps are carried along their
+		// velocity from the last one they advanced, one step behind like the blend of the others.
+		const FVector3f RenderOffset = PendingTime[i] == 0.0f ? FMath::Lerp(PreviousClientPosition[i], ClientPosition[i], Alpha)
+			: ClientPosition[i] + ClientVelocity[i] * (PendingTime[i] - StepTime * (1.0f - Alpha));
+		const FVector RenderPosition = Origin[i] + FVector(RenderOffset);
+		if(ADRPawn* Pawn = Pawns[i])
+		{
+			Pawn->Client_KinematicState.Position = Origin[i] + FVector(ClientPosition[i]);
+			Pawn->Client_KinematicState.Velocity = FVector(ClientVelocity[i]);
+			Pawn->SetActorLocation(RenderPosition);
+			Pawn->DrawShape(OldClientPosition[i], RenderPosition, FColor::Red, 5.0f);
+		}
+		else
+		{
+			ADRCrowdActor* Crowd = Crowds[i];
+			Crowd->SetInstanceLocation(ProxyInstance[i], RenderPosition);
+			if(UpdatedCrowds.Num() == 0 || UpdatedCrowds.Last() != Crowd)
+				UpdatedCrowds.AddUnique(Crowd);
+		}
+		OldClientPosition[i] = RenderPosition;
+	}
+
+	for(ADRCrowdActor* Crowd : UpdatedCrowds)
+	{
+		Crowd->FlushInstanceTransforms();
+	}
+}
+
+void UDRDeadReckoningSubsystem::Rebase(int32 InIndex, const FVector& InPosition)
+{
+	const FVector OldOrigin = Origin[InIndex];
+	const FVector NewOrigin = ToFVector(DRCore::ComputeRebaseOrigin(ToCore(InPosition)));
+	ClientPosition[InIndex] = FVector3f(OldOrigin - NewOrigin + FVector(ClientPosition[InIndex]));
+	PreviousClientPosition[InIndex] = FVector3f(OldOrigin - NewOrigin + FVector(PreviousClientPosition[InIndex]));
+	ServerPosition[InIndex] = FVector3f(OldOrigin - NewOrigin + FVector(ServerPosition[InIndex]));
+	Origin[InIndex] = NewOrigin;
+}
+
+// The offset is taken in double from an origin near InPosition, so a state far from the client keeps its precision
+void UDRDeadReckoningSubsystem::SetServerPosition(int32 InIndex, const FVector& InPosition)
+{
+	if((InPosition - Origin[InIndex]).SizeSquared() > FMath::Square(DRCore::DefaultRebaseDistance))
+	{
+		Rebase(InIndex, InPosition);
+	}
+	ServerPosition[InIndex] = FVector3f(InPosition - Origin[InIndex]);
+}
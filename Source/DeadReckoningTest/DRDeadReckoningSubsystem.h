@@ -0,0 +1,125 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DeadReckoningCore/DRCoreExtrapolator.h"
+#include "DeadReckoningCore/DRCoreFixedStep.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "DRDeadReckoningSubsystem.generated.h"
+
+class ADRCrowdActor;
+class ADRPawn;
+struct FKinematicState;
+
+/**
+ * Runs client-side dead reckoning for every registered pawn in one pass per frame.
+ * Client/server kinematic states are kept in structure-of-arrays form so the
+ * projective velocity blending loop walks contiguous memory. Positions are float32
+ * offsets from a per-entity double origin (DRCore::FRebasedBlendingExtrapolator), so
+ * the loop runs in float at any distance from the world origin; they are widened
+ * only when written to the actor. Crowd proxies have no actor, their positions are
+ * written into the instanced mesh of their ADRCrowdActor in one batch per crowd.
+ * With significance LOD, entities far from the local view or hidden are moved to a
+ * DRCore::EExtrapolationTier that advances several fixed steps at once, and are
+ * rendered by extrapolating their velocity in between.
+ */
+UCLASS()
+class DEADRECKONINGTEST_API UDRDeadReckoningSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	// Returns a handle used for the other calls, INDEX_NONE if registration failed
+	int32 RegisterPawn(ADRPawn* InPawn, const FKinematicState& InClientState, const FKinematicState& InServerState, float InAverageServerUpdateTime);
+	// Entity without an actor, rendered as instance InInstance of InCrowd
+	int32 RegisterProxy(ADRCrowdActor* InCrowd, int32 InInstance, const FKinematicState& InServerState, float InAverageServerUpdateTime);
+	void Unregister(int32 InHandle);
+
+	// Called when a new server state has been received for the entity
+	void SetServerState(int32 InHandle, const FKinematicState& InServerState, float InAverageServerUpdateTime);
+
+	// Current prediction in world space
+	FVector GetClientPosition(int32 InHandle) const;
+
+	int32 Num() const { return Pawns.Num(); }
+
+	// Cost of one per-actor ADRPawn::DeadReckoningMove, shown per entity next to the batched cost
+	void RecordPerActorCycles(uint64 InCycles) { PerActorCycles += InCycles; ++NumPerActor; }
+
+	// Round trip to the server in seconds for FClockOffsetEstimator::GetLastSampleAge, 0 without latency compensation
+	float GetRoundTripTime() const { return RoundTripTime; }
+
+	// Tier of an entity at InLocation given its current one, Full without a local view.
+	// InActor is checked for recent rendering, entities without one only for the view cone.
+	DRCore::EExtrapolationTier ClassifySignificance(const FVector& InLocation, const AActor* InActor, DRCore::EExtrapolationTier InCurrent) const;
+	bool IsSignificanceEnabled() const { return bUseSignificance; }
+	int32 GetStepInterval(DRCore::EExtrapolationTier InTier) const { return TierSettings.GetStepInterval(InTier); }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	void UpdateRoundTripTime();
+	void PublishPerActorStats();
+	void UpdateView();
+	void UpdateSignificance();
+	void ExtrapolateAll(int32 InNumSteps, float In_StepTime);
+	void WriteBackTransforms();
+	void Rebase(int32 InIndex, const FVector& InPosition); // Move the origin of entity InIndex to the cell InPosition is in
+	void SetServerPosition(int32 InIndex, const FVector& InPosition); // Narrow InPosition, rebasing towards it first when it is out of range
+	int32 AddEntity(const FKinematicState& InClientState, const FKinematicState& InServerState, float InAverageServerUpdateTime);
+
+	DRCore::FFixedStepAccumulator Stepper; // One clock for all entities, the render position is blended between the last two steps
+
+	bool bCompensateLatency = false;
+	float RoundTripTime = 0.0f; // Refreshed every frame from the server connection
+
+	uint64 PerActorCycles = 0; // Summed over the per-actor pawns ticked since the last publish
+	int32 NumPerActor = 0;
+
+	bool bUseSignificance = false;
+	DRCore::FExtrapolationTierSettings TierSettings;
+	float SignificanceUpdateInterval = 0.25f;
+	double NextSignificanceTime = 0.0;
+	bool bHasView = false; // Local view of the first player controller, refreshed every frame
+	FVector ViewLocation = FVector::ZeroVector;
+	FVector ViewDirection = FVector::ForwardVector;
+	float ViewConeCos = 0.0f;
+
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<ADRPawn>> Pawns; // Null for proxies
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<ADRCrowdActor>> Crowds; // Null for pawns
+	TArray<int32> ProxyInstance; // Instance in the crowd's mesh, INDEX_NONE for pawns
+
+	TArray<FVector> Origin; // Positions below are relative to it, moved when they exceed DRCore::DefaultRebaseDistance
+
+	// Client's predicted state
+	TArray<FVector3f> ClientPosition;
+	TArray<FVector3f> ClientVelocity;
+	TArray<FVector3f> PreviousClientPosition; // Before the last step
+	TArray<FVector> OldClientPosition; // Rendered last frame, world space
+
+	// Last received server state, extrapolated forward every frame
+	TArray<FVector3f> ServerPosition;
+	TArray<FVector3f> ServerVelocity;
+	TArray<FVector3f> ServerAcceleration;
+
+	// Blending timers
+	TArray<float> DeadReckon_T;
+	TArray<float> AverageServerUpdateTime;
+
+	// Significance LOD
+	TArray<DRCore::EExtrapolationTier> Tier;
+	TArray<uint8> PendingSteps; // Fixed steps not yet advanced, always 0 in the full tier
+	TArray<float> PendingTime; // Their total length
+
+	// Entities due on the current step and the time they advance by, projective blend at 0 and linear at 1. Reused every frame.
+	TArray<int32> DueIndex[2];
+	TArray<float> DueTime[2];
+};
@@ -2,3 +2,227 @@
 
 
 #include "DRGameMode.h"
+
+#include "DRController.h"
+#include "DRCrowdActor.h"
+#include "DRMassCrowdActor.h"
+#include "DRPawn.h"
+#include "DRWorldSettings.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "TimerManager.h"
+
+
+void ADRGameMode::StartPlay()
+{
+	Super::StartPlay();
+
+	const ADRWorldSettings* WorldSettings = Cast<ADRWorldSettings>(GetWorldSettings());
+	if(WorldSettings != nullptr && WorldSettings->StressTest.bEnabled)
+	{
+		UE_LOG(LogTemp, Log, TEXT("Stress test: spawning %d movers"), WorldSettings->StressTest.NumMovers);
+		GetWorldTimerManager().SetTimer(StressTimer, this, &ADRGameMode::SpawnStressBatch,
+			FMath::Max(WorldSettings->StressTest.SpawnBatchInterval, 0.01f), true, 0.0f);
+	}
+}
+
+// Caps the bytes the net driver sends to each client per second, so the pawns it has to leave out
+// of a frame are the ones the replication priority ranks last
+void ADRGameMode::PostLogin(APlayerController* NewPlayer)
+{
+	Super::PostLogin(NewPlayer);
+
+	const ADRWorldSettings* WorldSettings = Cast<ADRWorldSettings>(GetWorldSettings());
+	UNetConnection* Connection = NewPlayer != nullptr ? NewPlayer->GetNetConnection() : nullptr;
+	if(WorldSettings != nullptr && Connection != nullptr && WorldSettings->ConnectionBudgetBytesPerSecond > 0)
+	{
+		Connection->CurrentNetSpeed = WorldSettings->ConnectionBudgetBytesPerSecond;
+	}
+	if(WorldSettings != nullptr && WorldSettings->bErrorPriorityScheduling && Connection != nullptr && Connection->Driver != nullptr && Connection->Driver->IsUsingIrisReplication())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("bErrorPriorityScheduling has no effect under Iris, pawns keep the default prioritization"));
+	}
+}
+
+void ADRGameMode::SpawnStressBatch()
+{
+	const FDRStressTestSettings& Settings = CastChecked<ADRWorldSettings>(GetWorldSettings())->StressTest;
+
+	UClass* PawnClass = StressPawnClass;
+	if(PawnClass == nullptr)
+	{
+		PawnClass = DefaultPawnClass != nullptr && DefaultPawnClass->IsChildOf<ADRPawn>() ? DefaultPawnClass.Get() : ADRPawn::StaticClass();
+	}
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	SpawnParams.bDeferConstruction = true; // The index has to be set before BeginPlay picks the motion
+
+	const int32 BatchEnd = FMath::Min(NumStressPawns + Settings.SpawnBatchSize, Settings.NumMovers);
+	if(Settings.bUseCrowdProxies)
+	{
+		if(CrowdActor == nullptr)
+		{
+			UClass* CrowdClass = CrowdActorClass;
+			if(CrowdClass == nullptr)
+			{
+				CrowdClass = Settings.bUseMassEntities ? ADRMassCrowdActor::StaticClass() : ADRCrowdActor::StaticClass();
+			}
+			CrowdActor = GetWorld()->SpawnActor<ADRCrowdActor>(CrowdClass, FTransform::Identity, SpawnParams);
+			// Proxies look like the pawns they replace
+			const UStaticMeshComponent* PawnMesh = PawnClass->GetDefaultObject<ADRPawn>()->BaseMesh;
+			CrowdActor->SetProxyMesh(PawnMesh->GetStaticMesh(), PawnMesh->GetRelativeScale3D());
+			CrowdActor->FinishSpawning(FTransform::Identity);
+		}
+		CrowdActor->AddStressMovers(NumStressPawns, BatchEnd - NumStressPawns);
+		NumStressPawns = BatchEnd;
+	}
+	for(; NumStressPawns < BatchEnd; ++NumStressPawns)
+	{
+		if(ADRPawn* Pawn = GetWorld()->SpawnActor<ADRPawn>(PawnClass, FTransform::Identity, SpawnParams))
+		{
+			Pawn->SetStressIndex(NumStressPawns);
+			Pawn->FinishSpawning(FTransform::Identity);
+		}
+	}
+
+	if(NumStressPawns >= Settings.NumMovers)
+	{
+		UE_LOG(LogTemp, Log, TEXT("Stress test: %d movers spawned, measuring in %.1fs"), NumStressPawns, Settings.WarmupTime);
+		GetWorldTimerManager().ClearTimer(StressTimer);
+		if(Settings.WarmupTime > 0.0f)
+			GetWorldTimerManager().SetTimer(StressTimer, this, &ADRGameMode::BeginStressMeasurement, Settings.WarmupTime, false);
+		else
+			BeginStressMeasurement();
+	}
+}
+
+void ADRGameMode::BeginStressMeasurement()
+{
+	const FDRStressTestSettings& Settings = CastChecked<ADRWorldSettings>(GetWorldSettings())->StressTest;
+
+	StressRecorder.Start(GetWorld());
+	PendingClients.Reset();
+	ClientResults.Reset();
+
+	// Local controllers share the server world, they would only measure it twice
+	for(FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		ADRController* Controller = Cast<ADRController>(It->Get());
+		if(Controller != nullptr && !Controller->IsLocalController())
+		{
+			Controller->ClientBeginStressMeasurement(Settings.MeasurementTime);
+			PendingClients.Add(Controller);
+		}
+	}
+
+	GetWorldTimerManager().SetTimer(StressTimer, this, &ADRGameMode::EndStressMeasurement, Settings.MeasurementTime, false);
+}
+
+void ADRGameMode::EndStressMeasurement()
+{
+	ServerResult = StressRecorder.Stop();
+
+	if(PendingClients.Num() > 0)
+	{
+		const float Timeout = CastChecked<ADRWorldSettings>(GetWorldSettings())->StressTest.ClientReportTimeout;
+		GetWorldTimerManager().SetTimer(StressTimer, this, &ADRGameMode::WriteStressReport, FMath::Max(Timeout, 0.01f), false);
+	}
+	else
+	{
+		WriteStressReport();
+	}
+}
+
+void ADRGameMode::ReportClientStressResult(ADRController* InController, const FDRStressTestResult& InResult)
+{
+	if(PendingClients.Remove(InController) == 0)
+		return;
+
+	ClientResults.Add(InResult);
+	if(PendingClients.Num() == 0 && !StressRecorder.IsRecording())
+	{
+		GetWorldTimerManager().ClearTimer(StressTimer);
+		WriteStressReport();
+	}
+}
+
+void ADRGameMode::WriteStressReport()
+{
+	const ADRWorldSettings* WorldSettings = CastChecked<ADRWorldSettings>(GetWorldSettings());
+	const FDRStressTestSettings& Settings = WorldSettings->StressTest;
+	if(PendingClients.Num() > 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Stress test: %d clients did not report in time"), PendingClients.Num());
+		PendingClients.Reset();
+	}
+
+	// Clients are averaged, the worst frame is kept
+	FDRStressTestResult Client;
+	for(const FDRStressTestResult& Result : ClientResults)
+	{
+		Client.FrameMs += Result.FrameMs / ClientResults.Num();
+		Client.MaxFrameMs = FMath::Max(Client.MaxFrameMs, Result.MaxFrameMs);
+		Client.WorldTickMs += Result.WorldTickMs / ClientResults.Num();
+		Client.BytesPerSecond += Result.BytesPerSecond / ClientResults.Num();
+		Client.UpdatesPerSecond += Result.UpdatesPerSecond / ClientResults.Num();
+		Client.MeanError += Result.MeanError / ClientResults.Num();
+		Client.RmsError += Result.RmsError / ClientResults.Num();
+		Client.BytesPerEntity += Result.BytesPerEntity / ClientResults.Num();
+		Client.StateAgeMs += Result.StateAgeMs / ClientResults.Num();
+		Client.DroppedPerSecond += Result.DroppedPerSecond / ClientResults.Num();
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("Stress test: %d %s over %.1fs. Server frame %.2f ms (max %.2f), world tick %.2f ms, %.0f B/s, %.1f updates/s, %.0f B/mover"),
+		NumStressPawns, Settings.bUseCrowdProxies ? (Settings.bUseMassEntities ? TEXT("Mass proxies") : TEXT("proxies")) : TEXT("movers"), ServerResult.Duration, ServerResult.FrameMs, ServerResult.MaxFrameMs,
+		ServerResult.WorldTickMs, ServerResult.BytesPerSecond, ServerResult.UpdatesPerSecond, ServerResult.BytesPerEntity);
+	UE_LOG(LogTemp, Log, TEXT("Stress test: %d clients. Frame %.2f ms (max %.2f), world tick %.2f ms, %.0f B/s, %.1f updates/s, prediction error mean %.2f, rms %.2f, state age %.1f ms, %.1f dropped/s, %.0f B/mover"),
+		ClientResults.Num(), Client.FrameMs, Client.MaxFrameMs, Client.WorldTickMs, Client.BytesPerSecond, Client.UpdatesPerSecond, Client.MeanError, Client.RmsError,
+		Client.StateAgeMs, Client.DroppedPerSecond, Client.BytesPerEntity);
+
+	const UNetDriver* NetDriver = GetWorld()->GetNetDriver();
+	const bool bIris = NetDriver != nullptr && NetDriver->IsUsingIrisReplication();
+
+	// Network emulation of the server's outgoing packets (-PktLoss=, -PktLag=, Net PktOrder=1, ...), which carry the states
+	FPacketSimulationSettings PacketSimulation;
+#if DO_ENABLE_NET_TEST
+	if(NetDriver != nullptr)
+		PacketSimulation = NetDriver->PacketSimulationSettings;
+#endif
+
+	// One row per run, so runs before and after a change end up in the same file. A file written
+	// with other columns is moved aside and a new one is started, so every row matches its header.
+	const FString FileName = FPaths::ProjectSavedDir() / TEXT("DeadReckoning") / TEXT("StressTest.csv");
+	const FString Header = TEXT("Date,Map,Movers,Proxies,Iris,LOD,Transport,PktLoss,PktLag,PktLagVariance,PktOrder,CircleFraction,Seed,Duration,ServerFrameMs,ServerMaxFrameMs,ServerWorldTickMs,ServerBytesPerSecond,ServerUpdatesPerSecond,ServerBytesPerMover,")
+		TEXT("Clients,ClientFrameMs,ClientMaxFrameMs,ClientWorldTickMs,ClientBytesPerSecond,ClientUpdatesPerSecond,MeanPredictionError,RmsPredictionError,ClientBytesPerMover,StateAgeMs,DroppedPerSecond");
+	FString Existing;
+	if(FFileHelper::LoadFileToString(Existing, *FileName))
+	{
+		FString FirstLine;
+		Existing.Split(TEXT("\n"), &FirstLine, nullptr);
+		if(FirstLine.TrimEnd() != Header)
+		{
+			const FString OldFileName = FPaths::GetBaseFilename(FileName, false) + TEXT("-") + FDateTime::Now().ToString() + TEXT(".csv");
+			IFileManager::Get().Move(*OldFileName, *FileName);
+			UE_LOG(LogTemp, Log, TEXT("Stress test: columns changed, moved the previous results to %s"), *OldFileName);
+		}
+	}
+	FString Report;
+	if(!FPaths::FileExists(FileName))
+	{
+		Report = Header + TEXT("\n");
+	}
+	Report += FString::Printf(TEXT("%s,%s,%d,%d,%d,%d,%d,%d,%d,%d,%d,%.2f,%d,%.2f,%.3f,%.3f,%.3f,%.1f,%.2f,%.0f,%d,%.3f,%.3f,%.3f,%.1f,%.2f,%.3f,%.3f,%.0f,%.2f,%.2f\n"),
+		*FDateTime::Now().ToString(), *GetWorld()->GetMapName(), NumStressPawns, Settings.bUseCrowdProxies ? (Settings.bUseMassEntities ? 2 : 1) : 0, bIris ? 1 : 0, WorldSettings->bUseSignificanceLOD ? 1 : 0,
+		static_cast<int32>(WorldSettings->KinematicTransport), PacketSimulation.PktLoss, PacketSimulation.PktLag, PacketSimulation.PktLagVariance, PacketSimulation.PktOrder, Settings.CircleFraction, Settings.Seed, ServerResult.Duration,
+		ServerResult.FrameMs, ServerResult.MaxFrameMs, ServerResult.WorldTickMs, ServerResult.BytesPerSecond, ServerResult.UpdatesPerSecond, ServerResult.BytesPerEntity,
+		ClientResults.Num(), Client.FrameMs, Client.MaxFrameMs, Client.WorldTickMs, Client.BytesPerSecond, Client.UpdatesPerSecond, Client.MeanError, Client.RmsError,
+		Client.BytesPerEntity, Client.StateAgeMs, Client.DroppedPerSecond);
+	FFileHelper::SaveStringToFile(Report, *FileName, FFileHelper::EEncodingOptions::AutoDetect, &IFileManager::Get(), FILEWRITE_Append);
+	UE_LOG(LogTemp, Log, TEXT("Stress test: results appended to %s"), *FileName);
+}
@@ -3,14 +3,48 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "DRStressTest.h"
 #include "GameFramework/GameModeBase.h"
 #include "DRGameMode.generated.h"
 
+class ADRController;
+class ADRCrowdActor;
+class ADRPawn;
+
 /**
- * 
+ * Spawns the stress test movers of FDRStressTestSettings in batches, measures the server
+ * and every remote client for a fixed time and appends the results to
+ * Saved/DeadReckoning/StressTest.csv.
  */
 UCLASS()
 class DEADRECKONINGTEST_API ADRGameMode : public AGameModeBase
 {
 	GENERATED_BODY()
+
+public:
+	virtual void StartPlay() override;
+	virtual void PostLogin(APlayerController* NewPlayer) override;
+
+	void ReportClientStressResult(ADRController* InController, const FDRStressTestResult& InResult);
+
+protected:
+	UPROPERTY(EditAnywhere, Category = "Stress Test")
+	TSubclassOf<ADRPawn> StressPawnClass; // Default pawn class when empty and derived from ADRPawn, ADRPawn otherwise
+	UPROPERTY(EditAnywhere, Category = "Stress Test")
+	TSubclassOf<ADRCrowdActor> CrowdActorClass; // Spawned once when FDRStressTestSettings::bUseCrowdProxies is set, ADRCrowdActor or ADRMassCrowdActor when empty
+
+private:
+	void SpawnStressBatch();
+	void BeginStressMeasurement();
+	void EndStressMeasurement();
+	void WriteStressReport();
+
+	int32 NumStressPawns = 0;
+	UPROPERTY(Transient)
+	TObjectPtr<ADRCrowdActor> CrowdActor; // Holds all stress movers when they are proxies
+	FTimerHandle StressTimer;
+	FDRStressRecorder StressRecorder;
+	FDRStressTestResult ServerResult;
+	TArray<TWeakObjectPtr<ADRController>> PendingClients; // Measured clients that have not reported yet
+	TArray<FDRStressTestResult> ClientResults;
 };
@@ -0,0 +1,354 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "DRKinematicState.h"
+
+#include "DRKinematicStateNetSerializer.h"
+#include "DRTelemetry.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "Engine/PackageMapClient.h"
+#include "Serialization/BitReader.h"
+#include "Serialization/BitWriter.h"
+
+static FAutoConsoleCommand CmdCheckQuantization(
+	TEXT("DR.CheckQuantization"),
+	TEXT("Round-trip kinematic states through NetSerialize and the Iris serializer, with the world's quantization and with quantization disabled, and log whether every component stays within the error bounds."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		const FKinematicStateQuantization& WorldQuantization = FKinematicStateQuantization::Get(World);
+		FKinematicStateQuantization Disabled = WorldQuantization;
+		Disabled.bEnabled = false;
+		for(const FKinematicStateQuantization& Quantization : { WorldQuantization, Disabled })
+		{
+			FKinematicState::CheckRoundTrip(Quantization, TEXT("NetSerialize"), &FKinematicState::RoundTripNetSerialize);
+#if UE_WITH_IRIS
+			FKinematicState::CheckRoundTrip(Quantization, TEXT("Iris"), [](const FKinematicStateQuantization& InQuantization, const FKinematicState& InState, FKinematicState& Out_Decoded, int64& Out_NumBits)
+			{
+				return UE::Net::RoundTripKinematicState(InQuantization, InState, nullptr, Out_Decoded, Out_NumBits);
+			});
+
+			// Each state against the previous one, so the deltas cross cells, clamps and signs
+			TOptional<FKinematicState> Prev;
+			FKinematicState::CheckRoundTrip(Quantization, TEXT("Iris delta"), [&Prev](const FKinematicStateQuantization& InQuantization, const FKinematicState& InState, FKinematicState& Out_Decoded, int64& Out_NumBits)
+			{
+				const bool bSuccess = UE::Net::RoundTripKinematicState(InQuantization, InState, Prev.GetPtrOrNull(), Out_Decoded, Out_NumBits);
+				Prev = InState;
+				return bSuccess;
+			});
+#endif
+		}
+	}));
+
+
+FKinematicState::FKinematicState()
+{
+	Position = FVector::ZeroVector;
+	Velocity = FVector::ZeroVector;
+	Acceleration = FVector::ZeroVector;
+}
+
+FKinematicState::FKinematicState(const FVector& In_Position, const FVector& In_Velocity, const FVector& In_Acceleration)
+{
+	Position = In_Position;
+	Velocity = In_Velocity;
+	Acceleration = In_Acceleration;
+}
+
+void FKinematicState::Extrapolate(float InTime)
+{
+	Position += Velocity * InTime + Acceleration * InTime * InTime * 0.5;
+	Velocity += Acceleration * InTime;
+}
+
+namespace KinematicStateSerialization
+{
+	// Forwards one NetSerialize call to its archive and reports the bits of the encoding to the
+	// telemetry. NetSerialize is handed any archive type, so the bits are counted the way the bit
+	// archives pack each call rather than read back from the archive.
+	class FBitCountingArchive
+	{
+	public:
+		explicit FBitCountingArchive(FArchive& InAr): Ar(InAr) {}
+		~FBitCountingArchive()
+		{
+			// Packets and replays are net archives, anything else is not counted
+			if(Ar.IsNetArchive())
+				FDRTelemetry::Get().RecordSerializedBits(Ar.IsSaving(), NumBits);
+		}
+
+		bool IsSaving() const { return Ar.IsSaving(); }
+		bool IsLoading() const { return Ar.IsLoading(); }
+		bool IsError() const { return Ar.IsError(); }
+
+		void SerializeBits(void* InOut_Value, int64 InLengthBits)
+		{
+			Ar.SerializeBits(InOut_Value, InLengthBits);
+			NumBits += InLengthBits;
+		}
+
+		// One bit per power of two, from the lowest, while the value could still reach InValueMax
+		void SerializeInt(uint32& InOut_Value, uint32 InValueMax)
+		{
+			Ar.SerializeInt(InOut_Value, InValueMax);
+			for(uint32 Mask = 1; Mask != 0 && (InOut_Value & (Mask - 1)) + Mask < InValueMax; Mask <<= 1)
+				++NumBits;
+		}
+
+		// Seven value bits per byte
+		void SerializeIntPacked(uint32& InOut_Value)
+		{
+			Ar.SerializeIntPacked(InOut_Value);
+			uint32 Rest = InOut_Value;
+			do
+			{
+				NumBits += 8;
+				Rest >>= 7;
+			} while(Rest != 0);
+		}
+
+		FBitCountingArchive& operator<<(uint32& InOut_Value)
+		{
+			Ar << InOut_Value;
+			NumBits += 32;
+			return *this;
+		}
+
+		FBitCountingArchive& operator<<(FVector& InOut_Value)
+		{
+			Ar << InOut_Value;
+			NumBits += 3 * 64;
+			return *this;
+		}
+
+	private:
+		FArchive& Ar;
+		int64 NumBits = 0;
+	};
+
+	// Map signed integers to unsigned ones so small magnitudes pack into few bytes
+	uint32 ZigZagEncode(int32 Value) { return (static_cast<uint32>(Value) << 1) ^ static_cast<uint32>(Value >> 31); }
+	int32 ZigZagDecode(uint32 Value) { return static_cast<int32>(Value >> 1) ^ -static_cast<int32>(Value & 1); }
+
+	// Signed fixed-point value in [-MaxSteps, MaxSteps] * Precision, values beyond MaxValue are clamped first
+	void SerializeFixed(FBitCountingArchive& Ar, double& Value, float MaxValue, float Precision)
+	{
+		const int64 MaxSteps = FKinematicStateQuantization::GetMaxSteps(MaxValue, Precision);
+		uint32 Encoded = 0;
+		if(Ar.IsSaving())
+		{
+			Encoded = static_cast<uint32>(FKinematicStateQuantization::QuantizeBounded(Value, MaxValue, Precision) + MaxSteps);
+		}
+		Ar.SerializeInt(Encoded, static_cast<uint32>(2 * MaxSteps + 1));
+		if(Ar.IsLoading())
+		{
+			Value = (static_cast<int64>(Encoded) - MaxSteps) * static_cast<double>(Precision);
+		}
+	}
+
+	// Bounded vector with one flag bit per component, zero components cost a single bit
+	void SerializeBoundedVector(FBitCountingArchive& Ar, FVector& Vector, float MaxValue, float Precision)
+	{
+		const double HalfStep = Precision * 0.5;
+		for(int32 i = 0; i < 3; ++i)
+		{
+			uint8 bNonZero = Ar.IsSaving() && FMath::Abs(Vector[i]) >= HalfStep;
+			Ar.SerializeBits(&bNonZero, 1);
+			if(bNonZero)
+			{
+				SerializeFixed(Ar, Vector[i], MaxValue, Precision);
+			}
+			else if(Ar.IsLoading())
+			{
+				Vector[i] = 0.0;
+			}
+		}
+	}
+
+	// Position as a packed grid cell index plus a fixed-point offset inside the cell
+	void SerializeGridPosition(FBitCountingArchive& Ar, FVector& Position, const FKinematicStateQuantization& InQuantization)
+	{
+		const uint32 NumSteps = InQuantization.GetCellSteps();
+		for(int32 i = 0; i < 3; ++i)
+		{
+			uint32 Cell = 0;
+			uint32 Offset = 0;
+			if(Ar.IsSaving())
+			{
+				int32 CellIndex = 0;
+				InQuantization.QuantizePosition(Position[i], CellIndex, Offset);
+				Cell = ZigZagEncode(CellIndex);
+			}
+			Ar.SerializeIntPacked(Cell);
+			Ar.SerializeInt(Offset, NumSteps + 1);
+			if(Ar.IsLoading())
+			{
+				Position[i] = InQuantization.DequantizePosition(ZigZagDecode(Cell), Offset);
+			}
+		}
+	}
+}
+
+// Connections of the game and the replay drivers both belong to the world they replicate
+bool FKinematicState::NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess)
+{
+	UPackageMapClient* PackageMapClient = Cast<UPackageMapClient>(Map);
+	UNetConnection* Connection = PackageMapClient ? PackageMapClient->GetConnection() : nullptr;
+	UNetDriver* Driver = Connection ? Connection->GetDriver() : nullptr;
+	return SerializeQuantized(Ar, FKinematicStateQuantization::Get(Driver ? Driver->GetWorld() : nullptr), bOutSuccess);
+}
+
+bool FKinematicState::SerializeQuantized(FArchive& InAr, const FKinematicStateQuantization& Quantization, bool& bOutSuccess)
+{
+	using namespace KinematicStateSerialization;
+	FBitCountingArchive Ar(InAr);
+
+	Ar << ServerTimeMs;
+
+	if(!Quantization.bEnabled)
+	{
+		Ar << Position;
+		Ar << Velocity;
+		Ar << Acceleration;
+		bOutSuccess = true;
+		return true;
+	}
+
+	SerializeGridPosition(Ar, Position, Quantization);
+
+	// Zero vectors are common (no acceleration on both motions), so flag them with one bit
+	uint8 bHasVelocity = Ar.IsSaving() && !Velocity.IsNearlyZero(Quantization.VelocityPrecision * 0.5f);
+	uint8 bHasAcceleration = Ar.IsSaving() && !Acceleration.IsNearlyZero(Quantization.AccelerationPrecision * 0.5f);
+	Ar.SerializeBits(&bHasVelocity, 1);
+	Ar.SerializeBits(&bHasAcceleration, 1);
+
+	if(bHasVelocity)
+		SerializeBoundedVector(Ar, Velocity, Quantization.MaxVelocity, Quantization.VelocityPrecision);
+	else if(Ar.IsLoading())
+		Velocity = FVector::ZeroVector;
+
+	if(bHasAcceleration)
+		SerializeBoundedVector(Ar, Acceleration, Quantization.MaxAcceleration, Quantization.AccelerationPrecision);
+	else if(Ar.IsLoading())
+		Acceleration = FVector::ZeroVector;
+
+	bOutSuccess = !Ar.IsError();
+	return true;
+}
+
+namespace KinematicStateSerialization
+{
+	// Values around zero, the step edges, InEdges and the clamp limit InLimit, with both signs
+	TArray<double> MakeCheckValues(double InPrecision, double InLimit, TConstArrayView<double> InEdges)
+	{
+		TArray<double> Values = { 0.0, 123.456 };
+		for(const double Edge : InEdges)
+		{
+			for(const double Offset : { 0.0, 0.001, 0.49 * InPrecision, 0.51 * InPrecision })
+			{
+				Values.Add(Edge + Offset);
+				Values.Add(Edge - Offset);
+			}
+		}
+		for(const double Limit : { InLimit - 0.26 * InPrecision, InLimit, InLimit + InPrecision, 10.0 * InLimit })
+		{
+			Values.Add(Limit);
+		}
+		const int32 NumPositive = Values.Num();
+		for(int32 i = 0; i < NumPositive; ++i)
+		{
+			Values.Add(-Values[i]);
+		}
+		return Values;
+	}
+
+	// Largest per-component distance of InDecoded from InExpected clamped to InLimit
+	double GetComponentError(const FVector& InExpected, const FVector& InDecoded, double InLimit)
+	{
+		double Error = 0.0;
+		for(int32 i = 0; i < 3; ++i)
+		{
+			Error = FMath::Max(Error, FMath::Abs(FMath::Clamp(InExpected[i], -InLimit, InLimit) - InDecoded[i]));
+		}
+		return Error;
+	}
+}
+
+// Every value is placed in each component once, the others hold neighbouring values so zero and
+// nonzero components are mixed. The tolerance covers the rounding of the float precisions.
+bool FKinematicState::RoundTripNetSerialize(const FKinematicStateQuantization& InQuantization, const FKinematicState& InState, FKinematicState& Out_Decoded, int64& Out_NumBits)
+{
+	bool bWritten = false;
+	bool bRead = false;
+	FBitWriter Writer(0, true);
+	FKinematicState(InState).SerializeQuantized(Writer, InQuantization, bWritten);
+	FBitReader Reader(Writer.GetData(), Writer.GetNumBits());
+	Out_Decoded.SerializeQuantized(Reader, InQuantization, bRead);
+	Out_NumBits = Writer.GetNumBits();
+	return bWritten && bRead && !Reader.IsError() && Reader.AtEnd();
+}
+
+bool FKinematicState::CheckRoundTrip(const FKinematicStateQuantization& InQuantization, const TCHAR* InPath,
+	TFunctionRef<bool(const FKinematicStateQuantization& InQuantization, const FKinematicState& InState, FKinematicState& Out_Decoded, int64& Out_NumBits)> InRoundTrip)
+{
+	using namespace KinematicStateSerialization;
+	const double CellSize = InQuantization.GridCellSize;
+	const TArray<double> Positions = MakeCheckValues(InQuantization.PositionPrecision, 1.0e7, { 0.0, CellSize, 2.0 * CellSize, 0.5 * CellSize });
+	const TArray<double> Velocities = MakeCheckValues(InQuantization.VelocityPrecision, InQuantization.MaxVelocity, { 1.0 });
+	const TArray<double> Accelerations = MakeCheckValues(InQuantization.AccelerationPrecision, InQuantization.MaxAcceleration, { 1.0 });
+	const double Unbounded = TNumericLimits<double>::Max();
+	const double Slack = 1.0e-4;
+
+	double MaxPositionError = 0.0;
+	double MaxVelocityError = 0.0;
+	double MaxAccelerationError = 0.0;
+	int32 NumFailed = 0;
+	int64 NumBits = 0;
+	const int32 NumStates = FMath::Max3(Positions.Num(), Velocities.Num(), Accelerations.Num());
+	for(int32 i = 0; i < NumStates; ++i)
+	{
+		FKinematicState State;
+		for(int32 Axis = 0; Axis < 3; ++Axis)
+		{
+			State.Position[Axis] = Positions[(i + Axis) % Positions.Num()];
+			State.Velocity[Axis] = Velocities[(i + Axis) % Velocities.Num()];
+			State.Acceleration[Axis] = Accelerations[(i + Axis) % Accelerations.Num()];
+		}
+		State.ServerTimeMs = 1000u * i + 7u;
+
+		FKinematicState Decoded;
+		int64 StateBits = 0;
+		const bool bSuccess = InRoundTrip(InQuantization, State, Decoded, StateBits);
+		NumBits += StateBits;
+
+		const double PositionError = GetComponentError(State.Position, Decoded.Position, Unbounded);
+		const double VelocityError = GetComponentError(State.Velocity, Decoded.Velocity, InQuantization.bEnabled ? InQuantization.MaxVelocity : Unbounded);
+		const double AccelerationError = GetComponentError(State.Acceleration, Decoded.Acceleration, InQuantization.bEnabled ? InQuantization.MaxAcceleration : Unbounded);
+		MaxPositionError = FMath::Max(MaxPositionError, PositionError);
+		MaxVelocityError = FMath::Max(MaxVelocityError, VelocityError);
+		MaxAccelerationError = FMath::Max(MaxAccelerationError, AccelerationError);
+
+		const bool bPassed = bSuccess && Decoded.ServerTimeMs == State.ServerTimeMs
+			&& PositionError <= (InQuantization.bEnabled ? InQuantization.GetMaxPositionError() + Slack : 0.0)
+			&& VelocityError <= (InQuantization.bEnabled ? InQuantization.GetMaxVelocityError() + Slack : 0.0)
+			&& AccelerationError <= (InQuantization.bEnabled ? InQuantization.GetMaxAccelerationError() + Slack : 0.0);
+		if(!bPassed && ++NumFailed <= 10)
+		{
+			UE_LOG(LogTemp, Error, TEXT("DR.CheckQuantization %s: %s decoded as %s"), InPath, *State.ToString(), *Decoded.ToString());
+		}
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("DR.CheckQuantization %s (%s): %d states, %.1f bits each, max error position %.4f (bound %.4f), velocity %.4f (bound %.4f), acceleration %.4f (bound %.4f), %s"),
+		InPath, InQuantization.bEnabled ? TEXT("quantized") : TEXT("full precision"), NumStates, static_cast<double>(NumBits) / NumStates, MaxPositionError, InQuantization.GetMaxPositionError(), MaxVelocityError, InQuantization.GetMaxVelocityError(),
+		MaxAccelerationError, InQuantization.GetMaxAccelerationError(), NumFailed == 0 ? TEXT("passed") : TEXT("FAILED"));
+	return NumFailed == 0;
+}
+
+FString FKinematicState::ToString() const
+{
+	TStringBuilder<256> SB;
+	SB.Appendf(TEXT("Position: %s "), *Position.ToCompactString());
+	SB.Appendf(TEXT("Velocity: %s [%f] "), *Velocity.ToCompactString(), Velocity.Length());
+	SB.Appendf(TEXT("Acceleration: %f"), Acceleration.Length() * FMath::Sign(Acceleration.X));
+	return SB.ToString();
+}
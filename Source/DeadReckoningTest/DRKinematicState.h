@@ -0,0 +1,56 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DRWorldSettings.h"
+#include "DRKinematicState.generated.h"
+
+// Structure representing the state of motion (position, velocity, acceleration)
+USTRUCT()
+struct FKinematicState
+{
+	GENERATED_BODY()
+	
+	UPROPERTY()
+	FVector Position; // Current position of the pawn
+	UPROPERTY()
+	FVector Velocity; // Current velocity of the pawn
+	UPROPERTY()
+	FVector Acceleration; // Current acceleration of the pawn
+	UPROPERTY()
+	uint32 ServerTimeMs = 0; // Server simulation time the state was sampled at, in milliseconds
+
+	FKinematicState(); // Default constructor
+	FKinematicState(const FVector& In_Position, const FVector& In_Velocity, const FVector& In_Acceleration); // Parameterized constructor
+
+	double GetServerTime() const { return ServerTimeMs * 0.001; }
+	void SetServerTime(double InSeconds) { ServerTimeMs = static_cast<uint32>(FMath::Max(0.0, InSeconds) * 1000.0 + 0.5); }
+
+	// Advance the state by InTime seconds assuming constant acceleration
+	void Extrapolate(float InTime);
+
+	// Serialize the kinematic state for network transmission, with the precision of the world Map's connection belongs to
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+
+	// NetSerialize with the precision InQuantization, which the reading side has to use as well
+	bool SerializeQuantized(FArchive& Ar, const FKinematicStateQuantization& InQuantization, bool& bOutSuccess);
+
+	// Round-trips edge case states through InRoundTrip with InQuantization and logs the largest
+	// per-component errors, false if one exceeds the bounds of InQuantization. See DR.CheckQuantization.
+	static bool CheckRoundTrip(const FKinematicStateQuantization& InQuantization, const TCHAR* InPath,
+		TFunctionRef<bool(const FKinematicStateQuantization& InQuantization, const FKinematicState& InState, FKinematicState& Out_Decoded, int64& Out_NumBits)> InRoundTrip);
+
+	// Writes InState with SerializeQuantized and reads it back, false if the read failed
+	static bool RoundTripNetSerialize(const FKinematicStateQuantization& InQuantization, const FKinematicState& InState, FKinematicState& Out_Decoded, int64& Out_NumBits);
+
+	// Debug string representation of the state
+	FString ToString() const;
+};
+
+template<>
+struct TStructOpsTypeTraits<FKinematicState> : public TStructOpsTypeTraitsBase2<FKinematicState>
+{
+	enum
+	{
+		WithNetSerializer = true // Enable network serialization
+	};
+};
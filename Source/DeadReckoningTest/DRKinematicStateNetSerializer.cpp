@@ -0,0 +1,538 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "DRKinematicStateNetSerializer.h"
+
+#if UE_WITH_IRIS
+#include "DRKinematicState.h"
+#include "DRTelemetry.h"
+#include "Engine/Engine.h"
+#include "Engine/NetDriver.h"
+#include "Iris/ReplicationState/PropertyNetSerializerInfoRegistry.h"
+#include "Iris/Serialization/InternalNetSerializationContext.h"
+#include "Iris/Serialization/NetBitStreamReader.h"
+#include "Iris/Serialization/NetBitStreamWriter.h"
+#include "Iris/Serialization/NetSerializationContext.h"
+#include "Iris/Serialization/NetSerializerDelegates.h"
+
+
+namespace UE::Net
+{
+
+struct FKinematicStateNetSerializer
+{
+	// Grid cells and integer steps of the world's FKinematicStateQuantization precisions, or the
+	// unquantized components while quantization is disabled
+	struct FQuantizedType
+	{
+		double FullPrecision[9];
+		int32 PositionCell[3];
+		uint32 PositionOffset[3];
+		int32 Velocity[3];
+		int32 Acceleration[3];
+		uint32 ServerTimeMs;
+		uint8 bFullPrecision;
+	};
+
+	static const uint32 Version = 0;
+
+	typedef FKinematicState SourceType;
+	typedef FQuantizedType QuantizedType;
+	typedef FKinematicStateNetSerializerConfig ConfigType;
+	static const ConfigType DefaultConfig;
+
+	static void Serialize(FNetSerializationContext& Context, const FNetSerializeArgs& Args);
+	static void Deserialize(FNetSerializationContext& Context, const FNetDeserializeArgs& Args);
+	static void SerializeDelta(FNetSerializationContext& Context, const FNetSerializeDeltaArgs& Args);
+	static void DeserializeDelta(FNetSerializationContext& Context, const FNetDeserializeDeltaArgs& Args);
+	static void Quantize(FNetSerializationContext& Context, const FNetQuantizeArgs& Args);
+	static void Dequantize(FNetSerializationContext& Context, const FNetDequantizeArgs& Args);
+	static bool IsEqual(FNetSerializationContext& Context, const FNetIsEqualArgs& Args);
+	static bool Validate(FNetSerializationContext& Context, const FNetValidateArgs& Args);
+
+private:
+	static bool IsEqualQuantized(const QuantizedType& InA, const QuantizedType& InB);
+
+	class FNetSerializerRegistryDelegates final : private UE::Net::FNetSerializerRegistryDelegates
+	{
+	public:
+		virtual ~FNetSerializerRegistryDelegates();
+
+	private:
+		virtual void OnPreFreezeNetSerializerRegistry() override;
+	};
+
+	static FKinematicStateNetSerializer::FNetSerializerRegistryDelegates NetSerializerRegistryDelegates;
+};
+
+UE_NET_IMPLEMENT_SERIALIZER(FKinematicStateNetSerializer);
+
+const FKinematicStateNetSerializer::ConfigType FKinematicStateNetSerializer::DefaultConfig;
+FKinematicStateNetSerializer::FNetSerializerRegistryDelegates FKinematicStateNetSerializer::NetSerializerRegistryDelegates;
+
+static const FName PropertyNetSerializerRegistry_NAME_KinematicState("KinematicState");
+UE_NET_IMPLEMENT_NAMED_STRUCT_NETSERIALIZER_INFO(PropertyNetSerializerRegistry_NAME_KinematicState, FKinematicStateNetSerializer);
+
+namespace KinematicStateNetSerialization
+{
+	constexpr uint32 LengthBits64 = 7; // Bit counts 0..64
+	constexpr uint32 LengthBits32 = 6; // Bit counts 0..32
+
+	uint64 ZigZagEncode(int64 Value) { return (static_cast<uint64>(Value) << 1) ^ static_cast<uint64>(Value >> 63); }
+	int64 ZigZagDecode(uint64 Value) { return static_cast<int64>(Value >> 1) ^ -static_cast<int64>(Value & 1); }
+
+	// Bit count followed by the significant bits, small magnitudes cost few bits
+	void WritePacked(FNetBitStreamWriter& Writer, uint64 Value, uint32 LengthBits)
+	{
+		const uint32 NumBits = Value == 0 ? 0 : 64 - static_cast<uint32>(FMath::CountLeadingZeros64(Value));
+		Writer.WriteBits(NumBits, LengthBits);
+		if(NumBits > 32)
+		{
+			Writer.WriteBits(static_cast<uint32>(Value), 32);
+			Writer.WriteBits(static_cast<uint32>(Value >> 32), NumBits - 32);
+		}
+		else if(NumBits > 0)
+		{
+			Writer.WriteBits(static_cast<uint32>(Value), NumBits);
+		}
+	}
+
+	uint64 ReadPacked(FNetBitStreamReader& Reader, uint32 LengthBits)
+	{
+		const uint32 NumBits = Reader.ReadBits(LengthBits);
+		if(NumBits > 32)
+		{
+			const uint64 Low = Reader.ReadBits(32);
+			return Low | (static_cast<uint64>(Reader.ReadBits(NumBits - 32)) << 32);
+		}
+		return NumBits > 0 ? Reader.ReadBits(NumBits) : 0;
+	}
+
+	// Zero vectors are common (no acceleration on both motions), so flag them with one bit
+	void WriteSteps(FNetBitStreamWriter& Writer, const int32 (&Steps)[3])
+	{
+		const bool bNonZero = Steps[0] != 0 || Steps[1] != 0 || Steps[2] != 0;
+		Writer.WriteBool(bNonZero);
+		if(bNonZero)
+		{
+			for(int32 i = 0; i < 3; ++i)
+				WritePacked(Writer, ZigZagEncode(Steps[i]), LengthBits32);
+		}
+	}
+
+	void ReadSteps(FNetBitStreamReader& Reader, int32 (&Steps)[3])
+	{
+		const bool bNonZero = Reader.ReadBool();
+		for(int32 i = 0; i < 3; ++i)
+			Steps[i] = bNonZero ? static_cast<int32>(ZigZagDecode(ReadPacked(Reader, LengthBits32))) : 0;
+	}
+
+	bool IsEqualSteps(const int32 (&A)[3], const int32 (&B)[3])
+	{
+		return A[0] == B[0] && A[1] == B[1] && A[2] == B[2];
+	}
+
+	void QuantizeVector(const FVector& Vector, float MaxValue, float Precision, int32 (&Out_Steps)[3])
+	{
+		for(int32 i = 0; i < 3; ++i)
+			Out_Steps[i] = FKinematicStateQuantization::QuantizeBounded(Vector[i], MaxValue, Precision);
+	}
+
+	// The config's override, else the settings of the world whose net driver owns the replication
+	// system. The server and each client resolve their own world, so PIE instances stay separate.
+	const FKinematicStateQuantization& GetQuantization(const FNetSerializationContext& Context, NetSerializerConfigParam InConfig)
+	{
+		const FKinematicStateNetSerializerConfig* Config = static_cast<const FKinematicStateNetSerializerConfig*>(InConfig);
+		if(Config != nullptr && Config->Quantization != nullptr)
+			return *Config->Quantization;
+
+		const FInternalNetSerializationContext* InternalContext = Context.GetInternalContext();
+		const UReplicationSystem* ReplicationSystem = InternalContext ? InternalContext->ReplicationSystem : nullptr;
+		if(ReplicationSystem != nullptr && GEngine != nullptr)
+		{
+			for(const FWorldContext& WorldContext : GEngine->GetWorldContexts())
+			{
+				for(const FNamedNetDriver& NamedDriver : WorldContext.ActiveNetDrivers)
+				{
+					if(NamedDriver.NetDriver != nullptr && NamedDriver.NetDriver->GetReplicationSystem() == ReplicationSystem)
+						return FKinematicStateQuantization::Get(WorldContext.World());
+				}
+			}
+		}
+		return FKinematicStateQuantization::Get(nullptr);
+	}
+
+	// Bits of a cell offset in [0, CellSteps]
+	uint32 GetOffsetBits(const FKinematicStateQuantization& Quantization)
+	{
+		return FMath::CeilLogTwo(Quantization.GetCellSteps() + 1);
+	}
+
+	void WriteDouble(FNetBitStreamWriter& Writer, double Value)
+	{
+		uint64 Bits;
+		FMemory::Memcpy(&Bits, &Value, sizeof(Bits));
+		Writer.WriteBits(static_cast<uint32>(Bits), 32);
+		Writer.WriteBits(static_cast<uint32>(Bits >> 32), 32);
+	}
+
+	double ReadDouble(FNetBitStreamReader& Reader)
+	{
+		const uint64 Low = Reader.ReadBits(32);
+		const uint64 Bits = Low | (static_cast<uint64>(Reader.ReadBits(32)) << 32);
+		double Value;
+		FMemory::Memcpy(&Value, &Bits, sizeof(Value));
+		return Value;
+	}
+
+	// Everything but the time: the full precision flag, then either the raw components or the
+	// grid position and the velocity and acceleration steps
+	void WriteBody(FNetBitStreamWriter& Writer, const FKinematicStateNetSerializer::FQuantizedType& Value, const FKinematicStateQuantization& Quantization)
+	{
+		Writer.WriteBool(Value.bFullPrecision != 0);
+		if(Value.bFullPrecision)
+		{
+			for(const double Component : Value.FullPrecision)
+				WriteDouble(Writer, Component);
+			return;
+		}
+
+		const uint32 OffsetBits = GetOffsetBits(Quantization);
+		for(int32 i = 0; i < 3; ++i)
+		{
+			WritePacked(Writer, ZigZagEncode(Value.PositionCell[i]), LengthBits32);
+			Writer.WriteBits(Value.PositionOffset[i], OffsetBits);
+		}
+		WriteSteps(Writer, Value.Velocity);
+		WriteSteps(Writer, Value.Acceleration);
+	}
+
+	void ReadBody(FNetBitStreamReader& Reader, FKinematicStateNetSerializer::FQuantizedType& Value, const FKinematicStateQuantization& Quantization)
+	{
+		Value.bFullPrecision = Reader.ReadBool();
+		if(Value.bFullPrecision)
+		{
+			for(double& Component : Value.FullPrecision)
+				Component = ReadDouble(Reader);
+			return;
+		}
+
+		const uint32 OffsetBits = GetOffsetBits(Quantization);
+		for(int32 i = 0; i < 3; ++i)
+		{
+			Value.PositionCell[i] = static_cast<int32>(ZigZagDecode(ReadPacked(Reader, LengthBits32)));
+			Value.PositionOffset[i] = Reader.ReadBits(OffsetBits);
+		}
+		ReadSteps(Reader, Value.Velocity);
+		ReadSteps(Reader, Value.Acceleration);
+	}
+
+	// Same bit accounting as the legacy NetSerialize path, see FDRTelemetry::RecordSerializedBits
+	class FScopedBitCounter
+	{
+	public:
+		FScopedBitCounter(bool bInSaving, FNetSerializationContext& InContext)
+			: bSaving(bInSaving), Context(InContext), StartBits(GetPosBits()) {}
+		~FScopedBitCounter() { FDRTelemetry::Get().RecordSerializedBits(bSaving, GetPosBits() - StartBits); }
+
+	private:
+		int64 GetPosBits() const { return bSaving ? Context.GetBitStreamWriter()->GetPosBits() : Context.GetBitStreamReader()->GetPosBits(); }
+
+		bool bSaving;
+		FNetSerializationContext& Context;
+		int64 StartBits;
+	};
+}
+
+void FKinematicStateNetSerializer::Serialize(FNetSerializationContext& Context, const FNetSerializeArgs& Args)
+{
+	using namespace KinematicStateNetSerialization;
+	FScopedBitCounter BitCounter(true, Context);
+	FNetBitStreamWriter& Writer = *Context.GetBitStreamWriter();
+	const QuantizedType& Value = *reinterpret_cast<const QuantizedType*>(Args.Source);
+
+	Writer.WriteBits(Value.ServerTimeMs, 32);
+	WriteBody(Writer, Value, GetQuantization(Context, Args.NetSerializerConfig));
+}
+
+void FKinematicStateNetSerializer::Deserialize(FNetSerializationContext& Context, const FNetDeserializeArgs& Args)
+{
+	using namespace KinematicStateNetSerialization;
+	FScopedBitCounter BitCounter(false, Context);
+	FNetBitStreamReader& Reader = *Context.GetBitStreamReader();
+	QuantizedType& Value = *reinterpret_cast<QuantizedType*>(Args.Target);
+
+	FMemory::Memzero(Value);
+	Value.ServerTimeMs = Reader.ReadBits(32);
+	ReadBody(Reader, Value, GetQuantization(Context, Args.NetSerializerConfig));
+}
+
+// Against the last state the connection acknowledged. Movers keep their velocity for a whole
+// side or turn it on a circle, so the position usually stays in its cell and the vectors often
+// repeat. Full precision states on either side are sent whole.
+void FKinematicStateNetSerializer::SerializeDelta(FNetSerializationContext& Context, const FNetSerializeDeltaArgs& Args)
+{
+	using namespace KinematicStateNetSerialization;
+	FScopedBitCounter BitCounter(true, Context);
+	FNetBitStreamWriter& Writer = *Context.GetBitStreamWriter();
+	const QuantizedType& Value = *reinterpret_cast<const QuantizedType*>(Args.Source);
+	const QuantizedType& Prev = *reinterpret_cast<const QuantizedType*>(Args.Prev);
+	const FKinematicStateQuantization& Quantization = GetQuantization(Context, Args.NetSerializerConfig);
+
+	WritePacked(Writer, static_cast<uint32>(Value.ServerTimeMs - Prev.ServerTimeMs), LengthBits32);
+	const bool bFullBody = Value.bFullPrecision || Prev.bFullPrecision;
+	Writer.WriteBool(bFullBody);
+	if(bFullBody)
+	{
+		WriteBody(Writer, Value, Quantization);
+		return;
+	}
+
+	// Offset delta inside the same cell, the whole offset after a cell change
+	const uint32 OffsetBits = GetOffsetBits(Quantization);
+	for(int32 i = 0; i < 3; ++i)
+	{
+		const bool bSameCell = Value.PositionCell[i] == Prev.PositionCell[i];
+		Writer.WriteBool(bSameCell);
+		if(bSameCell)
+		{
+			WritePacked(Writer, ZigZagEncode(static_cast<int64>(Value.PositionOffset[i]) - Prev.PositionOffset[i]), LengthBits64);
+		}
+		else
+		{
+			WritePacked(Writer, ZigZagEncode(static_cast<int64>(Value.PositionCell[i]) - Prev.PositionCell[i]), LengthBits64);
+			Writer.WriteBits(Value.PositionOffset[i], OffsetBits);
+		}
+	}
+
+	const bool bSameVelocity = IsEqualSteps(Value.Velocity, Prev.Velocity);
+	Writer.WriteBool(bSameVelocity);
+	if(!bSameVelocity)
+		WriteSteps(Writer, Value.Velocity);
+
+	const bool bSameAcceleration = IsEqualSteps(Value.Acceleration, Prev.Acceleration);
+	Writer.WriteBool(bSameAcceleration);
+	if(!bSameAcceleration)
+		WriteSteps(Writer, Value.Acceleration);
+}
+
+void FKinematicStateNetSerializer::DeserializeDelta(FNetSerializationContext& Context, const FNetDeserializeDeltaArgs& Args)
+{
+	using namespace KinematicStateNetSerialization;
+	FScopedBitCounter BitCounter(false, Context);
+	FNetBitStreamReader& Reader = *Context.GetBitStreamReader();
+	QuantizedType& Value = *reinterpret_cast<QuantizedType*>(Args.Target);
+	const QuantizedType& Prev = *reinterpret_cast<const QuantizedType*>(Args.Prev);
+	const FKinematicStateQuantization& Quantization = GetQuantization(Context, Args.NetSerializerConfig);
+
+	FMemory::Memzero(Value);
+	Value.ServerTimeMs = Prev.ServerTimeMs + static_cast<uint32>(ReadPacked(Reader, LengthBits32));
+	if(Reader.ReadBool())
+	{
+		ReadBody(Reader, Value, Quantization);
+		return;
+	}
+
+	const uint32 OffsetBits = GetOffsetBits(Quantization);
+	for(int32 i = 0; i < 3; ++i)
+	{
+		if(Reader.ReadBool())
+		{
+			Value.PositionCell[i] = Prev.PositionCell[i];
+			Value.PositionOffset[i] = static_cast<uint32>(Prev.PositionOffset[i] + ZigZagDecode(ReadPacked(Reader, LengthBits64)));
+		}
+		else
+		{
+			Value.PositionCell[i] = static_cast<int32>(Prev.PositionCell[i] + ZigZagDecode(ReadPacked(Reader, LengthBits64)));
+			Value.PositionOffset[i] = Reader.ReadBits(OffsetBits);
+		}
+	}
+
+	if(Reader.ReadBool())
+		FMemory::Memcpy(Value.Velocity, Prev.Velocity, sizeof(Value.Velocity));
+	else
+		ReadSteps(Reader, Value.Velocity);
+
+	if(Reader.ReadBool())
+		FMemory::Memcpy(Value.Acceleration, Prev.Acceleration, sizeof(Value.Acceleration));
+	else
+		ReadSteps(Reader, Value.Acceleration);
+}
+
+// Same grid cells and clamps as FKinematicState::NetSerialize, raw components while quantization is disabled
+void FKinematicStateNetSerializer::Quantize(FNetSerializationContext& Context, const FNetQuantizeArgs& Args)
+{
+	using namespace KinematicStateNetSerialization;
+	const SourceType& Source = *reinterpret_cast<const SourceType*>(Args.Source);
+	QuantizedType& Target = *reinterpret_cast<QuantizedType*>(Args.Target);
+	const FKinematicStateQuantization& Quantization = GetQuantization(Context, Args.NetSerializerConfig);
+
+	FMemory::Memzero(Target);
+	Target.ServerTimeMs = Source.ServerTimeMs;
+	Target.bFullPrecision = !Quantization.bEnabled;
+	if(Target.bFullPrecision)
+	{
+		for(int32 i = 0; i < 3; ++i)
+		{
+			Target.FullPrecision[i] = Source.Position[i];
+			Target.FullPrecision[3 + i] = Source.Velocity[i];
+			Target.FullPrecision[6 + i] = Source.Acceleration[i];
+		}
+		return;
+	}
+
+	for(int32 i = 0; i < 3; ++i)
+		Quantization.QuantizePosition(Source.Position[i], Target.PositionCell[i], Target.PositionOffset[i]);
+	QuantizeVector(Source.Velocity, Quantization.MaxVelocity, Quantization.VelocityPrecision, Target.Velocity);
+	QuantizeVector(Source.Acceleration, Quantization.MaxAcceleration, Quantization.AccelerationPrecision, Target.Acceleration);
+}
+
+void FKinematicStateNetSerializer::Dequantize(FNetSerializationContext& Context, const FNetDequantizeArgs& Args)
+{
+	using namespace KinematicStateNetSerialization;
+	const QuantizedType& Source = *reinterpret_cast<const QuantizedType*>(Args.Source);
+	SourceType& Target = *reinterpret_cast<SourceType*>(Args.Target);
+	const FKinematicStateQuantization& Quantization = GetQuantization(Context, Args.NetSerializerConfig);
+
+	Target.ServerTimeMs = Source.ServerTimeMs;
+	if(Source.bFullPrecision)
+	{
+		for(int32 i = 0; i < 3; ++i)
+		{
+			Target.Position[i] = Source.FullPrecision[i];
+			Target.Velocity[i] = Source.FullPrecision[3 + i];
+			Target.Acceleration[i] = Source.FullPrecision[6 + i];
+		}
+		return;
+	}
+
+	for(int32 i = 0; i < 3; ++i)
+	{
+		Target.Position[i] = Quantization.DequantizePosition(Source.PositionCell[i], Source.PositionOffset[i]);
+		Target.Velocity[i] = Source.Velocity[i] * static_cast<double>(Quantization.VelocityPrecision);
+		Target.Acceleration[i] = Source.Acceleration[i] * static_cast<double>(Quantization.AccelerationPrecision);
+	}
+}
+
+bool FKinematicStateNetSerializer::IsEqual(FNetSerializationContext& Context, const FNetIsEqualArgs& Args)
+{
+	if(Args.bStateIsQuantized)
+		return IsEqualQuantized(*reinterpret_cast<const QuantizedType*>(Args.Source0), *reinterpret_cast<const QuantizedType*>(Args.Source1));
+
+	// Source states are equal when they would be sent the same
+	QuantizedType Quantized0;
+	QuantizedType Quantized1;
+	FNetQuantizeArgs QuantizeArgs = {};
+	QuantizeArgs.NetSerializerConfig = Args.NetSerializerConfig;
+	QuantizeArgs.Source = Args.Source0;
+	QuantizeArgs.Target = NetSerializerValuePointer(&Quantized0);
+	Quantize(Context, QuantizeArgs);
+	QuantizeArgs.Source = Args.Source1;
+	QuantizeArgs.Target = NetSerializerValuePointer(&Quantized1);
+	Quantize(Context, QuantizeArgs);
+	return IsEqualQuantized(Quantized0, Quantized1);
+}
+
+bool FKinematicStateNetSerializer::Validate(FNetSerializationContext& Context, const FNetValidateArgs& Args)
+{
+	const SourceType& Source = *reinterpret_cast<const SourceType*>(Args.Source);
+	return !Source.Position.ContainsNaN() && !Source.Velocity.ContainsNaN() && !Source.Acceleration.ContainsNaN();
+}
+
+bool FKinematicStateNetSerializer::IsEqualQuantized(const QuantizedType& InA, const QuantizedType& InB)
+{
+	using namespace KinematicStateNetSerialization;
+	if(InA.ServerTimeMs != InB.ServerTimeMs || InA.bFullPrecision != InB.bFullPrecision)
+		return false;
+	if(InA.bFullPrecision)
+		return FMemory::Memcmp(InA.FullPrecision, InB.FullPrecision, sizeof(InA.FullPrecision)) == 0;
+	return IsEqualSteps(InA.PositionCell, InB.PositionCell)
+		&& InA.PositionOffset[0] == InB.PositionOffset[0] && InA.PositionOffset[1] == InB.PositionOffset[1] && InA.PositionOffset[2] == InB.PositionOffset[2]
+		&& IsEqualSteps(InA.Velocity, InB.Velocity) && IsEqualSteps(InA.Acceleration, InB.Acceleration);
+}
+
+bool RoundTripKinematicState(const FKinematicStateQuantization& InQuantization, const FKinematicState& InState, const FKinematicState* InPrev, FKinematicState& Out_Decoded, int64& Out_NumBits)
+{
+	typedef FKinematicStateNetSerializer::QuantizedType QuantizedType;
+	QuantizedType Value;
+	QuantizedType Prev;
+	QuantizedType Decoded;
+	FNetSerializationContext QuantizeContext;
+	FKinematicStateNetSerializerConfig Config;
+	Config.Quantization = &InQuantization;
+
+	FNetQuantizeArgs QuantizeArgs = {};
+	QuantizeArgs.NetSerializerConfig = &Config;
+	QuantizeArgs.Source = NetSerializerValuePointer(&InState);
+	QuantizeArgs.Target = NetSerializerValuePointer(&Value);
+	FKinematicStateNetSerializer::Quantize(QuantizeContext, QuantizeArgs);
+	if(InPrev != nullptr)
+	{
+		QuantizeArgs.Source = NetSerializerValuePointer(InPrev);
+		QuantizeArgs.Target = NetSerializerValuePointer(&Prev);
+		FKinematicStateNetSerializer::Quantize(QuantizeContext, QuantizeArgs);
+	}
+
+	uint32 Buffer[64];
+	FNetBitStreamWriter Writer;
+	Writer.InitBytes(Buffer, sizeof(Buffer));
+	FNetSerializationContext WriteContext(&Writer);
+	if(InPrev != nullptr)
+	{
+		FNetSerializeDeltaArgs Args = {};
+		Args.NetSerializerConfig = &Config;
+		Args.Source = NetSerializerValuePointer(&Value);
+		Args.Prev = NetSerializerValuePointer(&Prev);
+		FKinematicStateNetSerializer::SerializeDelta(WriteContext, Args);
+	}
+	else
+	{
+		FNetSerializeArgs Args = {};
+		Args.NetSerializerConfig = &Config;
+		Args.Source = NetSerializerValuePointer(&Value);
+		FKinematicStateNetSerializer::Serialize(WriteContext, Args);
+	}
+	Writer.CommitWrites();
+	Out_NumBits = Writer.GetPosBits();
+
+	FNetBitStreamReader Reader;
+	Reader.InitBits(Buffer, static_cast<uint32>(Out_NumBits));
+	FNetSerializationContext ReadContext(&Reader);
+	if(InPrev != nullptr)
+	{
+		FNetDeserializeDeltaArgs Args = {};
+		Args.NetSerializerConfig = &Config;
+		Args.Target = NetSerializerValuePointer(&Decoded);
+		Args.Prev = NetSerializerValuePointer(&Prev);
+		FKinematicStateNetSerializer::DeserializeDelta(ReadContext, Args);
+	}
+	else
+	{
+		FNetDeserializeArgs Args = {};
+		Args.NetSerializerConfig = &Config;
+		Args.Target = NetSerializerValuePointer(&Decoded);
+		FKinematicStateNetSerializer::Deserialize(ReadContext, Args);
+	}
+
+	FNetDequantizeArgs DequantizeArgs = {};
+	DequantizeArgs.NetSerializerConfig = &Config;
+	DequantizeArgs.Source = NetSerializerValuePointer(&Decoded);
+	DequantizeArgs.Target = NetSerializerValuePointer(&Out_Decoded);
+	FKinematicStateNetSerializer::Dequantize(ReadContext, DequantizeArgs);
+
+	return !Writer.IsOverflown() && !Reader.IsOverflown() && !ReadContext.HasErrorOrOverflow() && Reader.GetPosBits() == Out_NumBits;
+}
+
+FKinematicStateNetSerializer::FNetSerializerRegistryDelegates::~FNetSerializerRegistryDelegates()
+{
+	UE_NET_UNREGISTER_NETSERIALIZER_INFO(PropertyNetSerializerRegistry_NAME_KinematicState);
+}
+
+// Replaces the struct's WithNetSerializer fallback for every FKinematicState property
+void FKinematicStateNetSerializer::FNetSerializerRegistryDelegates::OnPreFreezeNetSerializerRegistry()
+{
+	UE_NET_REGISTER_NETSERIALIZER_INFO(PropertyNetSerializerRegistry_NAME_KinematicState);
+}
+
+}
+#endif // UE_WITH_IRIS
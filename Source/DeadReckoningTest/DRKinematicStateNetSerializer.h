@@ -0,0 +1,35 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Iris/Serialization/NetSerializer.h"
+#include "DRKinematicStateNetSerializer.generated.h"
+
+struct FKinematicState;
+struct FKinematicStateQuantization;
+
+// Precision comes from the world settings of the replicating world, like the legacy NetSerialize path
+USTRUCT()
+struct FKinematicStateNetSerializerConfig : public FNetSerializerConfig
+{
+	GENERATED_BODY()
+
+	const FKinematicStateQuantization* Quantization = nullptr; // Replaces the world's precision, for serialization outside a replication system
+};
+
+namespace UE::Net
+{
+	// Iris serializer of FKinematicState, registered for the struct so every replicated
+	// kinematic state uses it when Iris is active. Delta compressed objects are written
+	// against the connection's acknowledged baseline: the time and the offset inside an
+	// unchanged grid cell as small integer deltas, velocity and acceleration as a single
+	// bit while unchanged.
+	UE_NET_DECLARE_SERIALIZER(FKinematicStateNetSerializer, DEADRECKONINGTEST_API);
+
+#if UE_WITH_IRIS
+	// Quantizes InState with InQuantization, serializes it (as a delta against InPrev when set) and reads it back
+	// the way a client would, false if the read did not consume exactly what was written. See DR.CheckQuantization.
+	DEADRECKONINGTEST_API bool RoundTripKinematicState(const FKinematicStateQuantization& InQuantization, const FKinematicState& InState, const FKinematicState* InPrev, FKinematicState& Out_Decoded, int64& Out_NumBits);
+#endif
+}
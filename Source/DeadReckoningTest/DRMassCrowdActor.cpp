@@ -0,0 +1,236 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "DRMassCrowdActor.h"
+
+#include "DeadReckoningTest.h"
+#include "DRMassFragments.h"
+#include "DRMassProcessors.h"
+#include "DRWorldSettings.h"
+#include "MassEntityManager.h"
+#include "MassEntitySubsystem.h"
+#include "MassExecutor.h"
+#include "MassProcessingTypes.h"
+
+DECLARE_CYCLE_STAT(TEXT("Mass Crowd Extrapolate"), STAT_DRMassCrowdExtrapolate, STATGROUP_DeadReckoning);
+
+
+void ADRMassCrowdActor::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+
+	if(const ADRWorldSettings* Settings = Cast<ADRWorldSettings>(GetWorldSettings()))
+	{
+		ClientStepper = Settings->MakeFixedStepAccumulator();
+	}
+
+	FMassEntityManager* EntityManager = GetEntityManager();
+	if(EntityManager == nullptr)
+		return;
+
+	MoverArchetype = EntityManager->CreateArchetype({ FDRMoverFragment::StaticStruct(), FDRServerStateFragment::StaticStruct(), FDRCrowdIndexFragment::StaticStruct() }, TEXT("DRCrowdMover"));
+	ProxyArchetype = EntityManager->CreateArchetype({ FDRProxyFragment::StaticStruct(), FDRCrowdIndexFragment::StaticStruct() }, TEXT("DRCrowdProxy"));
+
+	FDRCrowdSharedFragment CrowdFragment;
+	CrowdFragment.Crowd = this;
+	SharedValues.AddSharedFragment(EntityManager->GetOrCreateSharedFragment(CrowdFragment));
+	SharedValues.Sort();
+
+	// Queries are configured when the processors are created, the filters read Crowd when they run
+	MotionProcessor = NewObject<UDRMassServerMotionProcessor>(this);
+	MotionProcessor->Crowd = this;
+	MotionProcessor->Initialize(*this);
+	ExtrapolationProcessor = NewObject<UDRMassExtrapolationProcessor>(this);
+	ExtrapolationProcessor->Crowd = this;
+	ExtrapolationProcessor->Initialize(*this);
+}
+
+void ADRMassCrowdActor::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// Clients extrapolate their proxies here instead of in UDRDeadReckoningSubsystem
+	SetActorTickEnabled(true);
+}
+
+void ADRMassCrowdActor::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if(!HasAuthority())
+	{
+		ExtrapolateProxies(DeltaTime);
+	}
+}
+
+// Proxies are destroyed in one batch before the base class would remove them one by one
+void ADRMassCrowdActor::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if(FMassEntityManager* EntityManager = GetEntityManager())
+	{
+		TArray<FMassEntityHandle> SetProxies;
+		SetProxies.Reserve(ProxyEntities.Num());
+		for(const FMassEntityHandle& Entity : ProxyEntities)
+		{
+			if(Entity.IsSet())
+				SetProxies.Add(Entity);
+		}
+		EntityManager->BatchDestroyEntities(SetProxies);
+		EntityManager->BatchDestroyEntities(MoverEntities);
+	}
+	ProxyEntities.Reset();
+	MoverEntities.Reset();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+FMassEntityManager* ADRMassCrowdActor::GetEntityManager() const
+{
+	UMassEntitySubsystem* Subsystem = GetWorld() != nullptr ? GetWorld()->GetSubsystem<UMassEntitySubsystem>() : nullptr;
+	return Subsystem != nullptr ? &Subsystem->GetMutableEntityManager() : nullptr;
+}
+
+void ADRMassCrowdActor::RunProcessor(UMassProcessor& InProcessor, float InDeltaTime)
+{
+	FMassEntityManager* EntityManager = GetEntityManager();
+	if(EntityManager == nullptr)
+		return;
+
+	FMassProcessingContext ProcessingContext(*EntityManager, InDeltaTime);
+	UMassProcessor* Processors[] = { &InProcessor };
+	UE::Mass::Executor::RunProcessorsView(Processors, ProcessingContext);
+}
+
+void ADRMassCrowdActor::AddMovers(TArray<FDRMover>&& InMovers)
+{
+	FMassEntityManager* EntityManager = GetEntityManager();
+	if(EntityManager == nullptr || InMovers.Num() == 0)
+		return;
+
+	// Observers are notified when the creation context goes out of scope, after the fragments are filled
+	TArray<FMassEntityHandle> NewEntities;
+	const TSharedRef<FMassEntityManager::FEntityCreationContext> CreationContext =
+		EntityManager->BatchCreateEntities(MoverArchetype, SharedValues, InMovers.Num(), NewEntities);
+
+	const int32 FirstItem = Entities.Items.Num() - InMovers.Num();
+	for(int32 i = 0; i < NewEntities.Num(); ++i)
+	{
+		const FMassEntityHandle Entity = NewEntities[i];
+		EntityManager->GetFragmentDataChecked<FDRMoverFragment>(Entity).Mover = MoveTemp(InMovers[i]);
+		EntityManager->GetFragmentDataChecked<FDRServerStateFragment>(Entity).State = Entities.Items[FirstItem + i].State;
+		EntityManager->GetFragmentDataChecked<FDRCrowdIndexFragment>(Entity).Index = FirstItem + i;
+	}
+	MoverEntities.Append(NewEntities);
+}
+
+void ADRMassCrowdActor::StepMovers(int32 InNumSteps, float In_StepTime)
+{
+	if(MoverEntities.Num() == 0)
+		return;
+
+	MotionProcessor->NumSteps = InNumSteps;
+	MotionProcessor->StepTime = In_StepTime;
+	RunProcessor(*MotionProcessor, InNumSteps * In_StepTime);
+}
+
+// Only used by listen servers to draw the movers, so the lookup per entity is acceptable.
+// Without an entity manager no entities were created, the last sent state stands in for them.
+FVector ADRMassCrowdActor::GetMoverLocation(int32 InItem, double InAlpha) const
+{
+	const FMassEntityManager* EntityManager = GetEntityManager();
+	if(EntityManager == nullptr || !MoverEntities.IsValidIndex(InItem))
+		return Entities.Items[InItem].State.Position;
+
+	const FDRMoverFragment& Fragment = EntityManager->GetFragmentDataChecked<FDRMoverFragment>(MoverEntities[InItem]);
+	return ToFVector(Fragment.Mover.GetInterpolatedLocation(InAlpha));
+}
+
+void ADRMassCrowdActor::ExtrapolateProxies(float In_DeltaTime)
+{
+	// The clock keeps running without proxies so new ones join in step
+	const int32 NumSteps = ClientStepper.Advance(In_DeltaTime);
+	if(ProxyEntities.Num() == 0 || GetEntityManager() == nullptr)
+		return;
+
+	SCOPE_CYCLE_COUNTER(STAT_DRMassCrowdExtrapolate);
+	ExtrapolationProcessor->NumSteps = NumSteps;
+	ExtrapolationProcessor->StepTime = static_cast<float>(ClientStepper.GetStepTime());
+	ExtrapolationProcessor->Alpha = ClientStepper.GetAlpha();
+	RunProcessor(*ExtrapolationProcessor, In_DeltaTime);
+	FlushInstanceTransforms();
+}
+
+void ADRMassCrowdActor::AddProxy(int32 InInstance, const FKinematicState& InState, float InBlendTime)
+{
+	check(InInstance == ProxyEntities.Num());
+	FMassEntityManager* EntityManager = GetEntityManager();
+	if(EntityManager == nullptr)
+	{
+		ProxyEntities.AddDefaulted();
+		return;
+	}
+
+	const FMassEntityHandle Entity = EntityManager->CreateEntity(ProxyArchetype, SharedValues);
+	FDRProxyFragment& Proxy = EntityManager->GetFragmentDataChecked<FDRProxyFragment>(Entity);
+	Proxy.Extrapolator.AverageServerUpdateTime = InBlendTime;
+	Proxy.Extrapolator.Reset(ToCore(InState));
+	Proxy.PreviousPosition = Proxy.Extrapolator.GetClientPosition();
+	EntityManager->GetFragmentDataChecked<FDRCrowdIndexFragment>(Entity).Index = InInstance;
+	ProxyEntities.Add(Entity);
+}
+
+void ADRMassCrowdActor::RemoveProxy(int32 InInstance)
+{
+	FMassEntityManager* EntityManager = GetEntityManager();
+	if(EntityManager != nullptr && HasProxy(InInstance))
+	{
+		EntityManager->DestroyEntity(ProxyEntities[InInstance]);
+	}
+	ProxyEntities[InInstance].Reset();
+}
+
+bool ADRMassCrowdActor::HasProxy(int32 InInstance) const
+{
+	return ProxyEntities.IsValidIndex(InInstance) && ProxyEntities[InInstance].IsSet();
+}
+
+// AddProxy leaves the handle unset without an entity manager, and the manager is gone once the world tears down
+FVector ADRMassCrowdActor::GetProxyPosition(int32 InInstance) const
+{
+	const FMassEntityManager* EntityManager = GetEntityManager();
+	if(EntityManager == nullptr || !HasProxy(InInstance))
+		return FVector::ZeroVector;
+
+	const FDRProxyFragment& Proxy = EntityManager->GetFragmentDataChecked<FDRProxyFragment>(ProxyEntities[InInstance]);
+	return ToFVector(Proxy.Extrapolator.GetClientPosition());
+}
+
+void ADRMassCrowdActor::SetProxyServerState(int32 InInstance, const FKinematicState& InState, float InBlendTime)
+{
+	FMassEntityManager* EntityManager = GetEntityManager();
+	if(EntityManager == nullptr || !HasProxy(InInstance))
+		return;
+
+	FDRProxyFragment& Proxy = EntityManager->GetFragmentDataChecked<FDRProxyFragment>(ProxyEntities[InInstance]);
+	Proxy.Extrapolator.SetServerState(ToCore(InState), InBlendTime);
+}
+
+// Fragments are counted by size, the chunk headers and partially filled chunks are not included
+SIZE_T ADRMassCrowdActor::GetAllocatedSize() const
+{
+	SIZE_T Size = Super::GetAllocatedSize() + MoverEntities.GetAllocatedSize() + ProxyEntities.GetAllocatedSize();
+	Size += MoverEntities.Num() * (sizeof(FDRMoverFragment) + sizeof(FDRServerStateFragment) + sizeof(FDRCrowdIndexFragment));
+
+	const FMassEntityManager* EntityManager = GetEntityManager();
+	for(const FMassEntityHandle& Entity : MoverEntities)
+	{
+		if(EntityManager != nullptr)
+			Size += EntityManager->GetFragmentDataChecked<FDRMoverFragment>(Entity).Mover.ShadowClient.TimeStampCollector.GetAllocatedSize();
+	}
+	for(const FMassEntityHandle& Entity : ProxyEntities)
+	{
+		if(Entity.IsSet())
+			Size += sizeof(FDRProxyFragment) + sizeof(FDRCrowdIndexFragment);
+	}
+	return Size;
+}
@@ -0,0 +1,64 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DRCrowdActor.h"
+#include "MassEntityTypes.h"
+#include "DRMassCrowdActor.generated.h"
+
+class UMassProcessor;
+class UDRMassExtrapolationProcessor;
+class UDRMassServerMotionProcessor;
+struct FMassEntityManager;
+
+/**
+ * ADRCrowdActor whose movers and proxies are MassEntity entities instead of arrays and
+ * UDRDeadReckoningSubsystem slots. Their state lives in the fragments of DRMassFragments.h,
+ * laid out in chunks per archetype, and the stepping runs as chunked processors.
+ * Replication still goes through the crowd's fast array, one item per mover.
+ */
+UCLASS()
+class DEADRECKONINGTEST_API ADRMassCrowdActor : public ADRCrowdActor
+{
+	GENERATED_BODY()
+
+public:
+	virtual void PostInitializeComponents() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual SIZE_T GetAllocatedSize() const override;
+
+protected:
+	virtual void BeginPlay() override;
+
+	virtual void AddMovers(TArray<FDRMover>&& InMovers) override;
+	virtual void StepMovers(int32 InNumSteps, float In_StepTime) override;
+	virtual FVector GetMoverLocation(int32 InItem, double InAlpha) const override;
+	virtual void AddProxy(int32 InInstance, const FKinematicState& InState, float InBlendTime) override;
+	virtual void RemoveProxy(int32 InInstance) override;
+	virtual bool HasProxy(int32 InInstance) const override;
+	virtual FVector GetProxyPosition(int32 InInstance) const override;
+	virtual void SetProxyServerState(int32 InInstance, const FKinematicState& InState, float InBlendTime) override;
+
+private:
+	friend class UDRMassServerMotionProcessor;
+	friend class UDRMassExtrapolationProcessor;
+
+	FMassEntityManager* GetEntityManager() const; // Null once the world tears down
+	void RunProcessor(UMassProcessor& InProcessor, float InDeltaTime);
+	void ExtrapolateProxies(float In_DeltaTime);
+
+	UPROPERTY(Transient)
+	TObjectPtr<UDRMassServerMotionProcessor> MotionProcessor;
+	UPROPERTY(Transient)
+	TObjectPtr<UDRMassExtrapolationProcessor> ExtrapolationProcessor;
+
+	FMassArchetypeHandle MoverArchetype;
+	FMassArchetypeHandle ProxyArchetype;
+	FMassArchetypeSharedFragmentValues SharedValues; // This crowd's FDRCrowdSharedFragment
+
+	TArray<FMassEntityHandle> MoverEntities; // Server, same order as Entities.Items
+	TArray<FMassEntityHandle> ProxyEntities; // Client, indexed by instance, unset once removed
+	DRCore::FFixedStepAccumulator ClientStepper;
+};
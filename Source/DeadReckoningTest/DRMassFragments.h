@@ -0,0 +1,67 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DRKinematicState.h"
+#include "DRMover.h"
+#include "MassEntityTypes.h"
+#include "DeadReckoningCore/DRCoreExtrapolator.h"
+#include "DRMassFragments.generated.h"
+
+class ADRMassCrowdActor;
+
+// Server: scripted motion of one crowd mover
+USTRUCT()
+struct FDRMoverFragment : public FMassFragment
+{
+	GENERATED_BODY()
+
+	FDRMover Mover;
+};
+
+// FDRMover owns the shadow client's sample buffer
+template<>
+struct TMassFragmentTraits<FDRMoverFragment> final
+{
+	enum { AuthorAcceptsItsNotTriviallyCopyable = true };
+};
+
+// Server: last state sent for the mover
+USTRUCT()
+struct FDRServerStateFragment : public FMassFragment
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FKinematicState State;
+};
+
+// Client: predicted and last received state of one proxy, float32 relative to a per-entity origin
+USTRUCT()
+struct FDRProxyFragment : public FMassFragment
+{
+	GENERATED_BODY()
+
+	DRCore::FRebasedBlendingExtrapolator Extrapolator;
+	DRCore::FVec3 PreviousPosition; // Client position before the last step
+};
+
+// Item of the crowd's fast array on the server, instance of its mesh on clients
+USTRUCT()
+struct FDRCrowdIndexFragment : public FMassFragment
+{
+	GENERATED_BODY()
+
+	int32 Index = INDEX_NONE;
+};
+
+// Crowd the entities belong to, chunks are never shared between crowds
+USTRUCT()
+struct FDRCrowdSharedFragment : public FMassSharedFragment
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TObjectPtr<ADRMassCrowdActor> Crowd;
+};
@@ -0,0 +1,86 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "DRMassProcessors.h"
+
+#include "DRMassCrowdActor.h"
+#include "DRMassFragments.h"
+#include "MassExecutionContext.h"
+
+
+UDRMassServerMotionProcessor::UDRMassServerMotionProcessor()
+	: EntityQuery(*this)
+{
+	bAutoRegisterWithProcessingPhases = false;
+	ExecutionFlags = static_cast<int32>(EProcessorExecutionFlags::All);
+}
+
+void UDRMassServerMotionProcessor::ConfigureQueries()
+{
+	EntityQuery.AddRequirement<FDRMoverFragment>(EMassFragmentAccess::ReadWrite);
+	EntityQuery.AddRequirement<FDRServerStateFragment>(EMassFragmentAccess::ReadWrite);
+	EntityQuery.AddRequirement<FDRCrowdIndexFragment>(EMassFragmentAccess::ReadOnly);
+	EntityQuery.AddSharedRequirement<FDRCrowdSharedFragment>(EMassFragmentAccess::ReadOnly);
+	EntityQuery.SetChunkFilter([this](const FMassExecutionContext& InContext)
+	{
+		return InContext.GetSharedFragment<FDRCrowdSharedFragment>().Crowd == Crowd;
+	});
+}
+
+void UDRMassServerMotionProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context)
+{
+	EntityQuery.ParallelForEachEntityChunk(EntityManager, Context, [this](FMassExecutionContext& InContext)
+	{
+		const TArrayView<FDRMoverFragment> Movers = InContext.GetMutableFragmentView<FDRMoverFragment>();
+		const TArrayView<FDRServerStateFragment> States = InContext.GetMutableFragmentView<FDRServerStateFragment>();
+		const TConstArrayView<FDRCrowdIndexFragment> Items = InContext.GetFragmentView<FDRCrowdIndexFragment>();
+
+		for(int32 i = 0; i < InContext.GetNumEntities(); ++i)
+		{
+			const int32 LastSentStep = Movers[i].Mover.Step(NumSteps, StepTime, States[i].State);
+			Crowd->SetStepResult(Items[i].Index, LastSentStep, States[i].State);
+		}
+	});
+}
+
+
+UDRMassExtrapolationProcessor::UDRMassExtrapolationProcessor()
+	: EntityQuery(*this)
+{
+	bAutoRegisterWithProcessingPhases = false;
+	ExecutionFlags = static_cast<int32>(EProcessorExecutionFlags::All);
+}
+
+void UDRMassExtrapolationProcessor::ConfigureQueries()
+{
+	EntityQuery.AddRequirement<FDRProxyFragment>(EMassFragmentAccess::ReadWrite);
+	EntityQuery.AddRequirement<FDRCrowdIndexFragment>(EMassFragmentAccess::ReadOnly);
+	EntityQuery.AddSharedRequirement<FDRCrowdSharedFragment>(EMassFragmentAccess::ReadOnly);
+	EntityQuery.SetChunkFilter([this](const FMassExecutionContext& InContext)
+	{
+		return InContext.GetSharedFragment<FDRCrowdSharedFragment>().Crowd == Crowd;
+	});
+}
+
+void UDRMassExtrapolationProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context)
+{
+	EntityQuery.ParallelForEachEntityChunk(EntityManager, Context, [this](FMassExecutionContext& InContext)
+	{
+		const TArrayView<FDRProxyFragment> Proxies = InContext.GetMutableFragmentView<FDRProxyFragment>();
+		const TConstArrayView<FDRCrowdIndexFragment> Instances = InContext.GetFragmentView<FDRCrowdIndexFragment>();
+
+		for(int32 i = 0; i < InContext.GetNumEntities(); ++i)
+		{
+			FDRProxyFragment& Proxy = Proxies[i];
+			for(int32 Step = 0; Step < NumSteps; ++Step)
+			{
+				Proxy.PreviousPosition = Proxy.Extrapolator.GetClientPosition();
+				Proxy.Extrapolator.Step(StepTime);
+			}
+
+			// Instances are distinct per entity, so chunks can write them concurrently
+			const DRCore::FVec3 ClientPosition = Proxy.Extrapolator.GetClientPosition();
+			Crowd->SetInstanceLocation(Instances[i].Index, ToFVector(Proxy.PreviousPosition + (ClientPosition - Proxy.PreviousPosition) * Alpha));
+		}
+	});
+}
@@ -0,0 +1,61 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MassEntityQuery.h"
+#include "MassProcessor.h"
+#include "DRMassProcessors.generated.h"
+
+class ADRMassCrowdActor;
+
+/**
+ * Server: steps the movers of one crowd, see ADRCrowdActor::StepMovers. Chunks run in parallel,
+ * each entity writes only its own item of the crowd's fast array.
+ * Not registered with the processing phases, ADRMassCrowdActor runs it on its own fixed step clock.
+ */
+UCLASS()
+class DEADRECKONINGTEST_API UDRMassServerMotionProcessor : public UMassProcessor
+{
+	GENERATED_BODY()
+
+public:
+	UDRMassServerMotionProcessor();
+
+	ADRMassCrowdActor* Crowd = nullptr; // Owner, only its chunks are processed
+	int32 NumSteps = 0;
+	float StepTime = 0.0f;
+
+protected:
+	virtual void ConfigureQueries() override;
+	virtual void Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context) override;
+
+private:
+	FMassEntityQuery EntityQuery;
+};
+
+/**
+ * Client: projective velocity blending of the proxies of one crowd, the same math as
+ * UDRDeadReckoningSubsystem. Chunks run in parallel and write the render positions into
+ * the crowd's instance transforms, which the crowd flushes to its mesh afterwards.
+ */
+UCLASS()
+class DEADRECKONINGTEST_API UDRMassExtrapolationProcessor : public UMassProcessor
+{
+	GENERATED_BODY()
+
+public:
+	UDRMassExtrapolationProcessor();
+
+	ADRMassCrowdActor* Crowd = nullptr; // Owner, only its chunks are processed
+	int32 NumSteps = 0;
+	float StepTime = 0.0f;
+	double Alpha = 0.0; // Render position between the last two steps
+
+protected:
+	virtual void ConfigureQueries() override;
+	virtual void Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context) override;
+
+private:
+	FMassEntityQuery EntityQuery;
+};
@@ -0,0 +1,111 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "DRMotionDescriptor.h"
+
+#include "Engine/NetSerialization.h"
+#include "Serialization/BitReader.h"
+#include "Serialization/BitWriter.h"
+
+
+namespace MotionDescriptorSerialization
+{
+	// 0.1 unit precision
+	bool SerializeOrigin(FVector& Origin, FArchive& Ar)
+	{
+		return SerializePackedVector<10, 24>(Origin, Ar);
+	}
+
+	// Origin as it reads back from the wire
+	FVector QuantizeOrigin(const FVector& InOrigin)
+	{
+		FVector Origin = InOrigin;
+		FBitWriter Writer(0, true);
+		SerializeOrigin(Origin, Writer);
+		FBitReader Reader(Writer.GetData(), Writer.GetNumBits());
+		SerializeOrigin(Origin, Reader);
+		return Origin;
+	}
+}
+
+static_assert(sizeof(FDRMotionDescriptor::Values) == sizeof(DRCore::FMotionDescription::Values), "Values must hold every value of a description");
+
+FDRMotionDescriptor FDRMotionDescriptor::FromCore(const DRCore::FMotionDescriptor& InDescriptor)
+{
+	const DRCore::FMotionDescription Description = InDescriptor.Describe();
+	FDRMotionDescriptor Descriptor;
+	Descriptor.bValid = true;
+	Descriptor.MotionType = static_cast<uint8>(Description.Type);
+	// Quantized like the wire, so the descriptor compares equal to what clients receive
+	Descriptor.Origin = MotionDescriptorSerialization::QuantizeOrigin(FVector(Description.Origin.X, Description.Origin.Y, Description.Origin.Z));
+	FMemory::Memcpy(Descriptor.Values, Description.Values, sizeof(Descriptor.Values));
+	// Millisecond precision is enough for the phase, rounding here keeps server and clients identical
+	Descriptor.StartTime = FMath::RoundToDouble(InDescriptor.StartTime * 1000.0) * 0.001;
+	return Descriptor;
+}
+
+DRCore::FMotionDescriptor FDRMotionDescriptor::ToCore() const
+{
+	DRCore::FMotionDescription Description;
+	Description.Type = static_cast<DRCore::EMotionType>(MotionType);
+	Description.Origin = DRCore::FVec3(Origin.X, Origin.Y, Origin.Z);
+	FMemory::Memcpy(Description.Values, Values, sizeof(Values));
+	return DRCore::FMotionDescriptor::FromDescription(Description, StartTime);
+}
+
+FString FDRMotionDescriptor::ToString() const
+{
+	const DRCore::FMotionDescriptor Descriptor = ToCore();
+	TStringBuilder<128> SB;
+	SB.Appendf(TEXT("%hs Motion\n"), Descriptor.GetName());
+	for(int32 i = 0; i < DRCore::FMotionDescription::MaxValues; ++i)
+	{
+		SB.Appendf(TEXT("%s%hs = %.1f"), i > 0 ? TEXT(", ") : TEXT(""), Descriptor.GetValueName(i), Values[i]);
+	}
+	return SB.ToString();
+}
+
+FDRMotionDescriptor FDRMotionDescriptor::GetNetSerialized() const
+{
+	FDRMotionDescriptor Copy = *this;
+	bool bSuccess = false;
+	FBitWriter Writer(0, true);
+	Copy.NetSerialize(Writer, nullptr, bSuccess);
+
+	FDRMotionDescriptor Received;
+	FBitReader Reader(Writer.GetData(), Writer.GetNumBits());
+	Received.NetSerialize(Reader, nullptr, bSuccess);
+	return Received;
+}
+
+bool FDRMotionDescriptor::NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess)
+{
+	uint8 bValidBit = bValid;
+	Ar.SerializeBits(&bValidBit, 1);
+	bValid = bValidBit != 0;
+
+	if(bValid)
+	{
+		// Motion types are numbered from zero, one per policy of the variant
+		uint32 Type = MotionType;
+		Ar.SerializeInt(Type, std::variant_size_v<DRCore::FMotionVariant>);
+		MotionType = static_cast<uint8>(Type);
+
+		bOutSuccess = MotionDescriptorSerialization::SerializeOrigin(Origin, Ar);
+		for(float& Value : Values)
+			Ar << Value;
+
+		// Signed, movers started part of the way around their path began before the world did
+		int32 StartTimeMs = static_cast<int32>(FMath::RoundToDouble(StartTime * 1000.0));
+		Ar << StartTimeMs;
+		if(Ar.IsLoading())
+			StartTime = StartTimeMs * 0.001;
+	}
+	else
+	{
+		bOutSuccess = true;
+	}
+
+	bOutSuccess &= !Ar.IsError();
+	return true;
+}
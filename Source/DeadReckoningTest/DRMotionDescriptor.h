@@ -0,0 +1,43 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DeadReckoningCore/DRCoreMotionDescriptor.h"
+#include "DRMotionDescriptor.generated.h"
+
+// Replicated description of a scripted motion, sent once and again only when it changes
+USTRUCT()
+struct FDRMotionDescriptor
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	bool bValid = false; // False until the server has filled the descriptor
+	UPROPERTY()
+	uint8 MotionType = 0; // DRCore::EMotionType
+	UPROPERTY()
+	FVector Origin = FVector::ZeroVector; // Where the motion policy places its path
+	UPROPERTY()
+	float Values[2] = {}; // DRCore::FMotionDescription::Values, named by the policy's ValueNames
+	UPROPERTY()
+	double StartTime = 0.0; // Server world time of the start of the motion, negative when it started part of the way around its path
+
+	static FDRMotionDescriptor FromCore(const DRCore::FMotionDescriptor& InDescriptor);
+	DRCore::FMotionDescriptor ToCore() const;
+
+	// The descriptor as clients receive it, so the server can evaluate the same parameters
+	FDRMotionDescriptor GetNetSerialized() const;
+
+	// Motion type and parameters for the info widget
+	FString ToString() const;
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FDRMotionDescriptor> : public TStructOpsTypeTraitsBase2<FDRMotionDescriptor>
+{
+	enum
+	{
+		WithNetSerializer = true // Enable network serialization
+	};
+};
@@ -0,0 +1,73 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "DRMover.h"
+
+#include "DRWorldSettings.h"
+
+
+DRCore::FKinematicState ToCore(const FKinematicState& InState)
+{
+	return DRCore::FKinematicState(ToCore(InState.Position), ToCore(InState.Velocity), ToCore(InState.Acceleration), InState.GetServerTime());
+}
+
+DRCore::FMotionSettings ToCoreMotionSettings(const ADRWorldSettings& InSettings)
+{
+	DRCore::FMotionSettings Settings;
+	Settings.MotionType = InSettings.IsCircleMovement ? DRCore::EMotionType::Circle : DRCore::EMotionType::Square;
+	Settings.Radius = InSettings.Radius;
+	Settings.AngularSpeed = ToCore(InSettings.AngularSpeed);
+	Settings.SideLength = InSettings.SideLength;
+	Settings.Speed = InSettings.Speed;
+	Settings.ReplicationTime = InSettings.ReplicationTime;
+	Settings.ReplicationPolicy = InSettings.ReplicationPolicy == EDRReplicationPolicy::PredictionError
+		? DRCore::EReplicationPolicy::PredictionError
+		: DRCore::EReplicationPolicy::Distance;
+	Settings.ReplicationErrorTolerance = InSettings.ReplicationErrorTolerance;
+	return Settings;
+}
+
+void FDRMover::Initialize(const ADRWorldSettings& InSettings, const FVector& InCenter)
+{
+	DRCore::FMover::Initialize(ToCoreMotionSettings(InSettings), ToCore(InCenter));
+}
+
+void FDRMover::InitializeStress(const ADRWorldSettings& InSettings, int32 InIndex, const FVector& InOrigin)
+{
+	const FDRStressTestSettings& Stress = InSettings.StressTest;
+	FRandomStream Random(HashCombine(GetTypeHash(Stress.Seed), GetTypeHash(InIndex)));
+
+	DRCore::FMotionSettings Settings = ToCoreMotionSettings(InSettings);
+	Settings.MotionType = Random.FRand() < Stress.CircleFraction ? DRCore::EMotionType::Circle : DRCore::EMotionType::Square;
+	Settings.Radius = Random.FRandRange(Stress.RadiusRange.X, Stress.RadiusRange.Y);
+	Settings.AngularSpeed = DRCore::FRotator3(0.0, Random.FRandRange(Stress.AngularSpeedRange.X, Stress.AngularSpeedRange.Y), 0.0);
+	Settings.SideLength = Random.FRandRange(Stress.SideLengthRange.X, Stress.SideLengthRange.Y);
+	Settings.Speed = Random.FRandRange(Stress.SpeedRange.X, Stress.SpeedRange.Y);
+
+	const float HalfExtent = 0.5f * Stress.SpreadExtent;
+	const FVector Center = InOrigin + FVector(Random.FRandRange(-HalfExtent, HalfExtent), Random.FRandRange(-HalfExtent, HalfExtent), 0.0);
+	DRCore::FMover::Initialize(Settings, ToCore(Center));
+
+	// Drawn last so the other parameters do not depend on bRandomPhase. Also places circle movers on their path.
+	const float Phase = Random.FRand();
+	SetPhase(Stress.bRandomPhase ? Phase : 0.0);
+}
+
+bool FDRMover::Step(float In_DeltaTime, FKinematicState& InOut_ServerState)
+{
+	return Step(1, In_DeltaTime, InOut_ServerState) != INDEX_NONE;
+}
+
+// Kept out of line so the serial and parallel paths run the exact same code.
+// The state is converted once for all steps.
+int32 FDRMover::Step(int32 InNumSteps, float In_DeltaTime, FKinematicState& InOut_ServerState)
+{
+	DRCore::FKinematicState State = ToCore(InOut_ServerState);
+	const int32 LastSentStep = DRCore::FMover::Step(InNumSteps, In_DeltaTime, State);
+	if(LastSentStep < 0)
+		return INDEX_NONE;
+
+	InOut_ServerState.Position = ToFVector(State.Position);
+	InOut_ServerState.Velocity = ToFVector(State.Velocity);
+	return LastSentStep;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DRKinematicState.h"
+#include "DeadReckoningCore/DRCoreMover.h"
+
+class ADRWorldSettings;
+
+// Conversions between Unreal types and the engine-independent core
+inline DRCore::FVec3 ToCore(const FVector& InVector) { return DRCore::FVec3(InVector.X, InVector.Y, InVector.Z); }
+inline FVector ToFVector(const DRCore::FVec3& InVector) { return FVector(InVector.X, InVector.Y, InVector.Z); }
+inline DRCore::FRotator3 ToCore(const FRotator& InRotator) { return DRCore::FRotator3(InRotator.Pitch, InRotator.Yaw, InRotator.Roll); }
+DRCore::FKinematicState ToCore(const FKinematicState& InState);
+DRCore::FMotionSettings ToCoreMotionSettings(const ADRWorldSettings& InSettings);
+
+// Scripted server-side motion of a single pawn, the math lives in DRCore::FMover
+struct FDRMover : public DRCore::FMover
+{
+	// Copy motion parameters from the world settings, InCenter is the center of the path
+	void Initialize(const ADRWorldSettings& InSettings, const FVector& InCenter);
+	// Randomized motion of stress test mover InIndex, see FDRStressTestSettings. InOrigin is the center of the spread area.
+	void InitializeStress(const ADRWorldSettings& InSettings, int32 InIndex, const FVector& InOrigin);
+	using DRCore::FMover::Initialize;
+
+	// Advance the motion and update InOut_ServerState when the replication threshold is crossed.
+	// Returns true if the server state was changed.
+	bool Step(float In_DeltaTime, FKinematicState& InOut_ServerState);
+	// InNumSteps steps of In_DeltaTime, returns the index of the last step that changed InOut_ServerState or INDEX_NONE
+	int32 Step(int32 InNumSteps, float In_DeltaTime, FKinematicState& InOut_ServerState);
+};
@@ -3,46 +3,26 @@
 
 #include "DRPawn.h"
 
+#include "DeadReckoningTest.h"
+#include "DRCaptureSubsystem.h"
+#include "DRDeadReckoningSubsystem.h"
+#include "DRServerMotionSubsystem.h"
+#include "DRTrailComponent.h"
 #include "Camera/CameraComponent.h"
+#include "Engine/ActorChannel.h"
+#include "Engine/NetDriver.h"
+#include "DeadReckoningCore/DRCoreExtrapolator.h"
+#include "GameFramework/GameStateBase.h"
 #include "GameFramework/PlayerStart.h"
 #include "GameFramework/SpringArmComponent.h"
 #include "Kismet/GameplayStatics.h"
 #include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
 
+DECLARE_CYCLE_STAT(TEXT("Per-Actor Dead Reckoning"), STAT_DRPerActorDeadReckoning, STATGROUP_DeadReckoning);
 
-FKinematicState::FKinematicState()
-{
-	Position = FVector::ZeroVector;
-	Velocity = FVector::ZeroVector;
-	Acceleration = FVector::ZeroVector;
-}
-
-FKinematicState::FKinematicState(const FVector& In_Position, const FVector& In_Velocity, const FVector& In_Acceleration)
-{
-	Position = In_Position;
-	Velocity = In_Velocity;
-	Acceleration = In_Acceleration;
-}
-
-bool FKinematicState::NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess)
-{
-	Ar << Position;
-	Ar << Velocity;
-	Ar << Acceleration;
-	bOutSuccess = true;
-	return true;
-}
-
-FString FKinematicState::ToString() const
-{
-	TStringBuilder<256> SB;
-	SB.Appendf(TEXT("Position: %s "), *Position.ToCompactString());
-	SB.Appendf(TEXT("Velocity: %s [%f] "), *Velocity.ToCompactString(), Velocity.Length());
-	SB.Appendf(TEXT("Acceleration: %f"), Acceleration.Length() * FMath::Sign(Acceleration.X));
-	return SB.ToString();
-}
 
-ADRPawn::ADRPawn() : TimeStampCollector(1.0f, 1.0f)
+ADRPawn::ADRPawn() : TimeStampCollector(1.0, 1.0), ArrivalCollector(1.0, 1.0)
 {
 	
 	PrimaryActorTick.bCanEverTick = true;
@@ -54,6 +34,11 @@ ADRPawn::ADRPawn() : TimeStampCollector(1.0f, 1.0f)
 	RootComponent = BaseMesh;
 	BaseMesh->SetupAttachment(RootCapsuleComponent);
 
+#if DR_ENABLE_TRAILS
+	TrailComponent = CreateDefaultSubobject<UDRTrailComponent>(TEXT("Trail"));
+	TrailComponent->SetupAttachment(BaseMesh);
+#endif
+
 	CameraBoom = CreateDefaultSubobject<USpringArmComponent>(TEXT("CameraBoom"));
 	CameraBoom->bUsePawnControlRotation = false;
 
@@ -64,6 +49,7 @@ ADRPawn::ADRPawn() : TimeStampCollector(1.0f, 1.0f)
 	// Initialize variables for dead reckoning
 	ServerUpdateTime = 1 / NetUpdateFrequency;
 	AverageServerUpdateTime = 1 / NetUpdateFrequency;
+	BlendTime = AverageServerUpdateTime;
 	DeadReckon_T = 0.f;
 	Server_T_SinceLastFrame = 0.f;
 }
@@ -71,7 +57,15 @@ ADRPawn::ADRPawn() : TimeStampCollector(1.0f, 1.0f)
 void ADRPawn::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
-	DOREPLIFETIME_CONDITION_NOTIFY(ADRPawn, Server_KinematicState, COND_None, REPNOTIFY_OnChanged);
+
+	// Both only change on thresholds or once, so they are pushed instead of compared every net tick
+	FDoRepLifetimeParams PushParams;
+	PushParams.bIsPushBased = true;
+	PushParams.RepNotifyCondition = REPNOTIFY_OnChanged;
+	DOREPLIFETIME_WITH_PARAMS_FAST(ADRPawn, Server_KinematicState, PushParams);
+	DOREPLIFETIME_WITH_PARAMS_FAST(ADRPawn, MotionDescriptor, PushParams);
+	DOREPLIFETIME_CONDITION(ADRPawn, CaptureId, COND_InitialOnly);
+	DOREPLIFETIME_CONDITION(ADRPawn, StressIndex, COND_InitialOnly);
 }
 
 
@@ -87,46 +81,116 @@ void ADRPawn::BeginPlay()
 	FVector PlayerStartPosition = GetPlayerStartPosition();
 
 	// Initialize motion parameters
-	Radius = GetDRWorldSettings()->Radius;
-	AngularSpeed = GetDRWorldSettings()->AngularSpeed;
-	
-	SideLength = GetDRWorldSettings()->SideLength;
-	Speed = GetDRWorldSettings()->Speed;
-
-	ReplicationTime = GetDRWorldSettings()->ReplicationTime;
-	ReplicationDistSquare = Speed * ReplicationTime;
-	ReplicationDistCircle = ReplicationTime * FMath::DegreesToRadians(AngularSpeed.Yaw) * Radius;
+	if(IsStressPawn())
+		Mover.InitializeStress(*GetDRWorldSettings(), StressIndex, PlayerStartPosition);
+	else
+		Mover.Initialize(*GetDRWorldSettings(), PlayerStartPosition);
 
 	// Setup camera properties
 	CameraBoom->TargetArmLength = CameraDistance;
 	CameraBoom->SetRelativeLocation(FVector(0, 0, CameraSpringZLocation));
-
-	CenterCircleMovement = PlayerStartPosition;
-	StartPositionSquareMovement = FVector(PlayerStartPosition.X - SideLength / 2, PlayerStartPosition.Y - SideLength / 2, 0);
-	CurrentVelocity = FVector::ForwardVector * Speed;
 	
-	if(!GetDRWorldSettings()->IsCircleMovement)
-	{
-		DrawDebugLifetime = 4 * SideLength / Speed;
-		SetActorLocation(StartPositionSquareMovement);
-	}
-	else
-	{
-		DrawDebugLifetime = 360.0f / AngularSpeed.Yaw;
-	}
+	DrawDebugLifetime = static_cast<float>(Mover.GetPeriod());
+	SetActorLocation(ToFVector(Mover.Location));
+	ServerStepper = GetDRWorldSettings()->MakeFixedStepAccumulator();
+	ClientStepper = GetDRWorldSettings()->MakeFixedStepAccumulator();
+	CaptureSubsystem = GetWorld()->GetSubsystem<UDRCaptureSubsystem>();
 	
 	if(HasAuthority())	
 	{	
+		static uint32 NextCaptureId = 0;
+		CaptureId = ++NextCaptureId;
+
 		Server_KinematicState = FKinematicState(GetActorLocation(), FVector::Zero(), FVector::Zero());
+		Server_KinematicState.SetServerTime(GetWorld()->GetTimeSeconds());
+
+		// Iris prioritizes with its own net object prioritizers and never calls GetNetPriority
+		const UNetDriver* NetDriver = GetNetDriver();
+		bErrorPriorityScheduling = GetDRWorldSettings()->bErrorPriorityScheduling && GetDRWorldSettings()->KinematicTransport == EDRKinematicTransport::PropertyReplication
+			&& NetDriver != nullptr && !NetDriver->IsUsingIrisReplication();
+		MarkServerStateDirty();
+
+		// Server_KinematicState keeps the initial state for new connections, the stream continues from a copy
+		bStreamKinematicState = GetDRWorldSettings()->KinematicTransport == EDRKinematicTransport::UnreliableStream;
+		Server_StreamedState = Server_KinematicState;
+
+		if(GetDRWorldSettings()->bReplicateMotionDescriptor)
+		{
+			MotionDescriptor = FDRMotionDescriptor::FromCore(DRCore::FMotionDescriptor::FromMover(Mover, GetWorld()->GetTimeSeconds()));
+			ParametricMotion = MotionDescriptor.GetNetSerialized().ToCore();
+			bParametricMotion = true;
+			MARK_PROPERTY_DIRTY_FROM_NAME(ADRPawn, MotionDescriptor, this);
+		}
+
+		if(GetDRWorldSettings()->bParallelServerMotion)
+		{
+			if(UDRServerMotionSubsystem* Subsystem = GetWorld()->GetSubsystem<UDRServerMotionSubsystem>())
+			{
+				ServerMotionHandle = Subsystem->RegisterPawn(this);
+				SetActorTickEnabled(ServerMotionHandle == INDEX_NONE);
+			}
+		}
 	}
 	else
 	{
-		GetDRController()->UpdateMotionInfoWidget(GetDRWorldSettings()->IsCircleMovement, Radius, AngularSpeed.Yaw, SideLength, Speed);
+		if(ADRController* DRController = GetDRController())
+		{
+			DRController->UpdateMotionInfoWidget(FDRMotionDescriptor::FromCore(DRCore::FMotionDescriptor::FromMover(Mover, 0.0)).ToString());
+		}
 		Client_KinematicState = FKinematicState(GetActorLocation(), FVector::Zero(), FVector::Zero());
+		PreviousClientPosition = Client_KinematicState.Position;
+
+		const ADRWorldSettings* Settings = GetDRWorldSettings();
+		BlendTimeEstimate = Settings->GetBlendTimeEstimate();
+		TimeStampCollector.SetQuantile(Settings->BlendTimePercentile);
+		TimeStampCollector.SetEwmaSmoothing(Settings->BlendTimeEwmaSmoothing);
+
+		SmoothingMode = Settings->GetClientSmoothingMode(GetClass());
+		MaxInterpolationExtrapolation = Settings->MaxInterpolationExtrapolation;
+		if(SmoothingMode == EDRClientSmoothingMode::SnapshotInterpolation)
+		{
+			SnapshotInterpolator = DRCore::FSnapshotInterpolator(Settings->SnapshotBufferCapacity);
+		}
+
+		// The batched subsystem only extrapolates
+		const bool bExtrapolate = !bParametricMotion && SmoothingMode == EDRClientSmoothingMode::Extrapolation;
+		UDRDeadReckoningSubsystem* Subsystem = bExtrapolate ? GetDeadReckoningSubsystem() : nullptr;
+		if(Subsystem != nullptr)
+		{
+			DeadReckoningHandle = Subsystem->RegisterPawn(this, Client_KinematicState, Server_KinematicState, BlendTime);
+			SetActorTickEnabled(DeadReckoningHandle == INDEX_NONE);
+		}
 	}
 	
 }
 
+void ADRPawn::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if(DeadReckoningHandle != INDEX_NONE)
+	{
+		if(UDRDeadReckoningSubsystem* Subsystem = GetWorld()->GetSubsystem<UDRDeadReckoningSubsystem>())
+		{
+			Subsystem->Unregister(DeadReckoningHandle);
+		}
+		DeadReckoningHandle = INDEX_NONE;
+	}
+	if(ServerMotionHandle != INDEX_NONE)
+	{
+		if(UDRServerMotionSubsystem* Subsystem = GetWorld()->GetSubsystem<UDRServerMotionSubsystem>())
+		{
+			Subsystem->UnregisterPawn(ServerMotionHandle);
+		}
+		ServerMotionHandle = INDEX_NONE;
+	}
+	Super::EndPlay(EndPlayReason);
+}
+
+SIZE_T ADRPawn::GetAllocatedSize() const
+{
+	return TimeStampCollector.GetAllocatedSize() + Mover.ShadowClient.TimeStampCollector.GetAllocatedSize()
+		+ SnapshotInterpolator.GetSnapshots().GetAllocatedSize() + ArrivalCollector.GetAllocatedSize() + SentStates.GetAllocatedSize();
+}
+
 // Get a reference to the custom controller
 ADRController* ADRPawn::GetDRController() const
 {
@@ -142,6 +206,14 @@ ADRWorldSettings* ADRPawn::GetDRWorldSettings() const
 	return WorldSettings;
 }
 
+UDRDeadReckoningSubsystem* ADRPawn::GetDeadReckoningSubsystem() const
+{
+	const ADRWorldSettings* WorldSettings = GetDRWorldSettings();
+	if(WorldSettings == nullptr || !WorldSettings->bUseBatchedDeadReckoning)
+		return nullptr;
+	return GetWorld()->GetSubsystem<UDRDeadReckoningSubsystem>();
+}
+
 // Find the starting position for the player
 FVector ADRPawn::GetPlayerStartPosition() const
 {
@@ -162,6 +234,12 @@ FVector ADRPawn::GetPlayerStartPosition() const
 	return FVector::ZeroVector;
 }
 
+double ADRPawn::GetServerWorldTime() const
+{
+	const AGameStateBase* GameState = GetWorld()->GetGameState();
+	return GameState != nullptr ? GameState->GetServerWorldTimeSeconds() : GetWorld()->GetTimeSeconds();
+}
+
 // Tick function to handle movement logic
 void ADRPawn::Tick(float DeltaTime)
 {
@@ -169,146 +247,328 @@ void ADRPawn::Tick(float DeltaTime)
 	
 	if(HasAuthority())
 	{
-		if(GetDRWorldSettings()->IsCircleMovement)
-			MoveСircleServer(DeltaTime);
-		else
-			MoveSquareServer(DeltaTime);
+		SimulateServerMotion(DeltaTime);
+		ApplyServerMotion();
+	}
+	else if(bParametricMotion)
+	{
+		MoveParametric();
+	}
+	else if(SmoothingMode == EDRClientSmoothingMode::SnapshotInterpolation)
+	{
+		InterpolateMove();
 	}
 	else
 	{
-		DeadReckon_T += DeltaTime;
-		DeadReckon_T_Hat = DeadReckon_T / AverageServerUpdateTime;
-		if(DeadReckon_T_Hat > MaxDeadReckon_T_Hat)
-		{
-			DeadReckon_T_Hat = MaxDeadReckon_T_Hat;
-		}
+		SCOPE_CYCLE_COUNTER(STAT_DRPerActorDeadReckoning);
+		const uint64 StartCycles = FPlatformTime::Cycles64();
 		DeadReckoningMove(DeltaTime);
+		if(UDRDeadReckoningSubsystem* Subsystem = GetWorld()->GetSubsystem<UDRDeadReckoningSubsystem>())
+			Subsystem->RecordPerActorCycles(FPlatformTime::Cycles64() - StartCycles);
 	}
 
 }
 
-// Logic for moving in a circular path on the server
-void ADRPawn::MoveСircleServer(float In_DeltaTime)
+// Advance the scripted motion and dirty the replicated state when the threshold is crossed
+void ADRPawn::SimulateServerMotion(float In_DeltaTime)
 {
-	const FRotator Rot = AngularSpeed * In_DeltaTime;
-	CurrentDirection = Rot.RotateVector(CurrentDirection);
-	CurrentDirection.Normalize();
+	// Clients evaluate the same closed form, so there is nothing to replicate
+	if(bParametricMotion)
+	{
+		Mover.PreviousLocation = Mover.Location;
+		Mover.Location = ParametricMotion.Evaluate(GetWorld()->GetTimeSeconds());
+		return;
+	}
 
-	const FVector PreviousLocation = GetActorLocation();
-	const FVector NewLocation = CenterCircleMovement + CurrentDirection * Radius;
+	// States are stamped with the time of the step that produced them
+	const int32 NumSteps = ServerStepper.Advance(In_DeltaTime);
+	const float StepTime = static_cast<float>(ServerStepper.GetStepTime());
+	const double LastStepTime = GetWorld()->GetTimeSeconds() - ServerStepper.GetRemainder();
+	FKinematicState& ServerState = GetServerState();
+	const int32 LastSentStep = Mover.Step(NumSteps, StepTime, ServerState);
+	if(LastSentStep != INDEX_NONE)
+	{
+		ServerState.SetServerTime(LastStepTime - (NumSteps - 1 - LastSentStep) * StepTime);
+		bServerStateChanged = true;
+	}
+}
 
-	const float v = FMath::DegreesToRadians(AngularSpeed.Yaw) * Radius;
-	const FVector Tangent = FVector::UpVector.Cross(CurrentDirection);
-	const FVector Velocity = Tangent * v;
+void ADRPawn::ApplyServerMotion()
+{
+	// Push model dirty tracking is not thread safe, so it is deferred to the game thread
+	if(bServerStateChanged)
+	{
+		MarkServerStateDirty();
+		bServerStateChanged = false;
+		FDRTelemetry::Get().RecordUpdateSent();
 
-	FVector VectorA = NewLocation - CenterCircleMovement;
-	FVector VectorB = Server_KinematicState.Position - CenterCircleMovement;
+		if(CaptureSubsystem && CaptureSubsystem->IsCapturing())
+			CaptureSubsystem->RecordState(CaptureId, GetServerState());
+	}
 
-	VectorA.Normalize();
-	VectorB.Normalize();
+	if(CaptureSubsystem && CaptureSubsystem->IsCapturing())
+	{
+		const double ServerTime = GetWorld()->GetTimeSeconds() - ServerStepper.GetRemainder();
+		if(CaptureSubsystem->ShouldRecordTruth(LastTruthCaptureTime, ServerTime))
+			CaptureSubsystem->RecordTruth(CaptureId, ServerTime, ToFVector(Mover.Location), ToFVector(Mover.Velocity));
+	}
 
-	float AngleInRadians = FMath::Acos(FVector::DotProduct(VectorA, VectorB));
-	float ArcLength = Radius * AngleInRadians;
-	
-	 if(ArcLength > ReplicationDistCircle)
-	 {
-	 	Server_KinematicState.Velocity = Velocity;
-	 	Server_KinematicState.Position = NewLocation;
-	 }
+	// The closed form is evaluated at the frame time, stepped motion is drawn between its last two steps
+	const FVector OldLocation = GetActorLocation();
+	const FVector NewLocation = ToFVector(bParametricMotion ? Mover.Location : Mover.GetInterpolatedLocation(ServerStepper.GetAlpha()));
 	SetActorLocation(NewLocation);
-	CustomDrawDebugLine(PreviousLocation, NewLocation, FColor::Green, 5.0f, 10.0f);
+	CustomDrawDebugLine(OldLocation, NewLocation, FColor::Green, 5.0f, 10.0f);
 }
 
-// Logic for square path movement
-void ADRPawn::MoveSquareServer(float In_DeltaTime)
+void ADRPawn::MarkServerStateDirty()
 {
-	const FVector PreviousLocation = GetActorLocation();
-	FVector Position = PreviousLocation + CurrentVelocity * In_DeltaTime;
-	
-	float DistStep = CurrentVelocity.Size() * In_DeltaTime;
-	PassedDistance += DistStep;
-	
-	float DeltaDist = SideLength - PassedDistance;
-	if(DeltaDist < 0)
+	// The property is never dirtied again while streaming, so it cannot be sent alongside the stream
+	if(bStreamKinematicState)
 	{
-		Position += DeltaDist * CurrentVelocity.GetSafeNormal();
-		PassedDistance = 0.0f;
-		CurrentVelocity = TurnRight.RotateVector(CurrentVelocity);
+		MulticastKinematicState(++KinematicSequence, Server_StreamedState);
+		return;
 	}
-	SetActorLocation(Position);
-	
-	float Dist = FVector::Distance(Position, Server_KinematicState.Position);
-	if(Dist > ReplicationDistSquare)
-	{	
-		Server_KinematicState.Velocity = CurrentVelocity;
-		Server_KinematicState.Position = Position;
+
+	MARK_PROPERTY_DIRTY_FROM_NAME(ADRPawn, Server_KinematicState, this);
+
+	const UNetDriver* NetDriver = GetNetDriver();
+	if(bErrorPriorityScheduling && NetDriver != nullptr)
+	{
+		if(SentStates.IsFull())
+			SentStates.PopFront();
+		SentStates.Add(FDRSentState{ NetDriver->GetElapsedTime(), Server_KinematicState });
 	}
-	
-	CustomDrawDebugLine(PreviousLocation, GetActorLocation(), FColor::Green, 5.0f, 10.0f);
+}
+
+// Connections that skipped states only receive the newest one, so a client is predicting from
+// the state that was current when its channel last replicated this pawn. The estimate extrapolates
+// that state on its own, it does not replay the client's blend from its previous prediction towards
+// it nor the steps a reduced significance tier holds back. Right after an update and for far pawns the
+// client is further off than this, so the estimate ranks pawns rather than measuring their error.
+float ADRPawn::GetClientErrorEstimate(double InLastUpdateTime) const
+{
+	int32 Index = SentStates.Num() - 1;
+	while(Index > 0 && SentStates[Index].NetTime > InLastUpdateTime)
+		--Index;
+
+	FKinematicState Prediction = SentStates[Index].State;
+	Prediction.Extrapolate(static_cast<float>(GetWorld()->GetTimeSeconds() - Prediction.GetServerTime()));
+	return static_cast<float>(FVector::Dist(Prediction.Position, GetActorLocation()));
+}
+
+// Called per connection by the net driver, which replicates pawns in priority order until the
+// connection's budget for the frame is used up. Pawns left over stay dirty and are sent with
+// their newest state in a later frame, with the time waited added to their priority.
+float ADRPawn::GetNetPriority(const FVector& ViewPos, const FVector& ViewDir, AActor* Viewer, AActor* ViewTarget, UActorChannel* InChannel, float Time, bool bLowBandwidth)
+{
+	const ADRWorldSettings* Settings = GetDRWorldSettings();
+	if(Settings == nullptr || !bErrorPriorityScheduling || InChannel == nullptr || SentStates.IsEmpty() || bParametricMotion)
+		return Super::GetNetPriority(ViewPos, ViewDir, Viewer, ViewTarget, InChannel, Time, bLowBandwidth);
+
+	const float Error = GetClientErrorEstimate(InChannel->LastUpdateTime);
+	const float DistanceWeight = Settings->PriorityFalloffDistance / (Settings->PriorityFalloffDistance + static_cast<float>(FVector::Dist(ViewPos, GetActorLocation())));
+	return NetPriority * (Error / Settings->PriorityErrorReference + Time) * DistanceWeight;
 }
 
 // Logic for dead reckoning movement on the client
 void ADRPawn::DeadReckoningMove(float In_DeltaTime)
 {
 	Client_KinematicState.Acceleration = Server_KinematicState.Acceleration;
-	const FVector P1 = Client_KinematicState.Position + Client_KinematicState.Velocity * In_DeltaTime + Client_KinematicState.Acceleration * In_DeltaTime * In_DeltaTime * 0.5;
-	const FVector P2 = Server_KinematicState.Position + Server_KinematicState.Velocity * In_DeltaTime + Server_KinematicState.Acceleration * In_DeltaTime * In_DeltaTime * 0.5;
-	FVector DeadReckonedPos = P1;
-	FVector DeltaP = P2 - P1;
-	DeadReckonedPos += DeltaP * DeadReckon_T_Hat;
-
-	FVector OldPos = Client_KinematicState.Position;
-	Client_KinematicState.Position = DeadReckonedPos;
-	SetActorLocation(Client_KinematicState.Position);
-	
-	Server_KinematicState.Position += Server_KinematicState.Velocity * In_DeltaTime + Server_KinematicState.Acceleration * In_DeltaTime * In_DeltaTime / 2;
-	Server_KinematicState.Velocity = Server_KinematicState.Velocity + Server_KinematicState.Acceleration * In_DeltaTime;
-	
-	Client_KinematicState.Velocity = Client_KinematicState.Velocity + Client_KinematicState.Acceleration * In_DeltaTime;
-	Client_KinematicState.Velocity = Client_KinematicState.Velocity + (Server_KinematicState.Velocity - Client_KinematicState.Velocity) * DeadReckon_T_Hat;
 
-	DrawShape(OldPos, DeadReckonedPos, FColor::Red, 5.0f);
+	int32 StepInterval = 1;
+	const UDRDeadReckoningSubsystem* Subsystem = GetWorld()->GetSubsystem<UDRDeadReckoningSubsystem>();
+	if(Subsystem != nullptr && Subsystem->IsSignificanceEnabled())
+	{
+		ExtrapolationTier = Subsystem->ClassifySignificance(GetActorLocation(), this, ExtrapolationTier);
+		StepInterval = Subsystem->GetStepInterval(ExtrapolationTier);
+	}
+
+	// Reduced tiers advance several steps at once, like the batched entities
+	const int32 NumSteps = ClientStepper.Advance(In_DeltaTime);
+	const float StepTime = static_cast<float>(ClientStepper.GetStepTime());
+	for(int32 Step = 0; Step < NumSteps; ++Step)
+	{
+		PendingClientTime += StepTime;
+		if(++PendingClientSteps < StepInterval)
+			continue;
+		const float DeltaTime = PendingClientTime;
+		PendingClientSteps = 0;
+		PendingClientTime = 0.0f;
+
+		DeadReckon_T += DeltaTime;
+		DeadReckon_T_Hat = DRCore::ComputeBlendFactor(DeadReckon_T, BlendTime, MaxDeadReckon_T_Hat);
+		FDRTelemetry::Get().RecordBlendFactor(DeadReckon_T_Hat, MaxDeadReckon_T_Hat);
+
+		PreviousClientPosition = Client_KinematicState.Position;
+		if(ExtrapolationTier == DRCore::EExtrapolationTier::Linear)
+		{
+			DRCore::LinearVelocityBlend(Client_KinematicState.Position, Client_KinematicState.Velocity,
+				Server_KinematicState.Position, Server_KinematicState.Velocity, DeadReckon_T_Hat, DeltaTime);
+		}
+		else
+		{
+			DRCore::ProjectiveVelocityBlend(Client_KinematicState.Position, Client_KinematicState.Velocity,
+				Server_KinematicState.Position, Server_KinematicState.Velocity, Server_KinematicState.Acceleration,
+				DeadReckon_T_Hat, DeltaTime);
+		}
+		if(DeltaTime > StepTime)
+			PreviousClientPosition = Client_KinematicState.Position - Client_KinematicState.Velocity * StepTime;
+	}
+
+	// While steps are pending the pawn is carried along its velocity, one step behind like the blend
+	const FVector OldPos = GetActorLocation();
+	const float Alpha = static_cast<float>(ClientStepper.GetAlpha());
+	const FVector NewPos = PendingClientTime == 0.0f ? FMath::Lerp(PreviousClientPosition, Client_KinematicState.Position, Alpha)
+		: Client_KinematicState.Position + Client_KinematicState.Velocity * (PendingClientTime - StepTime * (1.0f - Alpha));
+	SetActorLocation(NewPos);
+
+	DrawShape(OldPos, NewPos, FColor::Red, 5.0f);
 	
 }
 
+// Evaluate the replicated motion at the estimated server time
+void ADRPawn::MoveParametric()
+{
+	const FVector OldPos = GetActorLocation();
+	DRCore::FVec3 Velocity;
+	Client_KinematicState.Position = ToFVector(ParametricMotion.Evaluate(GetServerWorldTime(), &Velocity));
+	Client_KinematicState.Velocity = ToFVector(Velocity);
+	SetActorLocation(Client_KinematicState.Position);
+
+	DrawShape(OldPos, Client_KinematicState.Position, FColor::Red, 5.0f);
+}
+
+// Sample the snapshot buffer behind the estimated server time
+void ADRPawn::InterpolateMove()
+{
+	if(!ServerClockOffset.IsValid())
+		return;
+
+	const double RenderTime = FPlatformTime::Seconds() - ServerClockOffset.GetOffset() - InterpolationDelay;
+	DRCore::FVec3 Position, Velocity;
+	if(!SnapshotInterpolator.Sample(RenderTime, MaxInterpolationExtrapolation, Position, Velocity))
+		return;
+
+	const FVector OldPos = Client_KinematicState.Position;
+	Client_KinematicState.Position = ToFVector(Position);
+	Client_KinematicState.Velocity = ToFVector(Velocity);
+	SetActorLocation(Client_KinematicState.Position);
+
+	DrawShape(OldPos, Client_KinematicState.Position, FColor::Red, 5.0f);
+}
+
+// Unreliable messages are lost, duplicated or reordered by the network. Only a state newer than the
+// last one applied is used, then handled like a replicated one, so a late state never replaces a newer one.
+void ADRPawn::MulticastKinematicState_Implementation(uint16 InSequence, const FKinematicState& InState)
+{
+	if(HasAuthority())
+		return;
+
+	if(bReceivedKinematicSequence && !DRCore::IsNewerSequence(InSequence, KinematicSequence))
+	{
+		FDRTelemetry::Get().RecordUpdateDropped();
+		return;
+	}
+	KinematicSequence = InSequence;
+	bReceivedKinematicSequence = true;
+
+	// Clients keep their copy of the server state in the property, the server never changes it again
+	Server_KinematicState = InState;
+	OnRep_KinematicState();
+}
+
 // Callback when the server kinematic state is replicated
 void ADRPawn::OnRep_KinematicState()
 {
-	// Reset dead reckoning timer and update server timing
+	// Reset dead reckoning timer and update server timing from the server's own clock
 	DeadReckon_T = 0;
-	TimeStampCollector.Add(FDateTime::UtcNow());
+
+	// The previous server state is gone, a reduced tier catches up on the client's own motion instead
+	if(PendingClientTime > 0.0f)
+	{
+		Client_KinematicState.Extrapolate(PendingClientTime);
+		PreviousClientPosition = Client_KinematicState.Position - Client_KinematicState.Velocity * ClientStepper.GetStepTime();
+		PendingClientSteps = 0;
+		PendingClientTime = 0.0f;
+	}
+	const double ServerTime = Server_KinematicState.GetServerTime();
+	TimeStampCollector.Add(ServerTime);
 	if(TimeStampCollector.IsValid())
-		AverageServerUpdateTime = TimeStampCollector.GetAverageDuration();
-	
-	GetDRController()->UpdateAverageServerUpdateTimeInfoWidget(AverageServerUpdateTime);
+	{
+		AverageServerUpdateTime = static_cast<float>(TimeStampCollector.GetAverageDuration());
+		BlendTime = static_cast<float>(TimeStampCollector.GetDuration(BlendTimeEstimate));
+	}
+
+	// Extrapolate from the time the state was sampled rather than from its arrival
+	const FVector ReceivedPosition = Server_KinematicState.Position;
+	const double ReceiveTime = FPlatformTime::Seconds();
+	ServerClockOffset.AddSample(ReceiveTime, ServerTime);
+
+	if(CaptureSubsystem && CaptureSubsystem->IsCapturing())
+		CaptureSubsystem->RecordReceive(CaptureId, Server_KinematicState, ReceiveTime);
+
+	// Interpolation buffers the state as sampled, the delay covers the measured arrival jitter
+	if(SmoothingMode == EDRClientSmoothingMode::SnapshotInterpolation)
+	{
+		SnapshotInterpolator.AddSnapshot(ToCore(Server_KinematicState));
+		ArrivalCollector.Add(ReceiveTime);
+
+		const ADRWorldSettings* Settings = GetDRWorldSettings();
+		InterpolationDelay = static_cast<float>(DRCore::ComputeInterpolationDelay(ArrivalCollector.GetAverageDuration(), ArrivalCollector.GetJitter(),
+			Settings->InterpolationJitterMultiplier, Settings->MinInterpolationDelay, Settings->MaxInterpolationDelay));
+	}
+
+	// Advanced to the estimated current server time, the round trip covers the fastest one-way delay
+	const UDRDeadReckoningSubsystem* DeadReckoningSubsystem = GetWorld()->GetSubsystem<UDRDeadReckoningSubsystem>();
+	const double RoundTripTime = DeadReckoningSubsystem != nullptr ? DeadReckoningSubsystem->GetRoundTripTime() : 0.0;
+	const double StateAge = ServerClockOffset.GetLastSampleAge(RoundTripTime);
+	const float SampleAge = FMath::Min(static_cast<float>(StateAge), MaxSampleAge);
+	FDRTelemetry::Get().RecordStateAge(StateAge);
+	Server_KinematicState.Extrapolate(SampleAge);
+
+	// How far the client had drifted from the server truth at the time it was received
+	const float PredictionError = static_cast<float>(FVector::Dist(Client_KinematicState.Position, Server_KinematicState.Position));
+	Telemetry.AddError(PredictionError);
+	FDRTelemetry::Get().RecordUpdateReceived(PredictionError);
+
+	if(DeadReckoningHandle != INDEX_NONE)
+	{
+		GetWorld()->GetSubsystem<UDRDeadReckoningSubsystem>()->SetServerState(DeadReckoningHandle, Server_KinematicState, BlendTime);
+	}
 	
-	float PointRadius = FMath::Min(10.f, 0.3f * ReplicationDistSquare);
-	DrawDebugSphere(GetWorld(),	GetActorLocation(), PointRadius, 12, FColor::Red, false, DrawDebugLifetime, 0, 2.0f);
-	DrawDebugSphere(GetWorld(),	Server_KinematicState.Position, PointRadius, 12, FColor::Yellow, false, DrawDebugLifetime, 0, 2.0f);
+#if DR_ENABLE_TRAILS
+	float PointRadius = FMath::Min(10.f, 0.3f * Mover.Replication.Distance);
+	TrailComponent->AddMarker(GetActorLocation(), PointRadius, FColor::Red, 2.0f, DrawDebugLifetime);
+	TrailComponent->AddMarker(ReceivedPosition, PointRadius, FColor::Yellow, 2.0f, DrawDebugLifetime);
+#endif
 }
 
 void ADRPawn::CustomDrawDebugLine(const FVector& From, const FVector& To, FColor Color, float Thickness, float InLifeTime) const
 {
-	DrawDebugLine(
-		GetWorld(),
-		From,
-		To,
-		Color,
-		false,
-		InLifeTime,      
-		0,           
-		Thickness       
-	);
+#if DR_ENABLE_TRAILS
+	TrailComponent->AddSegment(From, To, Color, Thickness, InLifeTime);
+#endif
 }
 
 void ADRPawn::DrawShape(const FVector& OldPos, const FVector& NewPos, FColor Color, float Thickness) const
 {
-	if(GetDRWorldSettings()->IsCircleMovement)
-		CustomDrawDebugLine(OldPos, NewPos, Color, Thickness, DrawDebugLifetime);
-	else
-		CustomDrawDebugLine(OldPos, NewPos, Color, Thickness, DrawDebugLifetime);
+	CustomDrawDebugLine(OldPos, NewPos, Color, Thickness, DrawDebugLifetime);
 }
 
+// Callback when the motion descriptor is replicated
+void ADRPawn::OnRep_MotionDescriptor()
+{
+	bParametricMotion = MotionDescriptor.bValid;
+	if(!bParametricMotion)
+		return;
 
+	ParametricMotion = MotionDescriptor.ToCore();
 
-
+	// The batched extrapolation is not needed anymore
+	if(DeadReckoningHandle != INDEX_NONE)
+	{
+		GetWorld()->GetSubsystem<UDRDeadReckoningSubsystem>()->Unregister(DeadReckoningHandle);
+		DeadReckoningHandle = INDEX_NONE;
+		SetActorTickEnabled(true);
+	}
+}
@@ -2,42 +2,23 @@
 
 #include "CoreMinimal.h"
 #include "DRController.h"
+#include "DRKinematicState.h"
+#include "DRMover.h"
+#include "DRMotionDescriptor.h"
+#include "DRTelemetry.h"
 #include "DRWorldSettings.h"
 #include "Components/CapsuleComponent.h"
 #include "GameFramework/Pawn.h"
+#include "DeadReckoningCore/DRCoreInterpolator.h"
+#include "Utilities/ClockOffsetEstimator.h"
 #include "Utilities/TimeDataCollector.h"
 #include "DRPawn.generated.h"
 
-// Structure representing the state of motion (position, velocity, acceleration)
-USTRUCT()
-struct FKinematicState
+// Replicated state and the net driver time it was marked dirty at, see ADRPawn::GetNetPriority
+struct FDRSentState
 {
-	GENERATED_BODY()
-	
-	UPROPERTY()
-	FVector Position; // Current position of the pawn
-	UPROPERTY()
-	FVector Velocity; // Current velocity of the pawn
-	UPROPERTY()
-	FVector Acceleration; // Current acceleration of the pawn
-
-	FKinematicState(); // Default constructor
-	FKinematicState(const FVector& In_Position, const FVector& In_Velocity, const FVector& In_Acceleration); // Parameterized constructor
-
-	// Serialize the kinematic state for network transmission
-	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
-
-	// Debug string representation of the state
-	FString ToString() const;
-};
-
-template<>
-struct TStructOpsTypeTraits<FKinematicState> : public TStructOpsTypeTraitsBase2<FKinematicState>
-{
-	enum
-	{
-		WithNetSerializer = true // Enable network serialization
-	};
+	double NetTime = 0.0;
+	FKinematicState State;
 };
 
 UCLASS()
@@ -52,6 +33,8 @@ public:
 	TObjectPtr<UCapsuleComponent> RootCapsuleComponent;
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
 	UStaticMeshComponent* BaseMesh;
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
+	TObjectPtr<class UDRTrailComponent> TrailComponent; // Motion trail and update markers, null in Shipping
 
 	// Camera components for controlling player view
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
@@ -65,47 +48,58 @@ public:
 
 	ADRPawn();
 	virtual void Tick(float DeltaTime) override; // Called every frame
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual float GetNetPriority(const FVector& ViewPos, const FVector& ViewDir, AActor* Viewer, AActor* ViewTarget, UActorChannel* InChannel, float Time, bool bLowBandwidth) override;
 	virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override; // Setup for input bindings
 
+	const FDRPawnTelemetry& GetTelemetry() const { return Telemetry; }
+	float GetAverageServerUpdateTime() const { return AverageServerUpdateTime; }
+
+	// Use stress test motion InIndex instead of the world settings motion, set on deferred spawns before BeginPlay
+	void SetStressIndex(int32 InIndex) { StressIndex = InIndex; }
+	bool IsStressPawn() const { return StressIndex != INDEX_NONE; }
+	SIZE_T GetAllocatedSize() const; // Heap owned by non-reflected members, see DRStressTest GetBytesPerStressEntity
+
 protected:
 
-	// Circle movement properties
-	float Radius = 0.0f; // Radius of circular motion
-	FRotator AngularSpeed = FRotator::ZeroRotator; // Angular speed in degrees per second
-	FVector CenterCircleMovement; // Center of the circular path
-	FVector CurrentDirection = FVector::ForwardVector; // Current direction vector for movement
-
-	// Square movement properties
-	float SideLength = 0.0f; // Length of each side of the square path
-	float Speed = 0.0f; // Linear speed of the pawn
-	FVector CurrentVelocity; // Current velocity vector
-	float PassedDistance = 0.0f; // Distance passed along the current side
-	FRotator TurnRight = FRotator(0,90.0f,0); // Rotation for turning at corners
-	FVector StartPositionSquareMovement; // Starting position for square movement
-	int32 CurrentSide = 0; // Current side of the square being traversed
+	FDRMover Mover; // Scripted motion simulated on the server, also holds the motion parameters
 	float DrawDebugLifetime = 0.0f; // Lifetime for debug visuals
 
 	// Dead reckoning properties
 	UPROPERTY(ReplicatedUsing = OnRep_KinematicState)
-	FKinematicState Server_KinematicState; // Server's authoritative state
+	FKinematicState Server_KinematicState; // Server's authoritative state, only the initial one when streaming
+	FKinematicState Server_StreamedState; // Server's authoritative state under EDRKinematicTransport::UnreliableStream, never replicated as a property
 	UPROPERTY()
 	FKinematicState Client_KinematicState; // Client's predicted state
 
-	// Replication settings
-	float ReplicationTime;
-	float ReplicationDistCircle = 50.0f; // Distance threshold for replicating in circular motion
-	float ReplicationDistSquare = 50.0f; // Distance threshold for replicating in square motion
+	// Parametric motion replication, replaces the kinematic state stream for scripted motion
+	UPROPERTY(ReplicatedUsing = OnRep_MotionDescriptor)
+	FDRMotionDescriptor MotionDescriptor;
+	DRCore::FMotionDescriptor ParametricMotion; // Evaluated form of MotionDescriptor
+	bool bParametricMotion = false; // Position comes from ParametricMotion instead of dead reckoning
+
+	UPROPERTY(Replicated)
+	uint32 CaptureId = 0; // Same on server and clients, identifies the pawn in capture files
+	UPROPERTY(Replicated)
+	int32 StressIndex = INDEX_NONE; // Clients derive the same randomized motion from it, see FDRMover::InitializeStress
 
 	// Function overrides and helpers
 	virtual void BeginPlay() override;
 	ADRController* GetDRController() const; // Get the custom controller
 	ADRWorldSettings* GetDRWorldSettings() const; // Get world-specific settings
+	class UDRDeadReckoningSubsystem* GetDeadReckoningSubsystem() const; // Batched client extrapolation, null if not used
 	FVector GetPlayerStartPosition() const; // Retrieve the initial spawn position
+	double GetServerWorldTime() const; // Server world time, estimated on clients
 
 	// Movement implementations
-	void MoveСircleServer(float In_DeltaTime); // Server-side logic for circular motion
-	void MoveSquareServer(float In_DeltaTime); // Server-side logic for square motion
+	void SimulateServerMotion(float In_DeltaTime); // Server-side motion step, safe to run off the game thread
+	void ApplyServerMotion(); // Apply the simulated location to the actor on the game thread
+	void MarkServerStateDirty(); // Push Server_KinematicState to the net driver and remember it for GetNetPriority, or multicast Server_StreamedState
+	FKinematicState& GetServerState() { return bStreamKinematicState ? Server_StreamedState : Server_KinematicState; } // The state Mover updates on the server
+	float GetClientErrorEstimate(double InLastUpdateTime) const; // Distance of the current location from the prediction of a client last updated at InLastUpdateTime
 	void DeadReckoningMove(float In_DeltaTime); // Client-side dead reckoning logic
+	void MoveParametric(); // Client-side closed-form evaluation of the replicated motion
+	void InterpolateMove(); // Client-side snapshot interpolation at a delayed render time
 
 	// Debug drawing utilities
 	void CustomDrawDebugLine(const FVector& From, const FVector& To, FColor Color, float Thickness, float InLifeTime) const;
@@ -113,15 +107,51 @@ protected:
 
 	UFUNCTION()
 	void OnRep_KinematicState(); // Callback for when Server_KinematicState replicates
+	UFUNCTION()
+	void OnRep_MotionDescriptor(); // Callback for when MotionDescriptor replicates
+	UFUNCTION(NetMulticast, Unreliable)
+	void MulticastKinematicState(uint16 InSequence, const FKinematicState& InState); // Server_StreamedState under EDRKinematicTransport::UnreliableStream
 
 private:
+	friend class UDRDeadReckoningSubsystem;
+	friend class UDRServerMotionSubsystem;
+
+	int32 DeadReckoningHandle = INDEX_NONE; // Slot in UDRDeadReckoningSubsystem, INDEX_NONE when ticking on its own
+	int32 ServerMotionHandle = INDEX_NONE; // Slot in UDRServerMotionSubsystem, INDEX_NONE when ticking on its own
+	bool bServerStateChanged = false; // Set off the game thread, pushed to the net driver in ApplyServerMotion
+	DRCore::FFixedStepAccumulator ServerStepper; // Fixed steps of Mover, the actor is placed between the last two
+	bool bErrorPriorityScheduling = false; // Server: ADRWorldSettings::bErrorPriorityScheduling on the legacy replication path with property replication
+	TFixedRingBuffer<FDRSentState> SentStates; // Recent replicated states, the one a connection last received is looked up by its channel's update time
+	bool bStreamKinematicState = false; // Server: states after the initial one are sent with MulticastKinematicState
+	bool bReceivedKinematicSequence = false; // Client: KinematicSequence holds a received sequence
+	uint16 KinematicSequence = 0; // Last sent on the server, newest received on clients
+	DRCore::FFixedStepAccumulator ClientStepper; // Fixed steps of the per-actor extrapolation
+	FVector PreviousClientPosition = FVector::ZeroVector; // Client prediction before the last extrapolation step
+	DRCore::EExtrapolationTier ExtrapolationTier = DRCore::EExtrapolationTier::Full; // Significance LOD of the per-actor extrapolation
+	int32 PendingClientSteps = 0; // Fixed steps not yet advanced by a reduced tier
+	float PendingClientTime = 0.0f;
+	FDRPawnTelemetry Telemetry; // Client prediction error at receive time, see DR.Telemetry.Dump
+	UPROPERTY(Transient)
+	TObjectPtr<class UDRCaptureSubsystem> CaptureSubsystem; // Records the kinematic stream while DR.Capture.Start is active
+	double LastTruthCaptureTime = -1.0e9; // Server time of the last ground-truth capture record
 
 	// Time synchronization utilities
-	FDateTimeStampCollector TimeStampCollector;
+	FTimeStampCollector<double> TimeStampCollector; // Server sample times of received states
+	DRCore::EIntervalEstimate BlendTimeEstimate = DRCore::EIntervalEstimate::Mean; // Statistic of TimeStampCollector used for BlendTime
+	FClockOffsetEstimator ServerClockOffset; // Server simulation time to local FPlatformTime offset
+	static constexpr float MaxSampleAge = 0.5f; // Received states are extrapolated by at most this much
+
+	// Snapshot interpolation
+	EDRClientSmoothingMode SmoothingMode = EDRClientSmoothingMode::Extrapolation;
+	DRCore::FSnapshotInterpolator SnapshotInterpolator; // Received states in server time, reallocated once in BeginPlay
+	FTimeStampCollector<double> ArrivalCollector; // Local arrival times of received states on the clock of ServerClockOffset, source of the jitter
+	float InterpolationDelay = 0.0f; // Render time lags the estimated server time by this much
+	float MaxInterpolationExtrapolation = 0.0f; // From the world settings, resolved in BeginPlay
 	float Server_T_SinceLastFrame;
 	float DeadReckon_T;
 	float DeadReckon_T_Hat;
-	const float MaxDeadReckon_T_Hat = 1.2f;
+	static constexpr float MaxDeadReckon_T_Hat = 1.2f;
 	float ServerUpdateTime;
 	float AverageServerUpdateTime;
+	float BlendTime; // Update interval the blend factor is normalized by, see ADRWorldSettings::BlendTimeEstimate
 };
@@ -0,0 +1,237 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "DRServerMotionSubsystem.h"
+
+#include "Async/ParallelFor.h"
+#include "DeadReckoningTest.h"
+#include "DRPawn.h"
+#include "DRWorldSettings.h"
+
+DECLARE_CYCLE_STAT(TEXT("Server Motion Simulate"), STAT_DRServerMotionSimulate, STATGROUP_DeadReckoning);
+DECLARE_CYCLE_STAT(TEXT("Server Motion Apply"), STAT_DRServerMotionApply, STATGROUP_DeadReckoning);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Server Movers"), STAT_DRServerMovers, STATGROUP_DeadReckoning);
+DECLARE_CYCLE_STAT(TEXT("Server Net Tick"), STAT_DRServerNetTick, STATGROUP_DeadReckoning);
+
+static FAutoConsoleCommandWithWorldAndArgs CmdBenchmarkServerMotion(
+	TEXT("DR.BenchmarkServerMotion"),
+	TEXT("Time serial and parallel server mover steps for an increasing number of worker chunks. Usage: DR.BenchmarkServerMotion [NumMovers=10000] [NumFrames=300]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&UDRServerMotionSubsystem::RunBenchmark));
+
+
+bool UDRServerMotionSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UDRServerMotionSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UDRServerMotionSubsystem, STATGROUP_Tickables);
+}
+
+void UDRServerMotionSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	if(const ADRWorldSettings* WorldSettings = Cast<ADRWorldSettings>(InWorld.GetWorldSettings()))
+	{
+		BatchSize = FMath::Max(1, WorldSettings->ServerMotionBatchSize);
+	}
+
+	// Compare with net.IsPushModelEnabled 0/1 to see the cost of property comparison
+	if(InWorld.GetNetMode() != NM_Client)
+	{
+		PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddUObject(this, &UDRServerMotionSubsystem::OnWorldPostActorTick);
+		PostTickFlushHandle = InWorld.OnPostTickFlush().AddUObject(this, &UDRServerMotionSubsystem::OnPostTickFlush);
+	}
+}
+
+void UDRServerMotionSubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldPostActorTick.Remove(PostActorTickHandle);
+	if(UWorld* World = GetWorld())
+	{
+		World->OnPostTickFlush().Remove(PostTickFlushHandle);
+	}
+
+	Super::Deinitialize();
+}
+
+void UDRServerMotionSubsystem::OnWorldPostActorTick(UWorld* InWorld, ELevelTick InTickType, float InDeltaSeconds)
+{
+	if(InWorld == GetWorld())
+	{
+		NetTickStartCycles = FPlatformTime::Cycles();
+	}
+}
+
+void UDRServerMotionSubsystem::OnPostTickFlush(float InDeltaSeconds)
+{
+	if(NetTickStartCycles != 0)
+	{
+		SET_CYCLE_COUNTER(STAT_DRServerNetTick, FPlatformTime::Cycles() - NetTickStartCycles);
+		NetTickStartCycles = 0;
+	}
+}
+
+int32 UDRServerMotionSubsystem::RegisterPawn(ADRPawn* InPawn)
+{
+	if(InPawn == nullptr)
+		return INDEX_NONE;
+	return Pawns.Add(InPawn);
+}
+
+void UDRServerMotionSubsystem::UnregisterPawn(int32 InHandle)
+{
+	if(!Pawns.IsValidIndex(InHandle))
+		return;
+
+	Pawns.RemoveAtSwap(InHandle, 1, EAllowShrinking::No);
+
+	// The last pawn was moved into the freed slot
+	if(Pawns.IsValidIndex(InHandle) && Pawns[InHandle] != nullptr)
+	{
+		Pawns[InHandle]->ServerMotionHandle = InHandle;
+	}
+}
+
+void UDRServerMotionSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	const int32 NumMovers = Pawns.Num();
+	if(NumMovers == 0)
+		return;
+
+	SET_DWORD_STAT(STAT_DRServerMovers, NumMovers);
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_DRServerMotionSimulate);
+		ParallelFor(TEXT("DRServerMotion"), NumMovers, BatchSize, [this, DeltaTime](int32 Index)
+		{
+			Pawns[Index]->SimulateServerMotion(DeltaTime);
+		});
+	}
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_DRServerMotionApply);
+		for(ADRPawn* Pawn : Pawns)
+		{
+			Pawn->ApplyServerMotion();
+		}
+	}
+}
+
+void UDRServerMotionSubsystem::StepMoversChunked(TArrayView<FDRMover> InOut_Movers, TArrayView<FKinematicState> InOut_States, float In_DeltaTime, int32 InNumChunks)
+{
+	const int32 NumMovers = InOut_Movers.Num();
+	const int32 NumChunks = FMath::Clamp(InNumChunks, 1, FMath::Max(1, NumMovers));
+	const int32 ChunkSize = FMath::DivideAndRoundUp(NumMovers, NumChunks);
+
+	ParallelFor(TEXT("DRServerMotionBenchmark"), NumChunks, 1, [&](int32 Chunk)
+	{
+		const int32 Begin = Chunk * ChunkSize;
+		const int32 End = FMath::Min(Begin + ChunkSize, NumMovers);
+		for(int32 i = Begin; i < End; ++i)
+		{
+			InOut_Movers[i].Step(In_DeltaTime, InOut_States[i]);
+		}
+	}, NumChunks == 1 ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+}
+
+namespace ServerMotionBenchmark
+{
+	bool IsBitwiseEqual(const FVector& A, const FVector& B)
+	{
+		return FMemory::Memcmp(&A, &B, sizeof(FVector)) == 0;
+	}
+
+	bool IsBitwiseEqual(const DRCore::FVec3& A, const DRCore::FVec3& B)
+	{
+		return FMemory::Memcmp(&A, &B, sizeof(DRCore::FVec3)) == 0;
+	}
+
+	bool IsBitwiseEqual(const FDRMover& A, const FDRMover& B)
+	{
+		return IsBitwiseEqual(A.Location, B.Location)
+			&& IsBitwiseEqual(A.PreviousLocation, B.PreviousLocation)
+			&& IsBitwiseEqual(A.Velocity, B.Velocity);
+	}
+
+	bool IsBitwiseEqual(const FKinematicState& A, const FKinematicState& B)
+	{
+		return IsBitwiseEqual(A.Position, B.Position) && IsBitwiseEqual(A.Velocity, B.Velocity);
+	}
+}
+
+void UDRServerMotionSubsystem::RunBenchmark(const TArray<FString>& Args, UWorld* World)
+{
+	using namespace ServerMotionBenchmark;
+
+	const ADRWorldSettings* WorldSettings = World ? Cast<ADRWorldSettings>(World->GetWorldSettings()) : nullptr;
+	if(WorldSettings == nullptr)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("DR.BenchmarkServerMotion needs a world using ADRWorldSettings"));
+		return;
+	}
+
+	const int32 NumMovers = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 10000;
+	const int32 NumFrames = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 300;
+	const float DeltaTime = 1.0f / 60.0f;
+
+	// Half circles, half squares, spread over a grid
+	FRandomStream Random(NumMovers);
+	DRCore::FMotionSettings MotionSettings = ToCoreMotionSettings(*WorldSettings);
+	TArray<FDRMover> InitialMovers;
+	TArray<FKinematicState> InitialStates;
+	InitialMovers.SetNum(NumMovers);
+	InitialStates.SetNum(NumMovers);
+	for(int32 i = 0; i < NumMovers; ++i)
+	{
+		const FVector Center(Random.FRandRange(-50000.0f, 50000.0f), Random.FRandRange(-50000.0f, 50000.0f), 0.0f);
+		FDRMover& Mover = InitialMovers[i];
+		MotionSettings.MotionType = (i % 2) == 0 ? DRCore::EMotionType::Circle : DRCore::EMotionType::Square;
+		Mover.Initialize(MotionSettings, ToCore(Center));
+		InitialStates[i] = FKinematicState(ToFVector(Mover.Location), FVector::Zero(), FVector::Zero());
+	}
+
+	// Serial reference
+	TArray<FDRMover> ReferenceMovers = InitialMovers;
+	TArray<FKinematicState> ReferenceStates = InitialStates;
+	const double SerialStart = FPlatformTime::Seconds();
+	for(int32 Frame = 0; Frame < NumFrames; ++Frame)
+	{
+		for(int32 i = 0; i < NumMovers; ++i)
+		{
+			ReferenceMovers[i].Step(DeltaTime, ReferenceStates[i]);
+		}
+	}
+	const double SerialMs = (FPlatformTime::Seconds() - SerialStart) * 1000.0 / NumFrames;
+	UE_LOG(LogTemp, Log, TEXT("DR.BenchmarkServerMotion: %d movers, %d frames, serial %.3f ms/tick"), NumMovers, NumFrames, SerialMs);
+
+	const int32 MaxChunks = FTaskGraphInterface::Get().GetNumWorkerThreads() + 1;
+	for(int32 NumChunks = 1; ; NumChunks = FMath::Min(NumChunks * 2, MaxChunks))
+	{
+		TArray<FDRMover> Movers = InitialMovers;
+		TArray<FKinematicState> States = InitialStates;
+
+		const double Start = FPlatformTime::Seconds();
+		for(int32 Frame = 0; Frame < NumFrames; ++Frame)
+		{
+			StepMoversChunked(Movers, States, DeltaTime, NumChunks);
+		}
+		const double ParallelMs = (FPlatformTime::Seconds() - Start) * 1000.0 / NumFrames;
+
+		bool bMatches = true;
+		for(int32 i = 0; i < NumMovers && bMatches; ++i)
+		{
+			bMatches = IsBitwiseEqual(Movers[i], ReferenceMovers[i]) && IsBitwiseEqual(States[i], ReferenceStates[i]);
+		}
+
+		UE_LOG(LogTemp, Log, TEXT("  %2d chunks: %.3f ms/tick, speedup %.2fx, bitwise match: %s"),
+			NumChunks, ParallelMs, SerialMs / FMath::Max(ParallelMs, UE_SMALL_NUMBER), bMatches ? TEXT("yes") : TEXT("NO"));
+
+		if(NumChunks == MaxChunks)
+			break;
+	}
+}
@@ -0,0 +1,53 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DRMover.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "DRServerMotionSubsystem.generated.h"
+
+class ADRPawn;
+
+/**
+ * Advances the scripted movers of every registered server pawn across worker threads.
+ * Motion and replication-threshold checks run in one parallel pass, actor locations
+ * are applied afterwards on the game thread.
+ */
+UCLASS()
+class DEADRECKONINGTEST_API UDRServerMotionSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	// Returns a handle used to unregister, INDEX_NONE if registration failed
+	int32 RegisterPawn(ADRPawn* InPawn);
+	void UnregisterPawn(int32 InHandle);
+
+	// Step movers split into InNumChunks parallel tasks. Used by the benchmark to emulate core counts.
+	static void StepMoversChunked(TArrayView<FDRMover> InOut_Movers, TArrayView<FKinematicState> InOut_States, float In_DeltaTime, int32 InNumChunks);
+
+	// DR.BenchmarkServerMotion [NumMovers] [NumFrames]
+	static void RunBenchmark(const TArray<FString>& Args, UWorld* World);
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<ADRPawn>> Pawns;
+
+	int32 BatchSize = 256; // Minimum number of movers per parallel task
+
+	// Server net tick timing, from the end of actor ticking to the end of the net driver flush
+	void OnWorldPostActorTick(UWorld* InWorld, ELevelTick InTickType, float InDeltaSeconds);
+	void OnPostTickFlush(float InDeltaSeconds);
+	FDelegateHandle PostActorTickHandle;
+	FDelegateHandle PostTickFlushHandle;
+	uint32 NetTickStartCycles = 0;
+};
@@ -0,0 +1,116 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "DRStressTest.h"
+
+#include "DRCrowdActor.h"
+#include "DRPawn.h"
+#include "EngineUtils.h"
+#include "Engine/World.h"
+#include "Serialization/ArchiveCountMem.h"
+
+
+// Object and reflected property memory of an actor and its components, like obj list
+static SIZE_T GetActorMemory(AActor* InActor)
+{
+	SIZE_T Bytes = InActor->GetClass()->GetStructureSize() + FArchiveCountMem(InActor).GetMax();
+	for(UActorComponent* Component : InActor->GetComponents())
+	{
+		Bytes += Component->GetClass()->GetStructureSize() + FArchiveCountMem(Component).GetMax();
+	}
+	return Bytes;
+}
+
+// Stress pawns count one actor each, crowd actors are shared by all their instances.
+// Render proxies and the dead reckoning subsystem slots are not included.
+static float GetBytesPerStressEntity(UWorld* InWorld)
+{
+	SIZE_T Bytes = 0;
+	int32 NumEntities = 0;
+	for(TActorIterator<ADRPawn> It(InWorld); It; ++It)
+	{
+		if(It->IsStressPawn())
+		{
+			Bytes += GetActorMemory(*It) + It->GetAllocatedSize();
+			++NumEntities;
+		}
+	}
+	for(TActorIterator<ADRCrowdActor> It(InWorld); It; ++It)
+	{
+		Bytes += GetActorMemory(*It) + It->GetAllocatedSize();
+		NumEntities += It->Num();
+	}
+	return NumEntities > 0 ? static_cast<float>(Bytes) / NumEntities : 0.0f;
+}
+
+
+void FDRStressRecorder::Start(UWorld* InWorld)
+{
+	Stop();
+
+	World = InWorld;
+	StartTotals = FDRTelemetry::Get().GetTotals();
+	TickStartCycles = 0;
+	SumFrameTime = 0.0;
+	SumWorldTickTime = 0.0;
+	MaxFrameTime = 0.0f;
+	NumFrames = 0;
+	NumWorldTicks = 0;
+
+	TickStartHandle = FWorldDelegates::OnWorldTickStart.AddRaw(this, &FDRStressRecorder::OnWorldTickStart);
+	PostTickFlushHandle = InWorld->OnPostTickFlush().AddRaw(this, &FDRStressRecorder::OnPostTickFlush);
+}
+
+FDRStressTestResult FDRStressRecorder::Stop()
+{
+	FDRStressTestResult Result;
+	if(!TickStartHandle.IsValid())
+		return Result;
+
+	FWorldDelegates::OnWorldTickStart.Remove(TickStartHandle);
+	TickStartHandle.Reset();
+	if(UWorld* RecordedWorld = World.Get())
+	{
+		RecordedWorld->OnPostTickFlush().Remove(PostTickFlushHandle);
+	}
+	PostTickFlushHandle.Reset();
+
+	const FDRTelemetryWindow Window = FDRTelemetry::Get().GetTotals().Since(StartTotals);
+	const bool bClient = World.IsValid() && World->GetNetMode() == NM_Client;
+	Result.BytesPerEntity = World.IsValid() ? GetBytesPerStressEntity(World.Get()) : 0.0f;
+	World.Reset();
+
+	Result.Duration = static_cast<float>(SumFrameTime);
+	Result.NumFrames = NumFrames;
+	Result.FrameMs = NumFrames > 0 ? static_cast<float>(1000.0 * SumFrameTime / NumFrames) : 0.0f;
+	Result.MaxFrameMs = 1000.0f * MaxFrameTime;
+	Result.WorldTickMs = NumWorldTicks > 0 ? static_cast<float>(1000.0 * SumWorldTickTime / NumWorldTicks) : 0.0f;
+	Result.BytesPerSecond = bClient ? Window.GetBytesReceivedPerSecond() : Window.GetBytesSentPerSecond();
+	Result.UpdatesPerSecond = bClient ? Window.GetUpdatesReceivedPerSecond() : Window.GetUpdatesSentPerSecond();
+	Result.MeanError = Window.GetMeanError();
+	Result.RmsError = Window.GetRmsError();
+	Result.StateAgeMs = Window.GetMeanStateAgeMs();
+	Result.DroppedPerSecond = Window.GetUpdatesDroppedPerSecond();
+	return Result;
+}
+
+void FDRStressRecorder::OnWorldTickStart(UWorld* InWorld, ELevelTick InTickType, float InDeltaSeconds)
+{
+	if(InWorld != World.Get())
+		return;
+
+	SumFrameTime += InDeltaSeconds;
+	MaxFrameTime = FMath::Max(MaxFrameTime, InDeltaSeconds);
+	++NumFrames;
+	TickStartCycles = FPlatformTime::Cycles();
+}
+
+void FDRStressRecorder::OnPostTickFlush(float InDeltaSeconds)
+{
+	if(TickStartCycles != 0)
+	{
+		SumWorldTickTime += FPlatformTime::ToSeconds(FPlatformTime::Cycles() - TickStartCycles);
+		++NumWorldTicks;
+		TickStartCycles = 0;
+	}
+}
@@ -0,0 +1,70 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DRTelemetry.h"
+#include "DRStressTest.generated.h"
+
+// Measurement of one world over a stress test run, sent from clients to the server
+USTRUCT()
+struct FDRStressTestResult
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	float Duration = 0.0f;
+	UPROPERTY()
+	int32 NumFrames = 0;
+	UPROPERTY()
+	float FrameMs = 0.0f; // Mean frame time
+	UPROPERTY()
+	float MaxFrameMs = 0.0f;
+	UPROPERTY()
+	float WorldTickMs = 0.0f; // Mean game thread time of the world tick including the net driver flush
+	UPROPERTY()
+	float BytesPerSecond = 0.0f; // Serialized kinematic states, sent on the server and received on clients
+	UPROPERTY()
+	float UpdatesPerSecond = 0.0f;
+	UPROPERTY()
+	float MeanError = 0.0f; // Client prediction error at receive time
+	UPROPERTY()
+	float RmsError = 0.0f;
+	UPROPERTY()
+	float StateAgeMs = 0.0f; // Mean age of the received states at the estimated server time, the latency the client compensates
+	UPROPERTY()
+	float DroppedPerSecond = 0.0f; // Received states dropped for arriving after a newer one
+	UPROPERTY()
+	float BytesPerEntity = 0.0f; // Memory of the stress movers at Stop divided by their number, actor and proxy paths alike
+};
+
+/**
+ * Frame timing and dead reckoning telemetry of one world between Start and Stop.
+ * Telemetry is process-wide, so in PIE the server and clients share the counters,
+ * but each side only reads its own direction.
+ */
+class DEADRECKONINGTEST_API FDRStressRecorder
+{
+public:
+	~FDRStressRecorder() { Stop(); }
+
+	void Start(UWorld* InWorld);
+	FDRStressTestResult Stop();
+	bool IsRecording() const { return World.IsValid(); }
+
+private:
+	void OnWorldTickStart(UWorld* InWorld, ELevelTick InTickType, float InDeltaSeconds);
+	void OnPostTickFlush(float InDeltaSeconds);
+
+	TWeakObjectPtr<UWorld> World;
+	FDelegateHandle TickStartHandle;
+	FDelegateHandle PostTickFlushHandle;
+	FDRTelemetryWindow StartTotals;
+
+	uint32 TickStartCycles = 0;
+	double SumFrameTime = 0.0;
+	double SumWorldTickTime = 0.0;
+	float MaxFrameTime = 0.0f;
+	int32 NumFrames = 0;
+	int32 NumWorldTicks = 0;
+};
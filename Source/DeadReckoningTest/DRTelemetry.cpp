@@ -0,0 +1,194 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "DRTelemetry.h"
+
+#include "DeadReckoningTest.h"
+#include "DRPawn.h"
+#include "EngineUtils.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Prediction Error RMS"), STAT_DRPredictionErrorRms, STATGROUP_DeadReckoning);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Prediction Error Max"), STAT_DRPredictionErrorMax, STATGROUP_DeadReckoning);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Updates Sent/s"), STAT_DRUpdatesSentPerSecond, STATGROUP_DeadReckoning);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Updates Received/s"), STAT_DRUpdatesReceivedPerSecond, STATGROUP_DeadReckoning);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Updates Dropped/s"), STAT_DRUpdatesDroppedPerSecond, STATGROUP_DeadReckoning);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("State Age ms"), STAT_DRStateAgeMs, STATGROUP_DeadReckoning);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Serialized Bytes Sent/s"), STAT_DRBytesSentPerSecond, STATGROUP_DeadReckoning);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Serialized Bytes Received/s"), STAT_DRBytesReceivedPerSecond, STATGROUP_DeadReckoning);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Blend Factor [0, 0.25) %"), STAT_DRBlendFactor0, STATGROUP_DeadReckoning);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Blend Factor [0.25, 0.5) %"), STAT_DRBlendFactor1, STATGROUP_DeadReckoning);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Blend Factor [0.5, 0.75) %"), STAT_DRBlendFactor2, STATGROUP_DeadReckoning);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Blend Factor [0.75, 1) %"), STAT_DRBlendFactor3, STATGROUP_DeadReckoning);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Blend Factor [1, max) %"), STAT_DRBlendFactor4, STATGROUP_DeadReckoning);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Blend Factor Clamped %"), STAT_DRBlendFactorClamped, STATGROUP_DeadReckoning);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Blend Clamp Hits/s"), STAT_DRBlendClampHitsPerSecond, STATGROUP_DeadReckoning);
+
+CSV_DEFINE_CATEGORY(DeadReckoning, true);
+
+static TAutoConsoleVariable<float> CVarDRTelemetryWindowTime(
+	TEXT("DR.Telemetry.WindowTime"),
+	1.0f,
+	TEXT("Seconds aggregated into one telemetry window."));
+
+static FAutoConsoleCommandWithWorldAndArgs CmdDumpTelemetry(
+	TEXT("DR.Telemetry.Dump"),
+	TEXT("Log the prediction error of every pawn in the world and the last telemetry window."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		for(TActorIterator<ADRPawn> It(World); It; ++It)
+		{
+			const FDRPawnTelemetry& Telemetry = It->GetTelemetry();
+			UE_LOG(LogTemp, Log, TEXT("%s: prediction error last %.2f, rms %.2f, max %.2f over %d updates"),
+				*It->GetName(), Telemetry.LastError, Telemetry.GetRmsError(), Telemetry.MaxError, Telemetry.NumSamples);
+		}
+
+		const FDRTelemetryWindow& Window = FDRTelemetry::Get().GetLastWindow();
+		UE_LOG(LogTemp, Log, TEXT("Sent %.1f updates/s, %.0f B/s. Received %.1f updates/s, %.0f B/s, prediction error rms %.2f, max %.2f, %.1f clamp hits/s"),
+			Window.GetUpdatesSentPerSecond(), Window.GetBytesSentPerSecond(), Window.GetUpdatesReceivedPerSecond(), Window.GetBytesReceivedPerSecond(),
+			Window.GetRmsError(), Window.MaxError, Window.GetClampHitsPerSecond());
+	}));
+
+
+float FDRTelemetryWindow::GetBlendFactorFraction(int32 InBucket) const
+{
+	uint32 Total = 0;
+	for(uint32 Count : BlendFactorHistogram)
+	{
+		Total += Count;
+	}
+	return Total > 0 ? static_cast<float>(BlendFactorHistogram[InBucket]) / Total : 0.0f;
+}
+
+void FDRTelemetryWindow::Accumulate(const FDRTelemetryWindow& InWindow)
+{
+	Duration += InWindow.Duration;
+	UpdatesSent += InWindow.UpdatesSent;
+	UpdatesReceived += InWindow.UpdatesReceived;
+	UpdatesDropped += InWindow.UpdatesDropped;
+	BitsSent += InWindow.BitsSent;
+	BitsReceived += InWindow.BitsReceived;
+	SumError += InWindow.SumError;
+	SumSquaredError += InWindow.SumSquaredError;
+	MaxError = FMath::Max(MaxError, InWindow.MaxError);
+	SumStateAge += InWindow.SumStateAge;
+	for(int32 i = 0; i < NumBlendBuckets; ++i)
+	{
+		BlendFactorHistogram[i] += InWindow.BlendFactorHistogram[i];
+	}
+}
+
+FDRTelemetryWindow FDRTelemetryWindow::Since(const FDRTelemetryWindow& InStart) const
+{
+	FDRTelemetryWindow Window = *this;
+	Window.Duration -= InStart.Duration;
+	Window.UpdatesSent -= InStart.UpdatesSent;
+	Window.UpdatesReceived -= InStart.UpdatesReceived;
+	Window.UpdatesDropped -= InStart.UpdatesDropped;
+	Window.BitsSent -= InStart.BitsSent;
+	Window.BitsReceived -= InStart.BitsReceived;
+	Window.SumError -= InStart.SumError;
+	Window.SumSquaredError -= InStart.SumSquaredError;
+	Window.SumStateAge -= InStart.SumStateAge;
+	for(int32 i = 0; i < NumBlendBuckets; ++i)
+	{
+		Window.BlendFactorHistogram[i] -= InStart.BlendFactorHistogram[i];
+	}
+	return Window;
+}
+
+FDRTelemetry& FDRTelemetry::Get()
+{
+	static FDRTelemetry Telemetry;
+	return Telemetry;
+}
+
+void FDRTelemetry::RecordUpdateReceived(float InPredictionError)
+{
+	++Current.UpdatesReceived;
+	Current.SumError += InPredictionError;
+	Current.SumSquaredError += static_cast<double>(InPredictionError) * InPredictionError;
+	Current.MaxError = FMath::Max(Current.MaxError, InPredictionError);
+}
+
+void FDRTelemetry::RecordBlendFactors(const uint32 (&InHistogram)[FDRTelemetryWindow::NumBlendBuckets])
+{
+	for(int32 i = 0; i < FDRTelemetryWindow::NumBlendBuckets; ++i)
+	{
+		Current.BlendFactorHistogram[i] += InHistogram[i];
+	}
+}
+
+FDRTelemetryWindow FDRTelemetry::GetTotals() const
+{
+	FDRTelemetryWindow Totals = Completed;
+	Totals.Accumulate(Current);
+	return Totals;
+}
+
+void FDRTelemetry::Tick(float InDeltaTime)
+{
+	// Every world ticks its subsystem, the counters are process-wide like the stats
+	if(LastTickFrame == GFrameCounter)
+		return;
+	LastTickFrame = GFrameCounter;
+
+	Current.Duration += InDeltaTime;
+	if(Current.Duration >= CVarDRTelemetryWindowTime.GetValueOnGameThread())
+	{
+		Completed.Accumulate(Current);
+		Last = Current;
+		Current = FDRTelemetryWindow();
+	}
+
+	Publish();
+}
+
+// Stats and CSV stats are set every frame from the last complete window
+void FDRTelemetry::Publish() const
+{
+	SET_FLOAT_STAT(STAT_DRPredictionErrorRms, Last.GetRmsError());
+	SET_FLOAT_STAT(STAT_DRPredictionErrorMax, Last.MaxError);
+	SET_FLOAT_STAT(STAT_DRUpdatesSentPerSecond, Last.GetUpdatesSentPerSecond());
+	SET_FLOAT_STAT(STAT_DRUpdatesReceivedPerSecond, Last.GetUpdatesReceivedPerSecond());
+	SET_FLOAT_STAT(STAT_DRUpdatesDroppedPerSecond, Last.GetUpdatesDroppedPerSecond());
+	SET_FLOAT_STAT(STAT_DRStateAgeMs, Last.GetMeanStateAgeMs());
+	SET_FLOAT_STAT(STAT_DRBytesSentPerSecond, Last.GetBytesSentPerSecond());
+	SET_FLOAT_STAT(STAT_DRBytesReceivedPerSecond, Last.GetBytesReceivedPerSecond());
+	SET_FLOAT_STAT(STAT_DRBlendFactor0, 100.0f * Last.GetBlendFactorFraction(0));
+	SET_FLOAT_STAT(STAT_DRBlendFactor1, 100.0f * Last.GetBlendFactorFraction(1));
+	SET_FLOAT_STAT(STAT_DRBlendFactor2, 100.0f * Last.GetBlendFactorFraction(2));
+	SET_FLOAT_STAT(STAT_DRBlendFactor3, 100.0f * Last.GetBlendFactorFraction(3));
+	SET_FLOAT_STAT(STAT_DRBlendFactor4, 100.0f * Last.GetBlendFactorFraction(4));
+	SET_FLOAT_STAT(STAT_DRBlendFactorClamped, 100.0f * Last.GetBlendFactorFraction(5));
+	SET_FLOAT_STAT(STAT_DRBlendClampHitsPerSecond, Last.GetClampHitsPerSecond());
+
+	CSV_CUSTOM_STAT(DeadReckoning, PredictionErrorRms, Last.GetRmsError(), ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(DeadReckoning, PredictionErrorMax, Last.MaxError, ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(DeadReckoning, UpdatesSentPerSecond, Last.GetUpdatesSentPerSecond(), ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(DeadReckoning, UpdatesReceivedPerSecond, Last.GetUpdatesReceivedPerSecond(), ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(DeadReckoning, UpdatesDroppedPerSecond, Last.GetUpdatesDroppedPerSecond(), ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(DeadReckoning, StateAgeMs, Last.GetMeanStateAgeMs(), ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(DeadReckoning, BytesSentPerSecond, Last.GetBytesSentPerSecond(), ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(DeadReckoning, BytesReceivedPerSecond, Last.GetBytesReceivedPerSecond(), ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(DeadReckoning, BlendFactorClampedPercent, 100.0f * Last.GetBlendFactorFraction(5), ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(DeadReckoning, BlendClampHitsPerSecond, Last.GetClampHitsPerSecond(), ECsvCustomStatOp::Set);
+}
+
+
+bool UDRTelemetrySubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UDRTelemetrySubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UDRTelemetrySubsystem, STATGROUP_Tickables);
+}
+
+void UDRTelemetrySubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	FDRTelemetry::Get().Tick(DeltaTime);
+}
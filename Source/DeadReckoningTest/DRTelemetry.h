@@ -0,0 +1,120 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "DRTelemetry.generated.h"
+
+// Prediction error of one pawn, measured when a server state is received
+struct FDRPawnTelemetry
+{
+	float LastError = 0.0f;
+	float MaxError = 0.0f;
+	double SumSquaredError = 0.0;
+	int32 NumSamples = 0;
+
+	void AddError(float InError)
+	{
+		LastError = InError;
+		MaxError = FMath::Max(MaxError, InError);
+		SumSquaredError += static_cast<double>(InError) * InError;
+		++NumSamples;
+	}
+
+	float GetRmsError() const { return NumSamples > 0 ? static_cast<float>(FMath::Sqrt(SumSquaredError / NumSamples)) : 0.0f; }
+};
+
+// Counters of one telemetry window
+struct FDRTelemetryWindow
+{
+	// Blend factor buckets of width 0.25 up to 1, then [1, max), the last one counts clamp hits
+	static constexpr int32 NumBlendBuckets = 6;
+
+	double Duration = 0.0;
+	int32 UpdatesSent = 0;
+	int32 UpdatesReceived = 0;
+	int32 UpdatesDropped = 0; // Arrived after a newer state of the same entity
+	int64 BitsSent = 0;
+	int64 BitsReceived = 0;
+	double SumError = 0.0;
+	double SumSquaredError = 0.0;
+	float MaxError = 0.0f;
+	double SumStateAge = 0.0; // Age of the received states at the estimated server time
+	uint32 BlendFactorHistogram[NumBlendBuckets] = {};
+
+	float GetUpdatesSentPerSecond() const { return Duration > 0.0 ? static_cast<float>(UpdatesSent / Duration) : 0.0f; }
+	float GetUpdatesReceivedPerSecond() const { return Duration > 0.0 ? static_cast<float>(UpdatesReceived / Duration) : 0.0f; }
+	float GetBytesSentPerSecond() const { return Duration > 0.0 ? static_cast<float>(BitsSent / 8.0 / Duration) : 0.0f; }
+	float GetBytesReceivedPerSecond() const { return Duration > 0.0 ? static_cast<float>(BitsReceived / 8.0 / Duration) : 0.0f; }
+	float GetMeanError() const { return UpdatesReceived > 0 ? static_cast<float>(SumError / UpdatesReceived) : 0.0f; }
+	float GetRmsError() const { return UpdatesReceived > 0 ? static_cast<float>(FMath::Sqrt(SumSquaredError / UpdatesReceived)) : 0.0f; }
+	float GetMeanStateAgeMs() const { return UpdatesReceived > 0 ? static_cast<float>(1000.0 * SumStateAge / UpdatesReceived) : 0.0f; }
+	float GetUpdatesDroppedPerSecond() const { return Duration > 0.0 ? static_cast<float>(UpdatesDropped / Duration) : 0.0f; }
+	float GetClampHitsPerSecond() const { return Duration > 0.0 ? static_cast<float>(BlendFactorHistogram[NumBlendBuckets - 1] / Duration) : 0.0f; }
+	float GetBlendFactorFraction(int32 InBucket) const;
+
+	void Accumulate(const FDRTelemetryWindow& InWindow);
+	// Counters added to these totals since InStart was taken from them, MaxError is the one of the totals
+	FDRTelemetryWindow Since(const FDRTelemetryWindow& InStart) const;
+};
+
+/**
+ * Process-wide dead reckoning telemetry. Server and client code record events on the
+ * game thread, the counters are rolled into a new window every TelemetryWindowTime and
+ * the last complete window is published to the DeadReckoning stat group and the CSV profiler.
+ */
+class DEADRECKONINGTEST_API FDRTelemetry
+{
+public:
+	static FDRTelemetry& Get();
+
+	// Server
+	void RecordUpdateSent() { ++Current.UpdatesSent; }
+	// Both ends, from NetSerialize
+	void RecordSerializedBits(bool bInSaving, int64 InNumBits) { (bInSaving ? Current.BitsSent : Current.BitsReceived) += InNumBits; }
+	// Client
+	void RecordUpdateReceived(float InPredictionError);
+	void RecordStateAge(double InAge) { Current.SumStateAge += InAge; }
+	void RecordUpdateDropped() { ++Current.UpdatesDropped; }
+	void RecordBlendFactor(float InBlendFactor, float InMaxBlendFactor) { ++Current.BlendFactorHistogram[GetBlendBucket(InBlendFactor, InMaxBlendFactor)]; }
+	void RecordBlendFactors(const uint32 (&InHistogram)[FDRTelemetryWindow::NumBlendBuckets]);
+
+	static int32 GetBlendBucket(float InBlendFactor, float InMaxBlendFactor)
+	{
+		if(InBlendFactor >= InMaxBlendFactor)
+			return FDRTelemetryWindow::NumBlendBuckets - 1;
+		return FMath::Clamp(static_cast<int32>(InBlendFactor * 4.0f), 0, FDRTelemetryWindow::NumBlendBuckets - 2);
+	}
+
+	const FDRTelemetryWindow& GetLastWindow() const { return Last; }
+	// Everything recorded since startup, for measurements that do not line up with the windows
+	FDRTelemetryWindow GetTotals() const;
+
+	// Once per frame, extra calls in the same frame are ignored
+	void Tick(float InDeltaTime);
+
+private:
+	void Publish() const;
+
+	FDRTelemetryWindow Current;
+	FDRTelemetryWindow Last;
+	FDRTelemetryWindow Completed; // Sum of all windows before Current
+	uint64 LastTickFrame = 0;
+};
+
+/**
+ * Drives FDRTelemetry from the world tick.
+ */
+UCLASS()
+class DEADRECKONINGTEST_API UDRTelemetrySubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+};
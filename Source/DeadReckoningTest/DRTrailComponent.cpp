@@ -0,0 +1,244 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "DRTrailComponent.h"
+
+#include "PrimitiveSceneProxy.h"
+#include "SceneManagement.h"
+
+static TAutoConsoleVariable<bool> CVarDRTrails(
+	TEXT("DR.Trails"),
+	true,
+	TEXT("Record and draw the dead reckoning motion trails."),
+	ECVF_RenderThreadSafe);
+
+namespace DRTrail
+{
+	// Bounds grow by at least this much so a moving trail does not update them every frame
+	constexpr double BoundsSlack = 1000.0;
+}
+
+#if DR_ENABLE_TRAILS
+
+// New elements handed from the game thread to the proxy
+struct FDRTrailUpdate
+{
+	TArray<FDRTrailSegment> Segments;
+	TArray<FDRTrailMarker> Markers;
+	bool bClear = false;
+};
+
+class FDRTrailSceneProxy final : public FPrimitiveSceneProxy
+{
+public:
+	FDRTrailSceneProxy(const UDRTrailComponent* InComponent)
+	: FPrimitiveSceneProxy(InComponent)
+	, Segments(InComponent->MaxSegments)
+	, Markers(InComponent->MaxMarkers)
+	, MarkerSides(InComponent->MarkerSides)
+	{
+		bWillEverBeLit = false;
+	}
+
+	virtual SIZE_T GetTypeHash() const override
+	{
+		static size_t UniquePointer;
+		return reinterpret_cast<size_t>(&UniquePointer);
+	}
+
+	virtual uint32 GetMemoryFootprint() const override
+	{
+		return sizeof(*this) + GetAllocatedSize() + Segments.Capacity() * sizeof(FDRTrailSegment) + Markers.Capacity() * sizeof(FDRTrailMarker);
+	}
+
+	virtual FPrimitiveViewRelevance GetViewRelevance(const FSceneView* View) const override
+	{
+		FPrimitiveViewRelevance Result;
+		Result.bDrawRelevance = IsShown(View) && CVarDRTrails.GetValueOnRenderThread();
+		Result.bDynamicRelevance = true;
+		Result.bSeparateTranslucency = Result.bNormalTranslucency = Result.bDrawRelevance;
+		return Result;
+	}
+
+	virtual void GetDynamicMeshElements(const TArray<const FSceneView*>& Views, const FSceneViewFamily& ViewFamily, uint32 VisibilityMap, FMeshElementCollector& Collector) const override
+	{
+		const double Now = ViewFamily.Time.GetWorldTimeSeconds();
+		for(int32 ViewIndex = 0; ViewIndex < Views.Num(); ++ViewIndex)
+		{
+			if(!(VisibilityMap & (1 << ViewIndex)))
+				continue;
+
+			FPrimitiveDrawInterface* PDI = Collector.GetPDI(ViewIndex);
+			for(const FDRTrailSegment& Segment : Segments)
+			{
+				if(Segment.ExpireTime >= Now)
+					PDI->DrawLine(Segment.Start, Segment.End, Segment.Color, SDPG_World, Segment.Thickness);
+			}
+			for(const FDRTrailMarker& Marker : Markers)
+			{
+				if(Marker.ExpireTime >= Now)
+					DrawWireSphere(PDI, Marker.Position, Marker.Color, Marker.Radius, MarkerSides, SDPG_World, Marker.Thickness);
+			}
+		}
+	}
+
+	void Update_RenderThread(const FDRTrailUpdate& InUpdate)
+	{
+		if(InUpdate.bClear)
+		{
+			Segments.Clear();
+			Markers.Clear();
+		}
+		for(const FDRTrailSegment& Segment : InUpdate.Segments)
+		{
+			if(Segments.IsFull())
+				Segments.PopFront();
+			Segments.Add(Segment);
+		}
+		for(const FDRTrailMarker& Marker : InUpdate.Markers)
+		{
+			if(Markers.IsFull())
+				Markers.PopFront();
+			Markers.Add(Marker);
+		}
+	}
+
+private:
+	TFixedRingBuffer<FDRTrailSegment> Segments;
+	TFixedRingBuffer<FDRTrailMarker> Markers;
+	int32 MarkerSides;
+};
+
+#endif // DR_ENABLE_TRAILS
+
+
+UDRTrailComponent::UDRTrailComponent()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+	SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	SetGenerateOverlapEvents(false);
+	CastShadow = false;
+	bSelectable = false;
+
+	// Elements are in world space, the component stays at the origin
+	SetUsingAbsoluteLocation(true);
+	SetUsingAbsoluteRotation(true);
+	SetUsingAbsoluteScale(true);
+}
+
+bool UDRTrailComponent::IsEnabled()
+{
+#if DR_ENABLE_TRAILS
+	return CVarDRTrails.GetValueOnGameThread();
+#else
+	return false;
+#endif
+}
+
+void UDRTrailComponent::OnRegister()
+{
+	SetWorldTransform(FTransform::Identity);
+	PendingSegments = TFixedRingBuffer<FDRTrailSegment>(MaxSegments);
+	PendingMarkers = TFixedRingBuffer<FDRTrailMarker>(MaxMarkers);
+	TrailBounds.Init();
+
+	Super::OnRegister();
+}
+
+void UDRTrailComponent::AddSegment(const FVector& InStart, const FVector& InEnd, FColor InColor, float InThickness, float InLifeTime)
+{
+#if DR_ENABLE_TRAILS
+	if(!IsEnabled())
+		return;
+
+	if(PendingSegments.IsFull())
+		PendingSegments.PopFront();
+	PendingSegments.Add(FDRTrailSegment{ InStart, InEnd, InColor, InThickness, GetWorld()->GetTimeSeconds() + InLifeTime });
+
+	GrowBounds(InStart);
+	GrowBounds(InEnd);
+	MarkRenderDynamicDataDirty();
+#endif
+}
+
+void UDRTrailComponent::AddMarker(const FVector& InPosition, float InRadius, FColor InColor, float InThickness, float InLifeTime)
+{
+#if DR_ENABLE_TRAILS
+	if(!IsEnabled())
+		return;
+
+	if(PendingMarkers.IsFull())
+		PendingMarkers.PopFront();
+	PendingMarkers.Add(FDRTrailMarker{ InPosition, InColor, InRadius, InThickness, GetWorld()->GetTimeSeconds() + InLifeTime });
+
+	GrowBounds(InPosition + FVector(InRadius));
+	GrowBounds(InPosition - FVector(InRadius));
+	MarkRenderDynamicDataDirty();
+#endif
+}
+
+void UDRTrailComponent::ClearTrail()
+{
+	PendingSegments.Clear();
+	PendingMarkers.Clear();
+	bPendingClear = true;
+	MarkRenderDynamicDataDirty();
+}
+
+void UDRTrailComponent::GrowBounds(const FVector& InPosition)
+{
+	if(TrailBounds.IsValid && TrailBounds.IsInsideOrOn(InPosition))
+		return;
+
+	TrailBounds += FBox(InPosition - FVector(DRTrail::BoundsSlack), InPosition + FVector(DRTrail::BoundsSlack));
+	UpdateBounds();
+	MarkRenderTransformDirty();
+}
+
+FBoxSphereBounds UDRTrailComponent::CalcBounds(const FTransform& LocalToWorld) const
+{
+	if(!TrailBounds.IsValid)
+		return FBoxSphereBounds(LocalToWorld.GetLocation(), FVector::ZeroVector, 0.0);
+	return FBoxSphereBounds(TrailBounds);
+}
+
+FPrimitiveSceneProxy* UDRTrailComponent::CreateSceneProxy()
+{
+#if DR_ENABLE_TRAILS
+	return new FDRTrailSceneProxy(this);
+#else
+	return nullptr;
+#endif
+}
+
+void UDRTrailComponent::SendRenderDynamicData_Concurrent()
+{
+	Super::SendRenderDynamicData_Concurrent();
+
+#if DR_ENABLE_TRAILS
+	if(SceneProxy == nullptr)
+		return;
+
+	FDRTrailUpdate Update;
+	Update.bClear = bPendingClear;
+	Update.Segments.Reserve(PendingSegments.Num());
+	for(const FDRTrailSegment& Segment : PendingSegments)
+	{
+		Update.Segments.Add(Segment);
+	}
+	Update.Markers.Reserve(PendingMarkers.Num());
+	for(const FDRTrailMarker& Marker : PendingMarkers)
+	{
+		Update.Markers.Add(Marker);
+	}
+	PendingSegments.Clear();
+	PendingMarkers.Clear();
+	bPendingClear = false;
+
+	FDRTrailSceneProxy* Proxy = static_cast<FDRTrailSceneProxy*>(SceneProxy);
+	ENQUEUE_RENDER_COMMAND(DRTrailUpdate)([Proxy, Update = MoveTemp(Update)](FRHICommandListImmediate& RHICmdList)
+	{
+		Proxy->Update_RenderThread(Update);
+	});
+#endif
+}
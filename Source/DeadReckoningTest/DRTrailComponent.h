@@ -0,0 +1,77 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/PrimitiveComponent.h"
+#include "Utilities/RingBuffer.h"
+#include "DRTrailComponent.generated.h"
+
+// Trails are a debugging aid, the component does nothing in Shipping builds
+#define DR_ENABLE_TRAILS (!UE_BUILD_SHIPPING)
+
+// Line segment of a motion trail, in world space
+struct FDRTrailSegment
+{
+	FVector Start;
+	FVector End;
+	FColor Color;
+	float Thickness;
+	double ExpireTime; // World time after which the segment is not drawn
+};
+
+// Wire sphere marking a received update, in world space
+struct FDRTrailMarker
+{
+	FVector Position;
+	FColor Color;
+	float Radius;
+	float Thickness;
+	double ExpireTime;
+};
+
+/**
+ * Fixed-size trail of line segments and update markers, drawn by its own scene proxy
+ * in one batched dynamic draw. Replaces persistent DrawDebugLine/DrawDebugSphere calls,
+ * which accumulate in the world's line batcher until their lifetime runs out.
+ * Only new elements are sent to the render thread. Disabled at runtime with DR.Trails 0.
+ */
+UCLASS(ClassGroup = (DeadReckoning), meta = (BlueprintSpawnableComponent))
+class DEADRECKONINGTEST_API UDRTrailComponent : public UPrimitiveComponent
+{
+	GENERATED_BODY()
+
+public:
+	UDRTrailComponent();
+
+	UPROPERTY(EditAnywhere, Category = "Trail", meta = (ClampMin = "1"))
+	int32 MaxSegments = 1024; // Oldest segments are overwritten beyond this
+	UPROPERTY(EditAnywhere, Category = "Trail", meta = (ClampMin = "1"))
+	int32 MaxMarkers = 256; // Oldest markers are overwritten beyond this
+	UPROPERTY(EditAnywhere, Category = "Trail", meta = (ClampMin = "4"))
+	int32 MarkerSides = 12; // Segments of each marker circle
+
+	void AddSegment(const FVector& InStart, const FVector& InEnd, FColor InColor, float InThickness, float InLifeTime);
+	void AddMarker(const FVector& InPosition, float InRadius, FColor InColor, float InThickness, float InLifeTime);
+	void ClearTrail();
+
+	static bool IsEnabled(); // DR.Trails
+
+	// UPrimitiveComponent
+	virtual FPrimitiveSceneProxy* CreateSceneProxy() override;
+	virtual FBoxSphereBounds CalcBounds(const FTransform& LocalToWorld) const override;
+
+protected:
+	virtual void OnRegister() override;
+	virtual void SendRenderDynamicData_Concurrent() override;
+
+private:
+	void GrowBounds(const FVector& InPosition);
+
+	// Added since the last render update, the proxy keeps the full trail
+	TFixedRingBuffer<FDRTrailSegment> PendingSegments;
+	TFixedRingBuffer<FDRTrailMarker> PendingMarkers;
+	bool bPendingClear = false;
+
+	FBox TrailBounds; // World space, grown with slack so bounds updates stay rare
+};
@@ -2,3 +2,79 @@
 
 
 #include "DRWorldSettings.h"
+#include "DRPawn.h"
+#include "Engine/World.h"
+
+
+const FKinematicStateQuantization& FKinematicStateQuantization::Get(const UWorld* InWorld)
+{
+	static const FKinematicStateQuantization Defaults;
+	const ADRWorldSettings* WorldSettings = InWorld ? Cast<ADRWorldSettings>(InWorld->GetWorldSettings(false, false)) : nullptr;
+	return WorldSettings ? WorldSettings->KinematicStateQuantization : Defaults;
+}
+
+uint32 FKinematicStateQuantization::GetCellSteps() const
+{
+	return static_cast<uint32>(FMath::Clamp<int64>(FMath::CeilToInt64(GridCellSize / PositionPrecision), 1, MAX_int32));
+}
+
+void FKinematicStateQuantization::QuantizePosition(double InValue, int32& Out_Cell, uint32& Out_Offset) const
+{
+	const double CellIndex = FMath::Clamp<double>(FMath::FloorToDouble(InValue / GridCellSize), MIN_int32, MAX_int32);
+	const int64 Steps = FMath::RoundToInt64((InValue - CellIndex * GridCellSize) / PositionPrecision);
+	Out_Cell = static_cast<int32>(CellIndex);
+	Out_Offset = static_cast<uint32>(FMath::Clamp<int64>(Steps, 0, GetCellSteps()));
+}
+
+double FKinematicStateQuantization::DequantizePosition(int32 InCell, uint32 InOffset) const
+{
+	return InCell * static_cast<double>(GridCellSize) + InOffset * static_cast<double>(PositionPrecision);
+}
+
+uint32 FKinematicStateQuantization::GetMaxSteps(float InMaxValue, float InPrecision)
+{
+	return static_cast<uint32>(FMath::Clamp<int64>(FMath::CeilToInt64(InMaxValue / InPrecision), 1, MAX_int32 / 2));
+}
+
+int32 FKinematicStateQuantization::QuantizeBounded(double InValue, float InMaxValue, float InPrecision)
+{
+	const int64 MaxSteps = GetMaxSteps(InMaxValue, InPrecision);
+	const double Clamped = FMath::Clamp<double>(InValue, -InMaxValue, InMaxValue);
+	return static_cast<int32>(FMath::Clamp<int64>(FMath::RoundToInt64(Clamped / InPrecision), -MaxSteps, MaxSteps));
+}
+
+EDRClientSmoothingMode ADRWorldSettings::GetClientSmoothingMode(const UClass* InPawnClass) const
+{
+	for(const UClass* Class = InPawnClass; Class != nullptr; Class = Class->GetSuperClass())
+	{
+		if(const EDRClientSmoothingMode* Mode = ClientSmoothingModeOverrides.Find(const_cast<UClass*>(Class)))
+			return *Mode;
+	}
+	return ClientSmoothingMode;
+}
+
+DRCore::EIntervalEstimate ADRWorldSettings::GetBlendTimeEstimate() const
+{
+	switch(BlendTimeEstimate)
+	{
+	case EDRBlendTimeEstimate::Ewma: return DRCore::EIntervalEstimate::Ewma;
+	case EDRBlendTimeEstimate::Percentile: return DRCore::EIntervalEstimate::Quantile;
+	default: return DRCore::EIntervalEstimate::Mean;
+	}
+}
+
+DRCore::FFixedStepAccumulator ADRWorldSettings::MakeFixedStepAccumulator() const
+{
+	return DRCore::FFixedStepAccumulator(bFixedTimestep ? FixedStepTime : 0.0, MaxSubsteps);
+}
+
+DRCore::FExtrapolationTierSettings ADRWorldSettings::MakeExtrapolationTierSettings() const
+{
+	DRCore::FExtrapolationTierSettings TierSettings;
+	TierSettings.ReducedRateDistance = ReducedRateDistance;
+	TierSettings.LinearDistance = LinearModelDistance;
+	TierSettings.StepInterval = ReducedRateStepInterval;
+	TierSettings.bReduceHidden = bReduceHiddenMovers;
+	TierSettings.Hysteresis = SignificanceHysteresis;
+	return TierSettings;
+}
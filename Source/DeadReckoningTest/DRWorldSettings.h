@@ -4,8 +4,133 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/WorldSettings.h"
+#include "DeadReckoningCore/DRCoreCollectors.h"
+#include "DeadReckoningCore/DRCoreExtrapolator.h"
+#include "DeadReckoningCore/DRCoreFixedStep.h"
 #include "DRWorldSettings.generated.h"
 
+// How the server decides that a new kinematic state has to be replicated
+UENUM(BlueprintType)
+enum class EDRReplicationPolicy : uint8
+{
+	Distance, // Motion-specific distance since the last replicated state
+	PredictionError, // Error of a server-side copy of the client extrapolator
+};
+
+// How server kinematic states reach the clients
+UENUM(BlueprintType)
+enum class EDRKinematicTransport : uint8
+{
+	PropertyReplication, // Server_KinematicState is a push-model replicated property with a RepNotify
+	UnreliableStream, // Every state is an unreliable multicast with a sequence number, older arrivals are dropped
+};
+
+// How clients turn the received kinematic states into a rendered position
+UENUM(BlueprintType)
+enum class EDRClientSmoothingMode : uint8
+{
+	Extrapolation, // Projective velocity blending ahead of the last received state
+	SnapshotInterpolation, // Hermite interpolation between buffered states, rendered with a delay
+};
+
+// Which statistic of the server update intervals normalizes the extrapolation blend
+UENUM(BlueprintType)
+enum class EDRBlendTimeEstimate : uint8
+{
+	Mean, // Mean interval over the last second
+	Ewma, // Exponentially weighted mean, follows rate changes within a few updates
+	Percentile, // Streaming percentile, blends converge only after most intervals have elapsed
+};
+
+// Precision settings for the quantized FKinematicState network encoding
+USTRUCT(BlueprintType)
+struct FKinematicStateQuantization
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	bool bEnabled = true; // Send quantized vectors instead of full precision doubles
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "1.0"))
+	float GridCellSize = 100000.0f; // Size of the grid cell the position is encoded relative to
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0.001"))
+	float PositionPrecision = 0.1f; // Quantization step of the position inside a grid cell
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0.0"))
+	float MaxVelocity = 10000.0f; // Velocity components are clamped to [-MaxVelocity, MaxVelocity]
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0.001"))
+	float VelocityPrecision = 0.1f; // Quantization step of the velocity
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0.0"))
+	float MaxAcceleration = 10000.0f; // Acceleration components are clamped to [-MaxAcceleration, MaxAcceleration]
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0.001"))
+	float AccelerationPrecision = 0.1f; // Quantization step of the acceleration
+
+	// Largest per-component round-trip error of a value inside the encodable range
+	float GetMaxPositionError() const { return PositionPrecision * 0.5f; }
+	float GetMaxVelocityError() const { return VelocityPrecision * 0.5f; }
+	float GetMaxAccelerationError() const { return AccelerationPrecision * 0.5f; }
+
+	// Grid encoding of one position component shared by NetSerialize and the Iris serializer:
+	// the cell index, clamped to int32, and the offset inside the cell in [0, GetCellSteps()]
+	uint32 GetCellSteps() const;
+	void QuantizePosition(double InValue, int32& Out_Cell, uint32& Out_Offset) const;
+	double DequantizePosition(int32 InCell, uint32 InOffset) const;
+
+	// Precision of InWorld's ADRWorldSettings, the defaults without one. Server and client load
+	// the same map, so both ends of a connection agree on the encoding
+	static const FKinematicStateQuantization& Get(const UWorld* InWorld);
+
+	// Fixed-point steps on each side of zero for a component bounded by InMaxValue
+	static uint32 GetMaxSteps(float InMaxValue, float InPrecision);
+	// InValue clamped to [-InMaxValue, InMaxValue] in steps of InPrecision
+	static int32 QuantizeBounded(double InValue, float InMaxValue, float InPrecision);
+};
+
+// Many pawns with randomized motion, spawned and measured by ADRGameMode
+USTRUCT(BlueprintType)
+struct FDRStressTestSettings
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	bool bEnabled = false;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0"))
+	int32 NumMovers = 1000;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0.0", ClampMax = "1.0"))
+	float CircleFraction = 0.5f; // Share of movers on circles, the others move on squares
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0.0"))
+	float SpreadExtent = 10000.0f; // Path centers are spread over a square of this size around the first PlayerStart
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 Seed = 1; // Motion of mover i only depends on the seed and i, so clients derive it from the replicated index
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "1.0"))
+	FVector2D RadiusRange = FVector2D(100.0f, 600.0f);
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "1.0"))
+	FVector2D AngularSpeedRange = FVector2D(30.0f, 180.0f); // Yaw degrees per second
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "1.0"))
+	FVector2D SideLengthRange = FVector2D(100.0f, 600.0f);
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "1.0"))
+	FVector2D SpeedRange = FVector2D(100.0f, 600.0f);
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	bool bRandomPhase = true; // Start each mover at a random point of its path
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	bool bUseCrowdProxies = false; // Movers are instances of one ADRCrowdActor instead of one ADRPawn each
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (EditCondition = "bUseCrowdProxies"))
+	bool bUseMassEntities = false; // The crowd simulates its movers and proxies as Mass entities, see ADRMassCrowdActor
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "1"))
+	int32 SpawnBatchSize = 100;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0.0"))
+	float SpawnBatchInterval = 0.1f;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0.0"))
+	float WarmupTime = 3.0f; // Settling time between the last batch and the measurement
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0.1"))
+	float MeasurementTime = 30.0f;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0.0"))
+	float ClientReportTimeout = 5.0f; // How long the server waits for client results before writing the report
+};
+
 /**
  * 
  */
@@ -18,6 +143,78 @@ public:
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Motion Replication")
 	float ReplicationTime = 0.5f;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Motion Replication")
+	EDRReplicationPolicy ReplicationPolicy = EDRReplicationPolicy::Distance;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Motion Replication", meta = (ClampMin = "0.0", EditCondition = "ReplicationPolicy == EDRReplicationPolicy::PredictionError"))
+	float ReplicationErrorTolerance = 20.0f; // Largest client prediction error in world units before a state is sent
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Motion Replication")
+	bool bReplicateMotionDescriptor = false; // Replicate the scripted motion once and evaluate it on clients instead of streaming states
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Motion Replication")
+	FKinematicStateQuantization KinematicStateQuantization;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Motion Replication")
+	EDRKinematicTransport KinematicTransport = EDRKinematicTransport::PropertyReplication; // Pawns only, crowd actors always use their fast array
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Replication Scheduling")
+	bool bErrorPriorityScheduling = false; // Pawns are sent to each connection in order of the error its client currently has for them
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Replication Scheduling", meta = (ClampMin = "0"))
+	int32 ConnectionBudgetBytesPerSecond = 0; // Net speed of every client connection, 0 keeps the engine's. Divided by the net tick rate it is the per-frame budget
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Replication Scheduling", meta = (ClampMin = "0.001", EditCondition = "bErrorPriorityScheduling"))
+	float PriorityErrorReference = 20.0f; // Client error in world units that weighs as much as one second without an update
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Replication Scheduling", meta = (ClampMin = "1.0", EditCondition = "bErrorPriorityScheduling"))
+	float PriorityFalloffDistance = 5000.0f; // Priority halves at this distance from the connection's view
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dead Reckoning")
+	bool bUseBatchedDeadReckoning = false; // Extrapolate client pawns in UDRDeadReckoningSubsystem instead of per-actor Tick
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dead Reckoning")
+	bool bCompensateOneWayLatency = false; // Received states are also advanced by the one-way delay, estimated from the connection's round trip
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dead Reckoning")
+	EDRClientSmoothingMode ClientSmoothingMode = EDRClientSmoothingMode::Extrapolation; // Used by pawn classes without an override
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dead Reckoning")
+	TMap<TSubclassOf<class ADRPawn>, EDRClientSmoothingMode> ClientSmoothingModeOverrides; // Per pawn class, subclasses inherit the mode
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dead Reckoning")
+	EDRBlendTimeEstimate BlendTimeEstimate = EDRBlendTimeEstimate::Mean;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dead Reckoning", meta = (ClampMin = "0.0", ClampMax = "1.0", EditCondition = "BlendTimeEstimate == EDRBlendTimeEstimate::Percentile"))
+	float BlendTimePercentile = 0.9f; // 0.9 blends over the interval that 90% of the updates arrive within
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dead Reckoning", meta = (ClampMin = "0.001", ClampMax = "1.0", EditCondition = "BlendTimeEstimate == EDRBlendTimeEstimate::Ewma"))
+	float BlendTimeEwmaSmoothing = 0.1f; // Weight of the newest interval
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dead Reckoning LOD")
+	bool bUseSignificanceLOD = false; // Remote pawns and proxies far from the local view or hidden extrapolate less often, the farthest without acceleration
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dead Reckoning LOD", meta = (ClampMin = "0.0", EditCondition = "bUseSignificanceLOD"))
+	float SignificanceUpdateInterval = 0.25f; // Seconds between tier updates of the batched entities, per-actor pawns update every tick
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dead Reckoning LOD", meta = (ClampMin = "0.0", EditCondition = "bUseSignificanceLOD"))
+	float ReducedRateDistance = 5000.0f; // Beyond it entities advance ReducedRateStepInterval fixed steps at once
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dead Reckoning LOD", meta = (ClampMin = "0.0", EditCondition = "bUseSignificanceLOD"))
+	float LinearModelDistance = 15000.0f; // Beyond it they also blend linearly, without the server acceleration
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dead Reckoning LOD", meta = (ClampMin = "1", ClampMax = "16", EditCondition = "bUseSignificanceLOD"))
+	int32 ReducedRateStepInterval = 4;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dead Reckoning LOD", meta = (EditCondition = "bUseSignificanceLOD"))
+	bool bReduceHiddenMovers = true; // Entities outside the view, or not rendered recently, are never extrapolated at full rate
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dead Reckoning LOD", meta = (ClampMin = "0.0", ClampMax = "0.9", EditCondition = "bUseSignificanceLOD"))
+	float SignificanceHysteresis = 0.1f; // Fraction of a distance an entity has to come back inside before it is promoted
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Snapshot Interpolation", meta = (ClampMin = "0.0"))
+	float InterpolationJitterMultiplier = 2.0f; // Arrival jitter deviations added to the average interval for the render delay
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Snapshot Interpolation", meta = (ClampMin = "0.0"))
+	float MinInterpolationDelay = 0.02f; // Render delay bounds in seconds
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Snapshot Interpolation", meta = (ClampMin = "0.0"))
+	float MaxInterpolationDelay = 0.5f;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Snapshot Interpolation", meta = (ClampMin = "0.0"))
+	float MaxInterpolationExtrapolation = 0.25f; // How far past the newest snapshot a starved buffer keeps moving
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Snapshot Interpolation", meta = (ClampMin = "2"))
+	int32 SnapshotBufferCapacity = 32; // Preallocated snapshots per pawn
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fixed Timestep")
+	bool bFixedTimestep = false; // Server movers and client extrapolation advance in fixed steps, rendered between the last two
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fixed Timestep", meta = (ClampMin = "0.001", EditCondition = "bFixedTimestep"))
+	float FixedStepTime = 1.0f / 60.0f;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fixed Timestep", meta = (ClampMin = "1", EditCondition = "bFixedTimestep"))
+	int32 MaxSubsteps = 8; // Frame time beyond this many steps is run by the following frames
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Server Motion")
+	bool bParallelServerMotion = false; // Advance server movers in UDRServerMotionSubsystem across worker threads
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Server Motion", meta = (ClampMin = "1"))
+	int32 ServerMotionBatchSize = 256; // Minimum number of movers per parallel task
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Motion Type")
 	bool IsCircleMovement = true;
@@ -31,4 +228,19 @@ public:
 	float SideLength = 300.0f;
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Square Motion")
 	float Speed = 200.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stress Test")
+	FDRStressTestSettings StressTest;
+
+	// Accumulator matching the fixed timestep settings, passes frame times through when disabled
+	DRCore::FFixedStepAccumulator MakeFixedStepAccumulator() const;
+
+	// Tier thresholds of the Dead Reckoning LOD settings
+	DRCore::FExtrapolationTierSettings MakeExtrapolationTierSettings() const;
+
+	// Core counterpart of BlendTimeEstimate
+	DRCore::EIntervalEstimate GetBlendTimeEstimate() const;
+
+	// Smoothing mode of InPawnClass, the nearest overridden base class wins
+	EDRClientSmoothingMode GetClientSmoothingMode(const UClass* InPawnClass) const;
 };
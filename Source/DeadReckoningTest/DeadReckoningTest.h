@@ -4,3 +4,4 @@
 
 #include "CoreMinimal.h"
 
+DECLARE_STATS_GROUP(TEXT("DeadReckoning"), STATGROUP_DeadReckoning, STATCAT_Advanced);
@@ -3,6 +3,8 @@
 
 #include "InfoWidget.h"
 
+#include "DRTelemetry.h"
+
 
 void UInfoWidget::UpdateAverageServerUpdateTimeText(float InAverageServerUpdateTime) const
 {
@@ -14,21 +16,21 @@ void UInfoWidget::UpdateAverageServerUpdateTimeText(float InAverageServerUpdateT
 	}
 }
 
-void UInfoWidget::UpdateMotionInfoText(bool IsCircle, float InCircleRadius, float InAngularSpeed, float InSquareSideLength, float Speed) const
+void UInfoWidget::UpdateMotionInfoText(const FString& InMotionInfo) const
 {
 	if (MotionInfoText)
 	{
-		FString MotionInfoString;
-		if(IsCircle)
-			MotionInfoString = FString::Printf(TEXT("Circle Motion\nRadius = %.1f, Speed %.1f degrees per second"),
-												 InCircleRadius, InAngularSpeed);
-		else
-		{
-			MotionInfoString = FString::Printf(TEXT("Square Motion\nSide Length = %.1f, Speed %.1f"),
-												 InSquareSideLength, Speed);
-		}
-		MotionInfoText->SetText(FText::FromString(MotionInfoString));
+		MotionInfoText->SetText(FText::FromString(InMotionInfo));
 	}
 }
 
-
+void UInfoWidget::UpdateTelemetryText(const FDRTelemetryWindow& InWindow) const
+{
+	if (TelemetryText)
+	{
+		FString TelemetryString = FString::Printf(TEXT("Prediction Error: rms %.1f, max %.1f\nUpdates: %.1f/s, %.0f B/s\nBlend Clamp Hits: %.1f/s"),
+												 InWindow.GetRmsError(), InWindow.MaxError, InWindow.GetUpdatesReceivedPerSecond(),
+												 InWindow.GetBytesReceivedPerSecond(), InWindow.GetClampHitsPerSecond());
+		TelemetryText->SetText(FText::FromString(TelemetryString));
+	}
+}
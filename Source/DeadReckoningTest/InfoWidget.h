@@ -17,7 +17,8 @@ class DEADRECKONINGTEST_API UInfoWidget : public UUserWidget
 
 public:
 	void UpdateAverageServerUpdateTimeText(float InAverageServerUpdateTime) const;
-	void UpdateMotionInfoText(bool IsCircle, float InCircleRadius, float InAngularSpeed, float InSquareSideLength, float Speed) const;
+	void UpdateMotionInfoText(const FString& InMotionInfo) const;
+	void UpdateTelemetryText(const struct FDRTelemetryWindow& InWindow) const;
 
 protected:
 	UPROPERTY(meta = (BindWidget))
@@ -25,5 +26,8 @@ protected:
 
 	UPROPERTY(meta = (BindWidget))
 	class UTextBlock* MotionInfoText;
+
+	UPROPERTY(meta = (BindWidgetOptional))
+	class UTextBlock* TelemetryText;
 	
 };
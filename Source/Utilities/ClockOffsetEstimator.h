@@ -0,0 +1,6 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "DeadReckoningCore/DRCoreCollectors.h"
+
+// Filtered server-to-local clock offset, implemented in the engine-independent core
+using FClockOffsetEstimator = DRCore::FClockOffsetEstimator;
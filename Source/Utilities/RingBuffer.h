@@ -0,0 +1,10 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "DeadReckoningCore/DRCoreCollectors.h"
+
+// The containers live in the engine-independent core, these names are kept for game code
+template<typename ElemType>
+using TFixedRingBuffer = DRCore::TFixedRingBuffer<ElemType>;
+
+template<typename ValueType>
+using TSlidingMinMax = DRCore::TSlidingMinMax<ValueType>;
@@ -1,7 +1,10 @@
 ﻿#pragma once
-#include <list>
-#include <algorithm>
+#include <utility>
 #include "CoreMinimal.h"
+#include "RingBuffer.h"
+
+// Default capacity of the collectors below
+constexpr int32 DefaultTimeCollectorCapacity = DRCore::DefaultCollectorCapacity;
 
 template<typename TimeType, typename DataType, typename ChangingType>
 class FTimeChangeCollector
@@ -18,55 +21,50 @@ public:
 
 	using TCalcChangeFunc = TFunction<ChangingType(const DataType&, const DataType&)>;
 
-	FTimeChangeCollector() = default;
-	FTimeChangeCollector(TimeType InMaxTime): MaxTime_(InMaxTime) {}
-
-	FTimeChangeCollector(const FTimeChangeCollector& Other)
-	: MaxTime_(Other.MaxTime_), Collection_(Other.Collection_), FullDuration_(Other.FullDuration_), SumChanges_(Other.SumChanges_) {}
-
-	FTimeChangeCollector(FTimeChangeCollector&& Other) noexcept
-		: MaxTime_(Other.MaxTime_), Collection_(std::move(Other.Collection_)), FullDuration_(Other.FullDuration_), SumChanges_(Other.SumChanges_)
-	{		
-	}
+	FTimeChangeCollector(): Collection_(DefaultTimeCollectorCapacity) {}
+	FTimeChangeCollector(TimeType InMaxTime, int32 InCapacity = DefaultTimeCollectorCapacity): MaxTime_(InMaxTime), Collection_(InCapacity) {}
 
 	void Add(TimeType InTimeStamp, DataType InValue, const TCalcChangeFunc& InCalcChangeFunc)
 	{
-		if(Collection_.empty())
+		if(Collection_.IsEmpty())
 		{
-			Collection_.push_back(SElem{ InTimeStamp, InValue, 0, ChangingType() });
+			Collection_.Add(SElem{ InTimeStamp, InValue, 0, ChangingType() });
 		}
 		else
 		{
-			TimeType Duration = InTimeStamp - Collection_.back().Stamp_;
+			TimeType Duration = InTimeStamp - Collection_.Last().Stamp_;
 			if(FMath::IsNearlyZero(Duration))
 			{
-				SElem& Elem = Collection_.back();
+				SElem& Elem = Collection_.Last();
 				Elem.Value_ = InValue;
-				if(Collection_.size() > 1)
+				if(Collection_.Num() > 1)
 				{
-					Elem.Changed_ = InCalcChangeFunc(InValue, (*(Collection_.rbegin()--)).Value_);
+					// Change is measured against the previous sample, not the one being replaced
+					const ChangingType Changed = InCalcChangeFunc(InValue, Collection_.Last(1).Value_);
+					SumChanges_ += Changed - Elem.Changed_;
+					Elem.Changed_ = Changed;
 				}
 			}
 			else
 			{
-				ChangingType Changed = InCalcChangeFunc(InValue, Collection_.back().Value_);
-			
-				Collection_.push_back(SElem{ InTimeStamp, InValue, Duration, Changed});
+				ChangingType Changed = InCalcChangeFunc(InValue, Collection_.Last().Value_);
+
+				if(Collection_.IsFull())
+					PopFront();
+				Collection_.Add(SElem{ InTimeStamp, InValue, Duration, Changed});
 
 				SumChanges_ += Changed;
 				FullDuration_ += Duration;
 
-				while(FullDuration_ > MaxTime_ && Collection_.size() > 1)
+				while(FullDuration_ > MaxTime_ && Collection_.Num() > 1)
 				{
-					Collection_.pop_front();
-					FullDuration_ -= Collection_.front().Duration_;
-					SumChanges_ -= Collection_.front().Changed_;
+					PopFront();
 				}
 			}
 		}
 	}
 
-	bool IsValid() const { return Collection_.size() >= 2; }
+	bool IsValid() const { return Collection_.Num() >= 2; }
 	
 	TimeType GetFullTime() const
 	{
@@ -91,20 +89,28 @@ public:
 
 	TimeType GetAverageDuration() const
 	{
-		return !IsValid() ? 0 : FullDuration_ / (Collection_.size() - 1);
+		return !IsValid() ? 0 : FullDuration_ / (Collection_.Num() - 1);
 	}
 
 	void Clear()
 	{
 		FullDuration_ = 0;
 		SumChanges_ = ChangingType();
-		Collection_.clear();
+		Collection_.Clear();
 	}
 
 private:
+	// Drop the oldest sample, the new first one no longer contributes its interval
+	void PopFront()
+	{
+		Collection_.PopFront();
+		FullDuration_ -= Collection_.First().Duration_;
+		SumChanges_ -= Collection_.First().Changed_;
+	}
+
 	TimeType MaxTime_ = 3;
 
-	std::list<SElem> Collection_;
+	TFixedRingBuffer<SElem> Collection_;
 	
 	TimeType FullDuration_ = 0;
 	ChangingType SumChanges_ = ChangingType();
@@ -112,101 +118,9 @@ private:
 
 inline FTimeChangeCollector<float, float, float> FFloatChangeCollector;
 
+// Engine-independent, shared with the standalone benchmark
 template<typename TimeType>
-class FTimeStampCollector
-{
-public:
-	struct SElem
-	{
-		TimeType Stamp_;
-		TimeType Duration_;
-	};
-
-
-	FTimeStampCollector() = default;
-	FTimeStampCollector(TimeType InMaxTime): MaxTime_(InMaxTime) {}
-	FTimeStampCollector(TimeType InMaxTime, TimeType InDropTimeThreshold): MaxTime_(InMaxTime), DropTimeThreshold_(InDropTimeThreshold) {}
-
-	FTimeStampCollector(const FTimeStampCollector& Other)
-	: MaxTime_(Other.MaxTime_), DropTimeThreshold_(Other.DropTimeThreshold_), Collection_(Other.Collection_), FullDuration_(Other.FullDuration_) {}
-
-	FTimeStampCollector(FTimeStampCollector&& Other) noexcept
-		: MaxTime_(Other.MaxTime_), DropTimeThreshold_(Other.DropTimeThreshold_), Collection_(std::move(Other.Collection_)), FullDuration_(Other.FullDuration_) {}
-
-	void Add(TimeType InTimeStamp)
-	{
-		if(Collection_.empty())
-		{
-			Collection_.push_back(SElem{ InTimeStamp, 0 });
-		}
-		else
-		{
-			TimeType Duration = InTimeStamp - Collection_.back().Stamp_;
-			if(!FMath::IsNearlyZero(Duration))
-			{
-				if(Duration > DropTimeThreshold_)
-				{
-					Clear();
-					Collection_.push_back(SElem{ InTimeStamp, 0 });
-				}
-				else
-				{
-					Collection_.push_back(SElem{ InTimeStamp, Duration});
-
-					FullDuration_ += Duration;
-			
-					while(FullDuration_ > MaxTime_ && Collection_.size() > 1)
-					{
-						Collection_.pop_front();
-						FullDuration_ -= Collection_.front().Duration_;
-					}
-				}
-			}
-		}
-	}
-
-	bool IsValid() const { return Collection_.size() > 1; }
-	
-	TimeType GetFullTime() const
-	{
-		if(!IsValid())
-			return 0.;
-		return  FullDuration_;
-	}
-
-	TimeType GetLastDuration() const
-	{
-		return !IsValid() ? 0 : Collection_.rbegin()->Duration_;
-	}
-
-	TimeType GetAverageDuration() const
-	{
-		return !IsValid() ? 0 : FullDuration_ / (Collection_.size() - 1);
-	}
-
-	std::pair<TimeType, TimeType> GetMinMaxDuration() const
-	{
-		if(Collection_.empty())
-			return std::make_pair(0.f, 0.f);
-
-		const auto Elems = std::minmax_element(Collection_.begin(), Collection_.end(), [](const SElem& e1, const SElem& e2) { return e1.Duration_ < e2.Duration_; });
-		return std::make_pair(Elems.first->Duration_, Elems.second->Duration_);
-	}
-
-	void Clear()
-	{
-		FullDuration_ = 0;
-		Collection_.clear();
-	}
-
-	const std::list<SElem>& GetCollection() const { return Collection_; } 
-
-private:
-	TimeType MaxTime_ = 3;
-	TimeType DropTimeThreshold_ = 0.4f;
-	std::list<SElem> Collection_;
-	TimeType FullDuration_ = 0;
-};
+using FTimeStampCollector = DRCore::TTimeStampCollector<TimeType>;
 
 class FDateTimeStampCollector
 {
@@ -217,37 +131,39 @@ public:
 		float Duration_;
 	};
 
-	FDateTimeStampCollector() = default;
-	FDateTimeStampCollector(float InMaxTime): MaxTime_(InMaxTime) {}
-	FDateTimeStampCollector(float InMaxTime, float InDropTimeThreshold): MaxTime_(InMaxTime), DropTimeThreshold_(InDropTimeThreshold) {}
+	FDateTimeStampCollector(): Collection_(DefaultTimeCollectorCapacity) {}
+	FDateTimeStampCollector(float InMaxTime, int32 InCapacity = DefaultTimeCollectorCapacity): MaxTime_(InMaxTime), Collection_(InCapacity) {}
+	FDateTimeStampCollector(float InMaxTime, float InDropTimeThreshold, int32 InCapacity = DefaultTimeCollectorCapacity)
+	: MaxTime_(InMaxTime), DropTimeThreshold_(InDropTimeThreshold), Collection_(InCapacity) {}
 
 	void Add(FDateTime InTimeStamp)
 	{
-		if(Collection_.empty())
+		if(Collection_.IsEmpty())
 		{
-			Collection_.push_back(SElem{ InTimeStamp, 0 });
+			Collection_.Add(SElem{ InTimeStamp, 0 });
 		}
 		else
 		{
 			
-			float Duration = (InTimeStamp - Collection_.back().Stamp_).GetTotalSeconds();
+			float Duration = (InTimeStamp - Collection_.Last().Stamp_).GetTotalSeconds();
 			if(!FMath::IsNearlyZero(Duration))
 			{
 				if(Duration > DropTimeThreshold_)
 				{
 					Clear();
-					Collection_.push_back(SElem{ InTimeStamp, 0 });
+					Collection_.Add(SElem{ InTimeStamp, 0 });
 				}
 				else
 				{
-					Collection_.push_back(SElem{ InTimeStamp, Duration});
+					if(Collection_.IsFull())
+						PopFront();
+					Collection_.Add(SElem{ InTimeStamp, Duration});
 
 					FullDuration_ += Duration;
 			
-					while(FullDuration_ > MaxTime_ && Collection_.size() > 1)
+					while(FullDuration_ > MaxTime_ && Collection_.Num() > 1)
 					{
-						Collection_.pop_front();
-						FullDuration_ -= Collection_.front().Duration_;
+						PopFront();
 					}
 				}
 			}
@@ -257,10 +173,10 @@ public:
 	void Clear()
 	{
 		FullDuration_ = 0;
-		Collection_.clear();
+		Collection_.Clear();
 	}
 
-	bool IsValid() const { return Collection_.size() > 1; }
+	bool IsValid() const { return Collection_.Num() > 1; }
 	
 	float GetFullTime() const
 	{
@@ -271,22 +187,46 @@ public:
 	
 	float GetLastDuration() const
 	{
-		return !IsValid() ? 0 : Collection_.rbegin()->Duration_;
+		return !IsValid() ? 0 : Collection_.Last().Duration_;
 	}
 
 	FDateTime GetLastTimeStamp() const
 	{
-		return !IsValid() ? 0 : Collection_.rbegin()->Stamp_;
+		return !IsValid() ? 0 : Collection_.Last().Stamp_;
 	}
 
 	float GetAverageDuration() const
 	{
-		return !IsValid() ? 0 : FullDuration_ / (Collection_.size() - 1);
+		return !IsValid() ? 0 : FullDuration_ / (Collection_.Num() - 1);
 	}
+
+	// Standard deviation of the intervals, recomputed over the window in double like TTimeStampCollector::GetJitter
+	float GetJitter() const
+	{
+		if(!IsValid())
+			return 0.;
+		const int32 NumDurations = Collection_.Num() - 1;
+		double Sum = 0.0;
+		for(int32 i = 1; i <= NumDurations; ++i)
+			Sum += Collection_[i].Duration_;
+		const double Average = Sum / NumDurations;
+		double SumSquaredDeviations = 0.0;
+		for(int32 i = 1; i <= NumDurations; ++i)
+			SumSquaredDeviations += FMath::Square(Collection_[i].Duration_ - Average);
+		return static_cast<float>(FMath::Sqrt(SumSquaredDeviations / NumDurations));
+	}
+
+	SIZE_T GetAllocatedSize() const { return Collection_.GetAllocatedSize(); }
 	
 private:
+	void PopFront()
+	{
+		Collection_.PopFront();
+		FullDuration_ -= Collection_.First().Duration_;
+	}
+
 	float MaxTime_ = 3;
 	float DropTimeThreshold_ = 0.4f;
-	std::list<SElem> Collection_;
+	TFixedRingBuffer<SElem> Collection_;
 	float FullDuration_ = 0;
 };
\ No newline at end of file
@@ -0,0 +1,578 @@
+// Headless dead reckoning benchmark built on the engine-independent core.
+// Simulates N scripted movers on a server, a lossy and jittery link, and a client
+// running the blending extrapolator or the snapshot interpolator, then reports
+// throughput and accuracy.
+
+#include "DeadReckoningCore/DRCore.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <queue>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+	struct FBenchmarkSettings
+	{
+		int NumEntities = 1000;
+		double Duration = 20.0; // Simulated seconds
+		double Warmup = 1.0; // Seconds excluded from the error statistics, covers the initial jump onto the path
+		double ServerHz = 60.0;
+		double ClientHz = 60.0;
+		double LatencyMs = 50.0; // One-way base latency
+		double JitterMs = 10.0; // Uniform extra delay in [0, JitterMs]
+		double RoundTripMs = -1.0; // Round trip the client measures, negative for the mean of a symmetric path, 0 disables latency compensation
+		double LossPercent = 0.0;
+		bool bStream = true; // Lost states stay lost, as with EDRKinematicTransport::UnreliableStream; otherwise resent like a replicated property
+		double ReplicationTime = 0.5;
+		DRCore::EReplicationPolicy Policy = DRCore::EReplicationPolicy::Distance;
+		double ErrorTolerance = 20.0;
+		bool bInterpolate = false; // Client renders buffered snapshots instead of extrapolating
+		double JitterMultiplier = 2.0; // Interpolation delay is the average interval plus this many jitter deviations
+		DRCore::EIntervalEstimate BlendTimeEstimate = DRCore::EIntervalEstimate::Mean; // Same default as ADRWorldSettings
+		double BlendTimePercentile = 0.9;
+		double ClientClockOffset = 1000.0; // Client clock runs ahead of the server by this much
+		std::string CapturePrefix; // Write <prefix>_Server.drcap and <prefix>_Client.drcap for DRReplay
+		double OriginOffset = 0.0; // Added to every path center to exercise large-world coordinates
+		bool bPrecisionCheck = false; // Shadow every client with a double precision extrapolator and compare
+		bool bHitchCheck = false; // Only run the fixed step stamping check
+		unsigned Seed = 1;
+	};
+
+	struct FPacket
+	{
+		double ArrivalTime;
+		int Entity;
+		DRCore::FKinematicState State;
+
+		bool operator>(const FPacket& Other) const { return ArrivalTime > Other.ArrivalTime; }
+	};
+
+	// A lost property update, noticed by the server one round trip after it was sent
+	struct FResend
+	{
+		double DetectTime;
+		int Entity;
+		double StateTime; // Only resent while no newer state has been sent since
+	};
+
+	struct FClientEntity
+	{
+		DRCore::FRebasedBlendingExtrapolator Extrapolator; // Float32 offsets, as in UDRDeadReckoningSubsystem
+		DRCore::FBlendingExtrapolator Reference; // Double precision, --precision-check only
+		DRCore::TTimeStampCollector<double> TimeStampCollector{ 1.0, 1.0 };
+		double LastServerTime = -1.0;
+
+		// Interpolation mode
+		DRCore::FSnapshotInterpolator Interpolator;
+		DRCore::TTimeStampCollector<double> ArrivalCollector{ 1.0, 1.0 };
+		double InterpolationDelay = 0.0;
+		DRCore::FVec3 Position;
+	};
+
+	constexpr float MaxSampleAge = 0.5f;
+
+	// Append-only capture file, same layout as UDRCaptureSubsystem writes
+	class FCaptureFile
+	{
+	public:
+		bool Open(const std::string& InPath)
+		{
+			File_ = std::fopen(InPath.c_str(), "wb");
+			if(File_ == nullptr)
+				return false;
+			const DRCore::Capture::FFileHeader Header = DRCore::Capture::MakeHeader();
+			std::fwrite(&Header, sizeof(Header), 1, File_);
+			return true;
+		}
+
+		void Write(const DRCore::Capture::FRecord& InRecord)
+		{
+			if(File_ != nullptr)
+				std::fwrite(&InRecord, sizeof(InRecord), 1, File_);
+		}
+
+		~FCaptureFile()
+		{
+			if(File_ != nullptr)
+				std::fclose(File_);
+		}
+
+	private:
+		std::FILE* File_ = nullptr;
+	};
+
+	// Same bounds as the ADRWorldSettings defaults
+	constexpr double MinInterpolationDelay = 0.02;
+	constexpr double MaxInterpolationDelay = 0.5;
+	constexpr double MaxInterpolationExtrapolation = 0.25;
+
+	// Largest allowed distance between the float32 and double extrapolation for --precision-check.
+	// Float rounding accumulates over the blend, bounded by the rebase distance rather than the world offset.
+	constexpr double PrecisionTolerance = 0.05;
+
+	// Largest allowed difference between a state's stamp and the simulated time of its step for --hitch-check
+	constexpr double StampTolerance = 1e-4;
+	// Largest allowed distance between a stamped state and the closed form motion at its stamp
+	constexpr double DescriptorTolerance = 1.0;
+
+	// Steps movers on the fixed step clock the way ADRPawn::SimulateServerMotion does, through frames
+	// with a hitch far longer than the substep cap, and compares every stamp with the time simulated up
+	// to its step and the sent position with the described FMotionDescriptor at the stamp. Returns the exit code.
+	int RunHitchCheck(const FBenchmarkSettings& InSettings)
+	{
+		std::mt19937 Random(InSettings.Seed);
+		std::uniform_real_distribution<double> Unit(0.0, 1.0);
+
+		const int NumEntities = std::min(InSettings.NumEntities, 100);
+		std::vector<DRCore::FMover> Movers(NumEntities);
+		std::vector<DRCore::FMotionDescriptor> Descriptors(NumEntities);
+		std::vector<DRCore::FKinematicState> ServerStates(NumEntities);
+		for(int i = 0; i < NumEntities; ++i)
+		{
+			DRCore::FMotionSettings Motion;
+			Motion.MotionType = (i % 2) == 0 ? DRCore::EMotionType::Circle : DRCore::EMotionType::Square;
+			Motion.Radius = static_cast<float>(200.0 + 400.0 * Unit(Random));
+			Motion.AngularSpeed = DRCore::FRotator3(0.0, 45.0 + 90.0 * Unit(Random), 0.0);
+			Motion.SideLength = static_cast<float>(200.0 + 400.0 * Unit(Random));
+			Motion.Speed = static_cast<float>(100.0 + 300.0 * Unit(Random));
+			Motion.ReplicationTime = static_cast<float>(InSettings.ReplicationTime);
+			Movers[i].Initialize(Motion, DRCore::FVec3(Unit(Random) * 10000.0, Unit(Random) * 10000.0, 0.0));
+			Movers[i].SetPhase(Unit(Random));
+			// Through the replicated description, as clients receive it
+			const DRCore::FMotionDescriptor Described = DRCore::FMotionDescriptor::FromMover(Movers[i], 0.0);
+			Descriptors[i] = DRCore::FMotionDescriptor::FromDescription(Described.Describe(), Described.StartTime);
+			ServerStates[i] = DRCore::FKinematicState(Movers[i].Location, DRCore::FVec3::Zero(), DRCore::FVec3::Zero(), 0.0);
+		}
+
+		// One frame of HitchTime half way through, every other frame at the client rate
+		DRCore::FFixedStepAccumulator Stepper(DRCore::DefaultFixedStepTime, DRCore::DefaultMaxSubsteps);
+		const double FrameTime = 1.0 / InSettings.ClientHz;
+		const double HitchTime = 0.5;
+		double WorldTime = 0.0;
+		bool bHitched = false;
+		double MaxStampError = 0.0;
+		double MaxDescriptorError = 0.0;
+		long long UpdatesChecked = 0;
+		while(WorldTime < InSettings.Duration)
+		{
+			const double DeltaTime = !bHitched && WorldTime >= 0.5 * InSettings.Duration ? HitchTime : FrameTime;
+			bHitched = bHitched || DeltaTime == HitchTime;
+			WorldTime += DeltaTime;
+
+			const int NumSteps = Stepper.Advance(DeltaTime);
+			const float StepTime = static_cast<float>(Stepper.GetStepTime());
+			const double LastStepTime = WorldTime - Stepper.GetRemainder();
+			for(int i = 0; i < NumEntities; ++i)
+			{
+				const int LastSentStep = Movers[i].Step(NumSteps, StepTime, ServerStates[i]);
+				if(LastSentStep < 0)
+					continue;
+
+				ServerStates[i].Time = LastStepTime - (NumSteps - 1 - LastSentStep) * StepTime;
+				const double SimulatedTime = Movers[i].SimTime - (NumSteps - 1 - LastSentStep) * static_cast<double>(StepTime);
+				MaxStampError = std::max(MaxStampError, std::abs(ServerStates[i].Time - SimulatedTime));
+				MaxDescriptorError = std::max(MaxDescriptorError, DRCore::FVec3::Distance(ServerStates[i].Position, Descriptors[i].Evaluate(ServerStates[i].Time)));
+				++UpdatesChecked;
+			}
+		}
+		const double Lag = NumEntities > 0 ? WorldTime - Stepper.GetRemainder() - Movers[0].SimTime : 0.0;
+		MaxStampError = std::max(MaxStampError, std::abs(Lag));
+
+		const bool bPassed = MaxStampError <= StampTolerance && MaxDescriptorError <= DescriptorTolerance;
+		std::printf("hitch check         %d movers, %.0f ms hitch, %lld updates, stamp error max %.6f s, closed form error max %.3f, %s\n",
+			NumEntities, HitchTime * 1000.0, UpdatesChecked, MaxStampError, MaxDescriptorError, bPassed ? "passed" : "FAILED");
+		return bPassed ? 0 : 2;
+	}
+
+	void PrintUsage()
+	{
+		std::printf(
+			"Usage: DRBenchmark [options]\n"
+			"  --entities N        number of movers (1000)\n"
+			"  --duration S        simulated seconds (20)\n"
+			"  --warmup S          seconds excluded from error stats (1)\n"
+			"  --server-hz HZ      server tick rate (60)\n"
+			"  --client-hz HZ      client frame rate (60)\n"
+			"  --latency MS        one-way latency (50)\n"
+			"  --jitter MS         extra uniform delay (10)\n"
+			"  --rtt MS            measured round trip, 0 disables latency compensation (2 * latency + jitter)\n"
+			"  --loss PCT          packet loss percent (0)\n"
+			"  --transport T       stream | property, whether lost states are resent (stream)\n"
+			"  --replication-time S  mover replication time (0.5)\n"
+			"  --policy P          distance | error (distance)\n"
+			"  --error-tolerance U prediction error tolerance for --policy error (20)\n"
+			"  --client-mode M     extrapolate | interpolate (extrapolate)\n"
+			"  --jitter-multiplier K  interpolation delay jitter multiplier (2)\n"
+			"  --blend-time E      update interval the blend is normalized by: mean | ewma | pNN percentile (mean)\n"
+			"  --capture PREFIX    write PREFIX_Server.drcap and PREFIX_Client.drcap for DRReplay\n"
+			"  --origin-offset U   move every path this far from the world origin along X and Y (0)\n"
+			"  --precision-check   compare the float32 extrapolation with a double one, fails above %.3f units\n"
+			"  --hitch-check       step movers through a frame hitch, fails if a state stamp misses its simulated time\n"
+			"  --seed N            random seed (1)\n", PrecisionTolerance);
+	}
+
+	bool ParseArgs(int Argc, char** Argv, FBenchmarkSettings& Out_Settings)
+	{
+		for(int i = 1; i < Argc; ++i)
+		{
+			const std::string Arg = Argv[i];
+			if(Arg == "--help" || Arg == "-h")
+				return false;
+			if(Arg == "--precision-check")
+			{
+				Out_Settings.bPrecisionCheck = true;
+				continue;
+			}
+			if(Arg == "--hitch-check")
+			{
+				Out_Settings.bHitchCheck = true;
+				continue;
+			}
+			if(i + 1 >= Argc)
+			{
+				std::fprintf(stderr, "Missing value for %s\n", Arg.c_str());
+				return false;
+			}
+			const char* Value = Argv[++i];
+			if(Arg == "--entities") Out_Settings.NumEntities = std::max(1, std::atoi(Value));
+			else if(Arg == "--duration") Out_Settings.Duration = std::atof(Value);
+			else if(Arg == "--warmup") Out_Settings.Warmup = std::atof(Value);
+			else if(Arg == "--server-hz") Out_Settings.ServerHz = std::atof(Value);
+			else if(Arg == "--client-hz") Out_Settings.ClientHz = std::atof(Value);
+			else if(Arg == "--latency") Out_Settings.LatencyMs = std::atof(Value);
+			else if(Arg == "--jitter") Out_Settings.JitterMs = std::atof(Value);
+			else if(Arg == "--rtt") Out_Settings.RoundTripMs = std::atof(Value);
+			else if(Arg == "--loss") Out_Settings.LossPercent = std::atof(Value);
+			else if(Arg == "--replication-time") Out_Settings.ReplicationTime = std::atof(Value);
+			else if(Arg == "--transport")
+			{
+				const std::string Transport = Value;
+				if(Transport == "stream") Out_Settings.bStream = true;
+				else if(Transport == "property") Out_Settings.bStream = false;
+				else
+				{
+					std::fprintf(stderr, "Unknown transport %s\n", Value);
+					return false;
+				}
+			}
+			else if(Arg == "--policy")
+			{
+				const std::string Policy = Value;
+				if(Policy == "distance") Out_Settings.Policy = DRCore::EReplicationPolicy::Distance;
+				else if(Policy == "error") Out_Settings.Policy = DRCore::EReplicationPolicy::PredictionError;
+				else
+				{
+					std::fprintf(stderr, "Unknown policy %s\n", Value);
+					return false;
+				}
+			}
+			else if(Arg == "--error-tolerance") Out_Settings.ErrorTolerance = std::atof(Value);
+			else if(Arg == "--client-mode")
+			{
+				const std::string Mode = Value;
+				if(Mode == "extrapolate") Out_Settings.bInterpolate = false;
+				else if(Mode == "interpolate") Out_Settings.bInterpolate = true;
+				else
+				{
+					std::fprintf(stderr, "Unknown client mode %s\n", Value);
+					return false;
+				}
+			}
+			else if(Arg == "--jitter-multiplier") Out_Settings.JitterMultiplier = std::atof(Value);
+			else if(Arg == "--blend-time")
+			{
+				const std::string Estimate = Value;
+				if(Estimate == "mean") Out_Settings.BlendTimeEstimate = DRCore::EIntervalEstimate::Mean;
+				else if(Estimate == "ewma") Out_Settings.BlendTimeEstimate = DRCore::EIntervalEstimate::Ewma;
+				else if(Estimate.size() > 1 && Estimate[0] == 'p')
+				{
+					Out_Settings.BlendTimeEstimate = DRCore::EIntervalEstimate::Quantile;
+					Out_Settings.BlendTimePercentile = std::min(std::max(std::atof(Value + 1) * 0.01, 0.0), 1.0);
+				}
+				else
+				{
+					std::fprintf(stderr, "Unknown blend time estimate %s\n", Value);
+					return false;
+				}
+			}
+			else if(Arg == "--capture") Out_Settings.CapturePrefix = Value;
+			else if(Arg == "--origin-offset") Out_Settings.OriginOffset = std::atof(Value);
+			else if(Arg == "--seed") Out_Settings.Seed = static_cast<unsigned>(std::atoi(Value));
+			else
+			{
+				std::fprintf(stderr, "Unknown option %s\n", Arg.c_str());
+				return false;
+			}
+		}
+		return Out_Settings.ServerHz > 0.0 && Out_Settings.ClientHz > 0.0 && Out_Settings.Duration > 0.0;
+	}
+}
+
+int main(int Argc, char** Argv)
+{
+	FBenchmarkSettings Settings;
+	if(!ParseArgs(Argc, Argv, Settings))
+	{
+		PrintUsage();
+		return 1;
+	}
+	if(Settings.bHitchCheck)
+		return RunHitchCheck(Settings);
+
+	std::mt19937 Random(Settings.Seed);
+	std::uniform_real_distribution<double> Unit(0.0, 1.0);
+
+	// Half circles, half squares with randomized parameters
+	const int NumEntities = Settings.NumEntities;
+	std::vector<DRCore::FMover> Movers(NumEntities);
+	std::vector<DRCore::FKinematicState> ServerStates(NumEntities);
+	std::vector<FClientEntity> Clients(NumEntities);
+	for(int i = 0; i < NumEntities; ++i)
+	{
+		DRCore::FMotionSettings Motion;
+		Motion.MotionType = (i % 2) == 0 ? DRCore::EMotionType::Circle : DRCore::EMotionType::Square;
+		Motion.Radius = static_cast<float>(200.0 + 400.0 * Unit(Random));
+		Motion.AngularSpeed = DRCore::FRotator3(0.0, 45.0 + 90.0 * Unit(Random), 0.0);
+		Motion.SideLength = static_cast<float>(200.0 + 400.0 * Unit(Random));
+		Motion.Speed = static_cast<float>(100.0 + 300.0 * Unit(Random));
+		Motion.ReplicationTime = static_cast<float>(Settings.ReplicationTime);
+		Motion.ReplicationPolicy = Settings.Policy;
+		Motion.ReplicationErrorTolerance = static_cast<float>(Settings.ErrorTolerance);
+
+		const DRCore::FVec3 Center(Settings.OriginOffset + Unit(Random) * 100000.0, Settings.OriginOffset + Unit(Random) * 100000.0, 0.0);
+		Movers[i].Initialize(Motion, Center);
+		ServerStates[i] = DRCore::FKinematicState(Movers[i].Location, DRCore::FVec3::Zero(), DRCore::FVec3::Zero(), 0.0);
+		Clients[i].Extrapolator.Reset(ServerStates[i]);
+		Clients[i].Extrapolator.AverageServerUpdateTime = static_cast<float>(1.0 / Settings.ServerHz);
+		Clients[i].TimeStampCollector.SetQuantile(Settings.BlendTimePercentile);
+		Clients[i].Reference.Reset(ServerStates[i]);
+		Clients[i].Reference.AverageServerUpdateTime = Clients[i].Extrapolator.AverageServerUpdateTime;
+		Clients[i].Position = ServerStates[i].Position;
+	}
+
+	// What the client's connection would measure with the same delay distribution in both directions
+	const double RoundTrip = (Settings.RoundTripMs >= 0.0 ? Settings.RoundTripMs : 2.0 * Settings.LatencyMs + Settings.JitterMs) * 0.001;
+
+	// Server locations of the recent steps, the interpolating client is compared against the past
+	const int HistoryLength = static_cast<int>(std::ceil((MaxInterpolationDelay + Settings.LatencyMs * 0.001 + Settings.JitterMs * 0.001) * Settings.ServerHz)) + 4;
+	std::vector<DRCore::TFixedRingBuffer<DRCore::FVec3>> History;
+	if(Settings.bInterpolate)
+		History.assign(NumEntities, DRCore::TFixedRingBuffer<DRCore::FVec3>(HistoryLength));
+
+	FCaptureFile ServerCapture;
+	FCaptureFile ClientCapture;
+	if(!Settings.CapturePrefix.empty())
+	{
+		if(!ServerCapture.Open(Settings.CapturePrefix + "_Server.drcap") || !ClientCapture.Open(Settings.CapturePrefix + "_Client.drcap"))
+		{
+			std::fprintf(stderr, "Cannot open capture files %s_*.drcap\n", Settings.CapturePrefix.c_str());
+			return 1;
+		}
+	}
+	const bool bCapture = !Settings.CapturePrefix.empty();
+
+	DRCore::FClockOffsetEstimator ClockOffset; // One per connection
+	std::priority_queue<FPacket, std::vector<FPacket>, std::greater<FPacket>> InFlight;
+	std::deque<FResend> Resends; // Property transport only, in detection order
+	const double LossDetectionTime = (2.0 * Settings.LatencyMs + Settings.JitterMs) * 0.001;
+
+	const double ServerDt = 1.0 / Settings.ServerHz;
+	const double ClientDt = 1.0 / Settings.ClientHz;
+	double ServerTime = 0.0;
+	double ClientTime = 0.0;
+
+	long long ServerSteps = 0;
+	long long ClientSteps = 0;
+	long long UpdatesSent = 0;
+	long long UpdatesLost = 0;
+	long long UpdatesResent = 0;
+	long long UpdatesStale = 0;
+	double SumSquaredError = 0.0;
+	double MaxError = 0.0;
+	double MaxPrecisionError = 0.0; // Float32 against double extrapolation, --precision-check
+	long long ErrorSamples = 0;
+	double SumInterpolationDelay = 0.0;
+
+	// The stream drops a lost state for good. Property replication notices the loss from the acks and
+	// sends the property again, which still holds the lost state unless a newer one replaced it.
+	auto SendState = [&](int InEntity)
+	{
+		if(Unit(Random) * 100.0 < Settings.LossPercent)
+		{
+			++UpdatesLost;
+			if(!Settings.bStream)
+				Resends.push_back(FResend{ ServerTime + LossDetectionTime, InEntity, ServerStates[InEntity].Time });
+			return;
+		}
+		const double Delay = (Settings.LatencyMs + Settings.JitterMs * Unit(Random)) * 0.001;
+		InFlight.push(FPacket{ ServerTime + Delay, InEntity, ServerStates[InEntity] });
+	};
+
+	const auto WallStart = std::chrono::steady_clock::now();
+
+	while(ClientTime < Settings.Duration)
+	{
+		// Run the server up to the client's frame time so ground truth is available
+		while(ServerTime + ServerDt <= ClientTime + 1e-9)
+		{
+			ServerTime += ServerDt;
+			while(!Resends.empty() && Resends.front().DetectTime <= ServerTime)
+			{
+				const FResend Resend = Resends.front();
+				Resends.pop_front();
+				if(ServerStates[Resend.Entity].Time == Resend.StateTime)
+				{
+					++UpdatesResent;
+					SendState(Resend.Entity);
+				}
+			}
+			for(int i = 0; i < NumEntities; ++i)
+			{
+				const bool bSend = Movers[i].Step(static_cast<float>(ServerDt), ServerStates[i]);
+				if(bCapture)
+				{
+					const DRCore::FKinematicState Truth(Movers[i].Location, Movers[i].Velocity, DRCore::FVec3::Zero(), ServerTime);
+					ServerCapture.Write(DRCore::Capture::MakeRecord(DRCore::Capture::ERecordType::Truth, i, ServerTime, 0.0, Truth));
+				}
+				if(bSend)
+				{
+					ServerStates[i].Time = ServerTime;
+					++UpdatesSent;
+					if(bCapture)
+						ServerCapture.Write(DRCore::Capture::MakeRecord(DRCore::Capture::ERecordType::State, i, ServerTime, 0.0, ServerStates[i]));
+					SendState(i);
+				}
+			}
+			for(int i = 0; i < static_cast<int>(History.size()); ++i)
+			{
+				if(History[i].IsFull())
+					History[i].PopFront();
+				History[i].Add(Movers[i].Location);
+			}
+			ServerSteps += NumEntities;
+		}
+
+		// Deliver everything that arrived by this frame
+		while(!InFlight.empty() && InFlight.top().ArrivalTime <= ClientTime)
+		{
+			const FPacket Packet = InFlight.top();
+			InFlight.pop();
+
+			FClientEntity& Client = Clients[Packet.Entity];
+			if(Packet.State.Time <= Client.LastServerTime)
+			{
+				++UpdatesStale;
+				continue;
+			}
+			Client.LastServerTime = Packet.State.Time;
+			if(bCapture)
+				ClientCapture.Write(DRCore::Capture::MakeRecord(DRCore::Capture::ERecordType::Receive, Packet.Entity, Packet.State.Time, ClientTime + Settings.ClientClockOffset, Packet.State));
+
+			Client.TimeStampCollector.Add(Packet.State.Time);
+			float AverageServerUpdateTime = Client.Extrapolator.AverageServerUpdateTime;
+			if(Client.TimeStampCollector.IsValid())
+				AverageServerUpdateTime = static_cast<float>(Client.TimeStampCollector.GetDuration(Settings.BlendTimeEstimate));
+
+			// Same handling as ADRPawn::OnRep_KinematicState
+			ClockOffset.AddSample(ClientTime + Settings.ClientClockOffset, Packet.State.Time);
+			if(Settings.bInterpolate)
+			{
+				Client.Interpolator.AddSnapshot(Packet.State);
+				Client.ArrivalCollector.Add(ClientTime);
+				Client.InterpolationDelay = DRCore::ComputeInterpolationDelay(Client.ArrivalCollector.GetAverageDuration(), Client.ArrivalCollector.GetJitter(),
+					Settings.JitterMultiplier, MinInterpolationDelay, MaxInterpolationDelay);
+				continue;
+			}
+
+			const double SampleAge = std::min(ClockOffset.GetLastSampleAge(RoundTrip), static_cast<double>(MaxSampleAge));
+			DRCore::FKinematicState State = Packet.State;
+			State.Extrapolate(SampleAge);
+			Client.Extrapolator.SetServerState(State, AverageServerUpdateTime);
+			if(Settings.bPrecisionCheck)
+				Client.Reference.SetServerState(State, AverageServerUpdateTime);
+		}
+
+		// Client frame and error against the server's true location at the same time
+		ClientTime += ClientDt;
+		const double Lead = ClientTime - ServerTime;
+		const bool bMeasure = ClientTime > Settings.Warmup;
+		for(int i = 0; i < NumEntities; ++i)
+		{
+			FClientEntity& Client = Clients[i];
+			DRCore::FVec3 Truth;
+			if(Settings.bInterpolate)
+			{
+				if(!ClockOffset.IsValid())
+					continue;
+
+				// Rendered in the past, compared against the server location at the render time
+				const double RenderTime = ClientTime + Settings.ClientClockOffset - ClockOffset.GetOffset() - Client.InterpolationDelay;
+				DRCore::FVec3 Velocity;
+				Client.Interpolator.Sample(RenderTime, MaxInterpolationExtrapolation, Client.Position, Velocity);
+				if(!bMeasure)
+					continue;
+
+				const DRCore::TFixedRingBuffer<DRCore::FVec3>& Locations = History[i];
+				const double StepsBack = std::clamp((ServerTime - RenderTime) / ServerDt, 0.0, static_cast<double>(Locations.Num() - 1));
+				const int Index = Locations.Num() - 1 - static_cast<int>(std::ceil(StepsBack));
+				const double Alpha = std::ceil(StepsBack) - StepsBack;
+				const DRCore::FVec3& Before = Locations[Index];
+				const DRCore::FVec3& After = Locations[std::min(Index + 1, Locations.Num() - 1)];
+				Truth = Before + (After - Before) * Alpha;
+				SumInterpolationDelay += Client.InterpolationDelay;
+			}
+			else
+			{
+				Client.Position = Client.Extrapolator.Step(static_cast<float>(ClientDt));
+				if(Settings.bPrecisionCheck)
+					MaxPrecisionError = std::max(MaxPrecisionError, DRCore::FVec3::Distance(Client.Position, Client.Reference.Step(static_cast<float>(ClientDt))));
+				if(!bMeasure)
+					continue;
+
+				// Ground truth is linearly interpolated from the last server step
+				const DRCore::FMover& Mover = Movers[i];
+				Truth = Mover.Location + (Mover.Location - Mover.PreviousLocation) * (Lead / ServerDt);
+			}
+			const DRCore::FVec3& Predicted = Client.Position;
+			const double Error = DRCore::FVec3::Distance(Predicted, Truth);
+			SumSquaredError += Error * Error;
+			MaxError = std::max(MaxError, Error);
+		}
+		ClientSteps += NumEntities;
+		if(bMeasure)
+			ErrorSamples += NumEntities;
+	}
+
+	const double WallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - WallStart).count();
+	const double RmsError = ErrorSamples > 0 ? std::sqrt(SumSquaredError / ErrorSamples) : 0.0;
+
+	std::printf("entities %d, duration %.1fs, server %.0fHz, client %.0fHz, latency %.1fms, jitter %.1fms, rtt %.1fms, loss %.1f%%, transport %s, policy %s, client %s\n",
+		NumEntities, Settings.Duration, Settings.ServerHz, Settings.ClientHz, Settings.LatencyMs, Settings.JitterMs, RoundTrip * 1000.0, Settings.LossPercent,
+		Settings.bStream ? "stream" : "property",
+		Settings.Policy == DRCore::EReplicationPolicy::Distance ? "distance" : "error",
+		Settings.bInterpolate ? "interpolate" : "extrapolate");
+	std::printf("wall time           %.3f s\n", WallSeconds);
+	std::printf("throughput          %.3e entity-steps/s (server %lld, client %lld steps)\n",
+		(ServerSteps + ClientSteps) / std::max(WallSeconds, 1e-9), ServerSteps, ClientSteps);
+	std::printf("updates sent        %lld (%.1f/s per entity), lost %lld, resent %lld, stale %lld\n",
+		UpdatesSent, UpdatesSent / (Settings.Duration * NumEntities), UpdatesLost, UpdatesResent, UpdatesStale);
+	std::printf("position error      rms %.3f, max %.3f\n", RmsError, MaxError);
+	if(Settings.bInterpolate)
+		std::printf("interpolation delay %.1f ms average\n", ErrorSamples > 0 ? 1000.0 * SumInterpolationDelay / ErrorSamples : 0.0);
+	if(Settings.bPrecisionCheck && !Settings.bInterpolate)
+	{
+		const bool bPassed = MaxPrecisionError <= PrecisionTolerance;
+		std::printf("float32 vs double   max %.6f at origin offset %.0f, %s\n", MaxPrecisionError, Settings.OriginOffset, bPassed ? "passed" : "FAILED");
+		if(!bPassed)
+			return 2;
+	}
+	return 0;
+}
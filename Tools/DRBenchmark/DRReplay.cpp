@@ -0,0 +1,192 @@
+// Offline replay of captured dead reckoning sessions.
+// Memory-maps server (and optionally client) captures written by UDRCaptureSubsystem or
+// DRBenchmark --capture, re-runs the client extrapolation faster than real time and
+// reports the position error, so blend and threshold settings can be compared offline.
+
+#include "DeadReckoningCore/DRCore.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	// Read-only mapping of a whole file
+	class FMappedFile
+	{
+	public:
+		explicit FMappedFile(const std::string& InPath)
+		{
+#if defined(_WIN32)
+			File_ = CreateFileA(InPath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if(File_ == INVALID_HANDLE_VALUE)
+				return;
+			LARGE_INTEGER FileSize;
+			if(!GetFileSizeEx(File_, &FileSize) || FileSize.QuadPart == 0)
+				return;
+			Mapping_ = CreateFileMappingA(File_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if(Mapping_ == nullptr)
+				return;
+			Data_ = MapViewOfFile(Mapping_, FILE_MAP_READ, 0, 0, 0);
+			Size_ = Data_ != nullptr ? static_cast<size_t>(FileSize.QuadPart) : 0;
+#else
+			File_ = open(InPath.c_str(), O_RDONLY);
+			if(File_ < 0)
+				return;
+			struct stat FileStat;
+			if(fstat(File_, &FileStat) != 0 || FileStat.st_size == 0)
+				return;
+			void* Data = mmap(nullptr, static_cast<size_t>(FileStat.st_size), PROT_READ, MAP_PRIVATE, File_, 0);
+			if(Data == MAP_FAILED)
+				return;
+			Data_ = Data;
+			Size_ = static_cast<size_t>(FileStat.st_size);
+#endif
+		}
+
+		~FMappedFile()
+		{
+#if defined(_WIN32)
+			if(Data_ != nullptr)
+				UnmapViewOfFile(Data_);
+			if(Mapping_ != nullptr)
+				CloseHandle(Mapping_);
+			if(File_ != INVALID_HANDLE_VALUE)
+				CloseHandle(File_);
+#else
+			if(Data_ != nullptr)
+				munmap(Data_, Size_);
+			if(File_ >= 0)
+				close(File_);
+#endif
+		}
+
+		FMappedFile(const FMappedFile&) = delete;
+		FMappedFile& operator=(const FMappedFile&) = delete;
+
+		const void* GetData() const { return Data_; }
+		size_t GetSize() const { return Size_; }
+
+	private:
+#if defined(_WIN32)
+		HANDLE File_ = INVALID_HANDLE_VALUE;
+		HANDLE Mapping_ = nullptr;
+#else
+		int File_ = -1;
+#endif
+		void* Data_ = nullptr;
+		size_t Size_ = 0;
+	};
+
+	void PrintUsage()
+	{
+		std::printf(
+			"Usage: DRReplay [options] <server.drcap> [client.drcap]\n"
+			"  --client-hz HZ          replayed client frame rate (60)\n"
+			"  --max-blend F[,F...]    blend factor clamps to score (1.2)\n"
+			"  --resend-tolerance U[,U...]  regenerate sends from the truth with this prediction error tolerance (off)\n"
+			"  --latency S             send delay when there is no client capture (0.05)\n");
+	}
+
+	std::vector<double> ParseList(const char* InValue)
+	{
+		std::vector<double> Values;
+		const char* Cursor = InValue;
+		while(*Cursor != '\0')
+		{
+			char* End = nullptr;
+			Values.push_back(std::strtod(Cursor, &End));
+			if(End == Cursor)
+				break;
+			Cursor = *End == ',' ? End + 1 : End;
+		}
+		return Values;
+	}
+}
+
+int main(int Argc, char** Argv)
+{
+	DRCore::Capture::FReplaySettings BaseSettings;
+	std::vector<double> MaxBlendFactors{ BaseSettings.MaxBlendFactor };
+	std::vector<double> ResendTolerances{ 0.0 };
+	std::vector<std::string> Files;
+
+	for(int i = 1; i < Argc; ++i)
+	{
+		const std::string Arg = Argv[i];
+		const bool bHasValue = i + 1 < Argc;
+		if(Arg == "--help" || Arg == "-h")
+		{
+			PrintUsage();
+			return 0;
+		}
+		else if(Arg == "--client-hz" && bHasValue) BaseSettings.ClientDt = 1.0 / std::max(1.0, std::atof(Argv[++i]));
+		else if(Arg == "--max-blend" && bHasValue) MaxBlendFactors = ParseList(Argv[++i]);
+		else if(Arg == "--resend-tolerance" && bHasValue) ResendTolerances = ParseList(Argv[++i]);
+		else if(Arg == "--latency" && bHasValue) BaseSettings.Latency = std::atof(Argv[++i]);
+		else if(Arg.rfind("--", 0) == 0)
+		{
+			std::fprintf(stderr, "Unknown option %s\n", Arg.c_str());
+			PrintUsage();
+			return 1;
+		}
+		else Files.push_back(Arg);
+	}
+
+	if(Files.empty() || Files.size() > 2 || MaxBlendFactors.empty() || ResendTolerances.empty())
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	const FMappedFile ServerFile(Files[0]);
+	const DRCore::Capture::FCaptureView ServerView(ServerFile.GetData(), ServerFile.GetSize());
+	if(!ServerView.IsValid())
+	{
+		std::fprintf(stderr, "%s is not a capture file\n", Files[0].c_str());
+		return 1;
+	}
+
+	const std::unique_ptr<FMappedFile> ClientFile = Files.size() > 1 ? std::make_unique<FMappedFile>(Files[1]) : nullptr;
+	const DRCore::Capture::FCaptureView ClientView = ClientFile != nullptr ? DRCore::Capture::FCaptureView(ClientFile->GetData(), ClientFile->GetSize()) : DRCore::Capture::FCaptureView();
+	if(ClientFile != nullptr && !ClientView.IsValid())
+	{
+		std::fprintf(stderr, "%s is not a capture file\n", Files[1].c_str());
+		return 1;
+	}
+
+	std::printf("server records %zu, client records %zu\n", ServerView.Num(), ClientView.Num());
+	std::printf("%10s %10s %10s %10s %10s %12s %10s\n", "max-blend", "resend", "updates/s", "rms", "max", "frames", "wall s");
+	for(double ResendTolerance : ResendTolerances)
+	{
+		for(double MaxBlendFactor : MaxBlendFactors)
+		{
+			DRCore::Capture::FReplaySettings Settings = BaseSettings;
+			Settings.MaxBlendFactor = static_cast<float>(MaxBlendFactor);
+			Settings.ResendTolerance = ResendTolerance;
+
+			const auto WallStart = std::chrono::steady_clock::now();
+			const DRCore::Capture::FReplayResult Result = DRCore::Capture::Replay(ServerView, ClientFile != nullptr ? &ClientView : nullptr, Settings);
+			const double WallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - WallStart).count();
+
+			std::printf("%10.2f %10s %10.2f %10.3f %10.3f %12lld %10.3f\n", MaxBlendFactor,
+				ResendTolerance > 0.0 ? std::to_string(ResendTolerance).substr(0, 6).c_str() : "recorded",
+				Result.GetUpdatesPerSecond(), Result.GetRmsError(), Result.MaxError, Result.Frames, WallSeconds);
+		}
+	}
+
+	return 0;
+}